@@ -0,0 +1,269 @@
+/*******************************************************************************************
+*
+*   cgameoflife bench - Headless engine benchmark on libgol
+*
+*   Runs every engine on the same random soup and prints generations and cell updates per
+*   second, then times the random fill and steps a batch of small soups together. No window
+*   or GL context is needed.
+*
+*   Usage: bench [rows] [cols] [generations] [threads] [tiles] [halo]
+*
+*       threads     Threads used by the parallel engines, 0 (default) uses every core
+*       tiles       Also step the board on worker processes split as "RxC", e.g. "2x2"
+*       halo        Halo width of the worker subdomains, 8 by default
+*
+********************************************************************************************/
+
+#include "gol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define BENCH_BATCH_SIZE 64             // Rows and columns of each batched universe
+#define BENCH_BATCH_UNIVERSES 4096
+#define BENCH_BATCH_REFILL 16           // Generations between refills of settled universes
+#define BENCH_MEMORY_SIZE 4096          // Smallest rows and columns of the memory bench, smaller grids stay on the heap
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static const char *engineNames[] = { "bitwise", "sparse", "generations", "larger than life", "isotropic" };
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static void BenchMemory(const uint8_t *soup, int rows, int cols, int generations);
+static void BenchCluster(Universe *universe, const uint8_t *soup, int generations, const char *tiles, int halo);
+static LifeClip LoadClusterCells(void *data, int row, int col, int rows, int cols);
+static void BenchBatch(int generations);
+static void BenchRandomFill(Universe *universe);
+static void FillBatchSoup(LifeBatch *batch, int universe, uint32_t *seed);
+
+//----------------------------------------------------------------------------------
+// Program main entry point
+//----------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    int rows = (argc > 1)? atoi(argv[1]) : 2048;
+    int cols = (argc > 2)? atoi(argv[2]) : 2048;
+    int generations = (argc > 3)? atoi(argv[3]) : 200;
+    if (argc > 4) SetParallelWorkers(atoi(argv[4]));
+
+    uint8_t *soup = malloc((size_t)rows*cols);
+    Universe *universe = LoadUniverse(rows, cols, TOPOLOGY_TORUS);
+    if ((soup == NULL) || (universe == NULL) || (generations <= 0))
+    {
+        fprintf(stderr, "bench: unable to set up a %dx%d universe\n", rows, cols);
+        return 1;
+    }
+
+    // Fixed seed so every engine and every run starts from the same soup
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < (size_t)rows*cols; i++)
+    {
+        seed = seed*1664525u + 1013904223u;
+        soup[i] = (seed >> 28) < 5;
+    }
+
+    GridMemoryInfo memory = GetLifeGridMemoryInfo(GetUniverseGrid(universe));
+    printf("bench: %dx%d torus, %d generations, %d threads\n", rows, cols, generations, GetParallelWorkers());
+    printf("memory: %s, %zu KiB pages, first touch by %d threads, %d NUMA nodes\n", GetGridMemoryName(memory.memory),
+        memory.pageBytes/1024, memory.threads, memory.numaNodes);
+    for (int engine = ENGINE_BITWISE; engine <= ENGINE_ISOTROPIC; engine++)
+    {
+        ClearUniverse(universe);
+        if (!SetUniverseEngine(universe, (LifeEngine)engine, NULL))
+        {
+            printf("%-18s unable to load\n", engineNames[engine]);
+            continue;
+        }
+        SetUniverseRegion(universe, 0, 0, rows, cols, soup);
+
+        StepUniverse(universe, generations);
+        UniverseStats stats = GetUniverseStats(universe);
+        double seconds = (stats.stepSeconds > 0.0)? stats.stepSeconds : 1e-9;
+        printf("%-18s %10.1f gen/s %12.3f Gcell/s  population %lld\n", engineNames[engine], generations/seconds,
+            (double)rows*cols*generations/seconds/1e9, (long long)stats.population);
+    }
+
+    BenchRandomFill(universe);
+    BenchMemory(soup, rows, cols, generations);
+    BenchBatch(generations);
+    if (argc > 5) BenchCluster(universe, soup, generations, argv[5], (argc > 6)? atoi(argv[6]) : 8);
+
+    UnloadUniverse(universe);
+    CloseParallelWorkers();
+    free(soup);
+
+    return 0;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Counter based random fill of the whole board at a few densities
+static void BenchRandomFill(Universe *universe)
+{
+    const double densities[] = { 0.5, 0.375, 0.3, 0.01 };
+    LifeGrid grid = GetUniverseGrid(universe);
+
+    SetUniverseEngine(universe, ENGINE_BITWISE, NULL);
+    for (int i = 0; i < (int)(sizeof(densities)/sizeof(densities[0])); i++)
+    {
+        double start = GetLifeSeconds();
+        RandomizeUniverseRegion(universe, 0, 0, grid.rows, grid.cols, densities[i], 1);
+        double seconds = GetLifeSeconds() - start;
+        printf("%-18s %10.2f ms %12.3f Gcell/s  density %.3f\n", "random fill", seconds*1000.0,
+            (double)grid.rows*grid.cols/((seconds > 0.0)? seconds : 1e-9)/1e9, densities[i]);
+    }
+}
+
+// Bitwise engine on every kind of grid memory, kinds the system lacks fall back to smaller pages
+static void BenchMemory(const uint8_t *soup, int rows, int cols, int generations)
+{
+    // The soup is tiled over a board large enough to leave the heap
+    int memoryRows = (rows < BENCH_MEMORY_SIZE)? BENCH_MEMORY_SIZE : rows;
+    int memoryCols = (cols < BENCH_MEMORY_SIZE)? BENCH_MEMORY_SIZE : cols;
+    GridMemory preferred = GetLifeGridMemory();
+    printf("memory bench: %dx%d torus\n", memoryRows, memoryCols);
+
+    for (int kind = MEMORY_HEAP; kind <= MEMORY_HUGE_TLB; kind++)
+    {
+        SetLifeGridMemory((GridMemory)kind);
+        Universe *universe = LoadUniverse(memoryRows, memoryCols, TOPOLOGY_TORUS);
+        if (universe == NULL) continue;
+
+        for (int row = 0; row < memoryRows; row += rows)
+        {
+            for (int col = 0; col < memoryCols; col += cols) SetUniverseRegion(universe, row, col, rows, cols, soup);
+        }
+
+        StepUniverse(universe, generations);
+        UniverseStats stats = GetUniverseStats(universe);
+        GridMemoryInfo memory = GetLifeGridMemoryInfo(GetUniverseGrid(universe));
+        double seconds = (stats.stepSeconds > 0.0)? stats.stepSeconds : 1e-9;
+        printf("%-18s %10.1f gen/s %12.3f Gcell/s  %s, %zu KiB pages", "bitwise", generations/seconds,
+            (double)memoryRows*memoryCols*generations/seconds/1e9, GetGridMemoryName(memory.memory), memory.pageBytes/1024);
+        if (memory.memory != (GridMemory)kind) printf("  (fell back from %s)", GetGridMemoryName((GridMemory)kind));
+        printf("\n");
+
+        UnloadUniverse(universe);
+    }
+
+    SetLifeGridMemory(preferred);
+}
+
+// Step the soup on worker processes and check the result against the bitwise engine
+static void BenchCluster(Universe *universe, const uint8_t *soup, int generations, const char *tiles, int halo)
+{
+    ClusterSettings settings = { 0 };
+    settings.halo = halo;
+    settings.threads = 1;
+    if (sscanf(tiles, "%dx%d", &settings.tileRows, &settings.tileCols) != 2)
+    {
+        printf("cluster: tiles must be given as RxC, not \"%s\"\n", tiles);
+        return;
+    }
+
+    UniverseStats stats = GetUniverseStats(universe);
+    ClearUniverse(universe);
+    SetUniverseEngine(universe, ENGINE_BITWISE, NULL);
+    SetUniverseRegion(universe, 0, 0, stats.rows, stats.cols, soup);
+
+    LifeGrid board = GetUniverseGrid(universe);
+    LifeCluster *cluster = StartLifeCluster(settings, stats.rows, stats.cols, board.topology, LoadClusterCells, &board);
+    if (cluster == NULL)
+    {
+        printf("cluster: unable to start %s workers with halo %d\n", tiles, halo);
+        return;
+    }
+
+    bool stepped = StepLifeCluster(cluster, generations);
+    ClusterStats clusterStats = GetLifeClusterStats(cluster);
+    LifeGrid gathered = LoadLifeGrid(stats.rows, stats.cols, TOPOLOGY_TORUS);
+    if (stepped) stepped = (gathered.cells != NULL) && GatherLifeCluster(cluster, &gathered, 0, 0);
+    StopLifeCluster(cluster);
+
+    if (!stepped) printf("cluster: a worker failed\n");
+    else
+    {
+        StepUniverse(universe, generations);
+        LifeGrid expected = GetUniverseGrid(universe);
+        int64_t mismatches = 0;
+        for (int row = 0; row < stats.rows; row++)
+        {
+            for (int col = 0; col < stats.cols; col++) mismatches += GetLifeCell(expected, row, col) != GetLifeCell(gathered, row, col);
+        }
+
+        double seconds = (clusterStats.stepSeconds > 0.0)? clusterStats.stepSeconds : 1e-9;
+        printf("%-18s %10.1f gen/s %12.3f Gcell/s  population %lld  exchange %.1f%%  %s\n", "cluster", generations/seconds,
+            (double)stats.rows*stats.cols*generations/seconds/1e9, (long long)clusterStats.population,
+            100.0*clusterStats.exchangeSeconds/seconds, (mismatches == 0)? "matches bitwise" : "MISMATCH");
+        printf("%-18s %d workers, %s tiles, halo %d\n", "", clusterStats.workers, tiles, halo);
+    }
+
+    UnloadLifeGrid(gathered);
+}
+
+// Cluster workers copy their subdomain out of the bench grid, inherited when they were forked
+static LifeClip LoadClusterCells(void *data, int row, int col, int rows, int cols)
+{
+    return CopyLifeRegion(*(LifeGrid *)data, row, col, rows, cols);
+}
+
+// Many small dead edge soups stepped together, settled ones replaced by fresh soups as they retire
+static void BenchBatch(int generations)
+{
+    LifeBatch *batch = LoadLifeBatch(BENCH_BATCH_SIZE, BENCH_BATCH_SIZE, TOPOLOGY_DEAD_EDGE, BENCH_BATCH_UNIVERSES);
+    if (batch == NULL)
+    {
+        printf("batch: unable to load %d universes\n", BENCH_BATCH_UNIVERSES);
+        return;
+    }
+
+    uint32_t seed = 54321;
+    for (int u = 0; u < BENCH_BATCH_UNIVERSES; u++) FillBatchSoup(batch, u, &seed);
+
+    int64_t settled = 0;
+    double seconds = 0.0;
+    for (int done = 0; done < generations; done += BENCH_BATCH_REFILL)
+    {
+        int step = (generations - done < BENCH_BATCH_REFILL)? generations - done : BENCH_BATCH_REFILL;
+        StepLifeBatch(batch, step);
+        seconds += GetLifeBatchInfo(batch).stepSeconds;
+
+        for (int u = 0; u < BENCH_BATCH_UNIVERSES; u++)
+        {
+            if (!GetBatchUniverse(batch, u).stable) continue;
+
+            settled++;
+            FillBatchSoup(batch, u, &seed);
+        }
+    }
+
+    BatchInfo info = GetLifeBatchInfo(batch);
+    if (seconds <= 0.0) seconds = 1e-9;
+    printf("%-18s %10.1f gen/s %12.3f Gcell/s  %d universes of %dx%d, %lld settled and refilled\n", "batch", generations/seconds,
+        (double)info.rows*info.cols*info.universes*generations/seconds/1e9, info.universes, info.rows, info.cols, (long long)settled);
+
+    UnloadLifeBatch(batch);
+}
+
+// Random soup over the whole universe, same generator as the main soup
+static void FillBatchSoup(LifeBatch *batch, int universe, uint32_t *seed)
+{
+    ResetBatchUniverse(batch, universe);
+    for (int row = 0; row < BENCH_BATCH_SIZE; row++)
+    {
+        for (int col = 0; col < BENCH_BATCH_SIZE; col++)
+        {
+            *seed = *seed*1664525u + 1013904223u;
+            if ((*seed >> 28) < 5) SetBatchCell(batch, universe, row, col, true);
+        }
+    }
+}
+
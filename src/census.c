@@ -0,0 +1,75 @@
+/*******************************************************************************************
+*
+*   cgameoflife census - Headless random soup search on libgol
+*
+*   Runs seeded 16x16 soups to stabilization on every core and counts the objects they
+*   leave, printing soups per second per core as it goes. No window or GL context is needed.
+*
+*   Usage: census [soups] [seed] [threads] [file]
+*
+*       soups       Soups to run, 10000 by default
+*       seed        Soup n is the same for a seed on any machine and thread count, 1 by default
+*       threads     Threads to run soups on, 0 (default) uses every core
+*       file        Census written when done, "census.txt" by default
+*
+********************************************************************************************/
+
+#include "gol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define CENSUS_GENERATIONS 20000    // Soups still active after this many generations are listed as unstable
+#define CENSUS_BATCH_SOUPS 1000     // Soups between progress lines
+#define CENSUS_TOP_OBJECTS 10
+
+//----------------------------------------------------------------------------------
+// Program main entry point
+//----------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    long long soups = (argc > 1)? atoll(argv[1]) : 10000;
+    uint64_t seed = (argc > 2)? strtoull(argv[2], NULL, 0) : 1;
+    if (argc > 3) SetParallelWorkers(atoi(argv[3]));
+    const char *fileName = (argc > 4)? argv[4] : "census.txt";
+
+    LifeCensus *census = LoadLifeCensus(seed, CENSUS_GENERATIONS);
+    if ((census == NULL) || (soups <= 0))
+    {
+        fprintf(stderr, "census: unable to set up a census of %lld soups\n", soups);
+        return 1;
+    }
+
+    printf("census: %lld soups, seed %llu, %d threads\n", soups, (unsigned long long)seed, GetParallelWorkers());
+    for (long long done = 0; done < soups;)
+    {
+        int batch = (soups - done < CENSUS_BATCH_SOUPS)? (int)(soups - done) : CENSUS_BATCH_SOUPS;
+        if (!RunLifeCensus(census, batch))
+        {
+            fprintf(stderr, "census: out of memory after %lld soups\n", done);
+            break;
+        }
+        done += batch;
+
+        CensusStats stats = GetLifeCensusStats(census);
+        printf("%10lld soups %10.1f soups/s/core  %lld objects, %d kinds, %lld unstable\n", (long long)stats.soups,
+            stats.soupsPerCore, (long long)stats.objects, stats.codes, (long long)stats.unstable);
+        fflush(stdout);
+    }
+
+    CensusObject objects[CENSUS_TOP_OBJECTS];
+    int count = GetLifeCensusObjects(census, objects, CENSUS_TOP_OBJECTS);
+    for (int i = 0; i < count; i++) printf("%-24s %12lld\n", objects[i].code, (long long)objects[i].count);
+
+    bool saved = SaveLifeCensus(census, fileName);
+    if (saved) printf("census: written to %s\n", fileName);
+    else fprintf(stderr, "census: unable to write %s\n", fileName);
+
+    UnloadLifeCensus(census);
+    CloseParallelWorkers();
+
+    return saved? 0 : 1;
+}
@@ -14,6 +14,7 @@
 
 #include "raylib.h"
 #include "screens.h" // NOTE: Declares global (extern) variables and screens functions
+#include "life.h"
 
 #if defined(PLATFORM_WEB)
 #include <emscripten/emscripten.h>
@@ -120,6 +121,8 @@ int main(void)
 
     CloseAudioDevice(); // Close audio context
 
+    CloseParallelWorkers(); // Join simulation worker threads
+
     CloseWindow(); // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
 
@@ -326,6 +329,22 @@ static void UpdateDrawFrame(void)
         UpdateTransition(); // Update transition (fade-in, fade-out)
     //----------------------------------------------------------------------------------
 
+#if !defined(PLATFORM_WEB)
+    // Idle mode: while the game is paused block on input events instead of polling at full frame rate,
+    // and keep the last frame on screen when nothing changed. Playing switches back immediately
+    bool idle = !onTransition && (currentScreen == GAMEPLAY) && IsGameplayScreenPaused();
+    if (idle)
+        EnableEventWaiting();
+    else
+        DisableEventWaiting();
+
+    if (idle && !IsGameplayScreenDirty())
+    {
+        PollInputEvents(); // NOTE: Waits for the next event, EndDrawing() would do it after presenting
+        return;
+    }
+#endif
+
     // Draw
     //----------------------------------------------------------------------------------
     BeginDrawing();
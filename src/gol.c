@@ -0,0 +1,643 @@
+/**********************************************************************************************
+*
+*   libgol - Game of Life universes
+*
+*   Ties a grid to the selected engine: cell edits are routed to the engine holding the
+*   authoritative state, and engine switches carry the live cells over.
+*
+*   The grid GetUniverseGrid() returns tracks the words every step and edit changes, until the
+*   front end clears them once all its readers have caught up.
+*
+*   A universe with a journal attached appends every change made through this API to it,
+*   and a journal replays into a fresh universe with the time each frame took.
+*
+**********************************************************************************************/
+
+#include "gol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+struct Universe {
+    LifeEngine engine;
+    LifeGrid grid;                  // Live cells, authoritative for every engine but Generations
+    SparseLife sparse;
+    GenerationsLife generations;    // Holds every state while the Generations engine runs
+    LargerLife larger;
+    HenselRule isotropic;
+    int64_t generation;
+    double stepSeconds;
+    char *rule;                     // Rule of the selected engine, NULL for the default one
+    LifeJournal *journal;           // Changes are appended here when not NULL
+};
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static const char *defaultRules[] = { NULL, NULL, "B2/S/C3", "R5,C0,M1,S34..58,B34..45,NM", "B3/S23" };
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static bool ParseEngineRule(LifeEngine engine, const char *rule, GenerationsRule *generations, LargerRule *larger, HenselRule *isotropic);
+static void UnloadEngineState(Universe *universe);
+static void SetCellState(Universe *universe, int row, int col, int state);
+static uint64_t *CopySparseRows(const Universe *universe, int row, int height);
+static void UpdateSparseRegion(Universe *universe, uint64_t *before, int row, int height);
+static void DropSparseLife(Universe *universe);
+static void PasteGenerationsClip(Universe *universe, LifeClip clip, int row, int col, ClipBlend blend);
+static void RecordEvent(Universe *universe, JournalEvent event);
+static void ApplyJournalEvent(Universe *universe, JournalEvent event);
+static int CompareSeconds(const void *a, const void *b);
+
+//----------------------------------------------------------------------------------
+// Universe Functions Definition
+//----------------------------------------------------------------------------------
+
+// Allocate a dead universe running B3/S23 on the bitwise engine
+Universe *LoadUniverse(int rows, int cols, GridTopology topology)
+{
+    if ((rows <= 0) || (cols <= 0)) return NULL;
+
+    Universe *universe = calloc(1, sizeof(Universe));
+    if (universe == NULL) return NULL;
+
+    universe->engine = ENGINE_BITWISE;
+    universe->grid = LoadLifeGrid(rows, cols, topology);
+    if ((universe->grid.cells == NULL) || !TrackLifeChanges(&universe->grid))
+    {
+        UnloadLifeGrid(universe->grid);
+        free(universe);
+        return NULL;
+    }
+
+    return universe;
+}
+
+void UnloadUniverse(Universe *universe)
+{
+    if (universe == NULL) return;
+
+    UnloadEngineState(universe);
+    UnloadLifeGrid(universe->grid);
+    free(universe->rule);
+    free(universe);
+}
+
+// Switch engine and rule, live cells carry over and dying states are dropped
+// NOTE: Returns false and keeps the current engine when the rule does not parse,
+// falls back to the bitwise engine when the new engine can not allocate its state
+bool SetUniverseEngine(Universe *universe, LifeEngine engine, const char *rule)
+{
+    JournalEvent event = { .type = JOURNAL_ENGINE, .value = engine, .payloadSize = (rule != NULL)? (int)strlen(rule) : 0, .payload = rule };
+    RecordEvent(universe, event);
+    if ((engine < ENGINE_BITWISE) || (engine > ENGINE_ISOTROPIC)) return false;
+
+    char *ruleCopy = (rule != NULL)? malloc(strlen(rule) + 1) : NULL;
+    if (ruleCopy != NULL) strcpy(ruleCopy, rule);
+    if (rule == NULL) rule = defaultRules[engine];
+
+    GenerationsRule generationsRule = { 0 };
+    LargerRule largerRule = { 0 };
+    HenselRule isotropicRule = { 0 };
+    if (!ParseEngineRule(engine, rule, &generationsRule, &largerRule, &isotropicRule))
+    {
+        free(ruleCopy);
+        return false;
+    }
+
+    UnloadEngineState(universe);
+    universe->engine = engine;
+    free(universe->rule);
+    universe->rule = ruleCopy;
+
+    bool loaded = true;
+    switch (engine)
+    {
+        case ENGINE_SPARSE:
+            universe->sparse = LoadSparseLife(&universe->grid);
+            loaded = universe->sparse.counts != NULL;
+            break;
+        case ENGINE_GENERATIONS:
+            universe->generations = LoadGenerationsLife(universe->grid, generationsRule);
+            loaded = (universe->generations.planes[0] != NULL) && TrackLifeChanges(&universe->generations.alive);
+            break;
+        case ENGINE_LARGER:
+            universe->larger = LoadLargerLife(universe->grid, largerRule);
+            loaded = universe->larger.padded != NULL;
+            break;
+        case ENGINE_ISOTROPIC:
+            universe->isotropic = isotropicRule;
+            break;
+        case ENGINE_BITWISE:
+        default:
+            break;
+    }
+    if (!loaded)
+    {
+        UnloadEngineState(universe);
+        universe->engine = ENGINE_BITWISE;
+    }
+
+    // Readers of the changed words see the cells of another grid now
+    LifeGrid *grid = (universe->engine == ENGINE_GENERATIONS)? &universe->generations.alive : &universe->grid;
+    MarkLifeChanges(grid, 0, 0, grid->rows, grid->cols);
+
+    return loaded;
+}
+
+// Whether engine accepts rule, NULL standing for its default rule
+bool IsUniverseRuleValid(LifeEngine engine, const char *rule)
+{
+    if ((engine < ENGINE_BITWISE) || (engine > ENGINE_ISOTROPIC)) return false;
+    if (rule == NULL) rule = defaultRules[engine];
+
+    GenerationsRule generationsRule = { 0 };
+    LargerRule largerRule = { 0 };
+    HenselRule isotropicRule = { 0 };
+    return ParseEngineRule(engine, rule, &generationsRule, &largerRule, &isotropicRule);
+}
+
+void SetUniverseTopology(Universe *universe, GridTopology topology)
+{
+    RecordEvent(universe, (JournalEvent){ .type = JOURNAL_TOPOLOGY, .value = topology });
+    universe->grid.topology = topology;
+    universe->generations.alive.topology = topology;
+}
+
+void ClearUniverse(Universe *universe)
+{
+    RecordEvent(universe, (JournalEvent){ .type = JOURNAL_CLEAR });
+    if (universe->engine == ENGINE_GENERATIONS)
+    {
+        GenerationsLife *life = &universe->generations;
+        for (int k = 0; k < life->planeCount; k++) memset(life->planes[k], 0, (size_t)life->rows*life->stride*sizeof(uint64_t));
+        ClearLifeGrid(&life->alive);
+        return;
+    }
+
+    uint64_t *before = CopySparseRows(universe, 0, universe->grid.rows);
+    ClearLifeGrid(&universe->grid);
+    UpdateSparseRegion(universe, before, 0, universe->grid.rows);
+}
+
+// State of one cell, 0 outside the universe
+int GetUniverseCell(const Universe *universe, int row, int col)
+{
+    if ((row < 0) || (col < 0) || (row >= universe->grid.rows) || (col >= universe->grid.cols)) return 0;
+
+    if (universe->engine == ENGINE_GENERATIONS) return GetGenerationsCell(universe->generations, row, col);
+    return GetLifeCell(universe->grid, row, col);
+}
+
+// Set one cell, states past the rule are clamped and cells outside the universe ignored
+void SetUniverseCell(Universe *universe, int row, int col, int state)
+{
+    RecordEvent(universe, (JournalEvent){ .type = JOURNAL_CELL, .row = row, .col = col, .value = state });
+    SetCellState(universe, row, col, state);
+}
+
+// Load a block of states with its top left corner at (row, col), clipped to the universe
+void SetUniverseRegion(Universe *universe, int row, int col, int height, int width, const uint8_t *states)
+{
+    JournalEvent event = { .type = JOURNAL_REGION, .row = row, .col = col, .height = height, .width = width, .payloadSize = height*width, .payload = states };
+    RecordEvent(universe, event);
+
+    // Sparse counts are cheaper to update once from the changed words than per cell
+    bool updateSparse = (universe->engine == ENGINE_SPARSE);
+    uint64_t *before = CopySparseRows(universe, row, height);
+    if (updateSparse) universe->engine = ENGINE_BITWISE;
+
+    for (int i = 0; i < height; i++)
+    {
+        for (int j = 0; j < width; j++) SetCellState(universe, row + i, col + j, states[(size_t)i*width + j]);
+    }
+
+    if (updateSparse)
+    {
+        universe->engine = ENGINE_SPARSE;
+        UpdateSparseRegion(universe, before, row, height);
+    }
+}
+
+// Advance generations with the selected engine
+void StepUniverse(Universe *universe, int generations)
+{
+    RecordEvent(universe, (JournalEvent){ .type = JOURNAL_STEP, .value = generations });
+
+    double start = GetLifeSeconds();
+    for (int i = 0; i < generations; i++)
+    {
+        switch (universe->engine)
+        {
+            case ENGINE_SPARSE:
+            {
+                if (StepSparseLife(&universe->sparse, &universe->grid) >= 0) break;
+
+                // Out of memory, the grid is untouched and the bitwise engine steps it from here on
+                DropSparseLife(universe);
+                StepLifeGrid(&universe->grid);
+            } break;
+            case ENGINE_GENERATIONS:
+                StepGenerationsLife(&universe->generations);
+                break;
+            case ENGINE_LARGER:
+                StepLargerLife(&universe->larger, &universe->grid);
+                break;
+            case ENGINE_ISOTROPIC:
+                StepHenselLife(&universe->isotropic, &universe->grid);
+                break;
+            case ENGINE_BITWISE:
+            default:
+                StepLifeGrid(&universe->grid);
+                break;
+        }
+    }
+    if (generations > 0) universe->generation += generations;
+    universe->stepSeconds = GetLifeSeconds() - start;
+}
+
+UniverseStats GetUniverseStats(const Universe *universe)
+{
+    UniverseStats stats = { 0 };
+    LifeGrid grid = GetUniverseGrid(universe);
+    uint64_t lastMask = (grid.cols%64 == 0)? ~0ULL : ((1ULL << (grid.cols%64)) - 1);
+    int words = (grid.cols + 63)/64;
+
+    stats.rows = grid.rows;
+    stats.cols = grid.cols;
+    stats.engine = universe->engine;
+    stats.states = (universe->engine == ENGINE_GENERATIONS)? universe->generations.rule.states : 2;
+    stats.generation = universe->generation;
+    stats.stepSeconds = universe->stepSeconds;
+    for (int row = 0; row < grid.rows; row++)
+    {
+        const uint64_t *cells = LIFE_ROW(grid, grid.cells, row) + 1;
+        for (int w = 0; w < words; w++)
+        {
+            stats.population += CountLifeBits((w == words - 1)? (cells[w] & lastMask) : cells[w]);
+        }
+    }
+
+    return stats;
+}
+
+// Forget the words marked as changed on the grid of GetUniverseGrid(), once all its readers caught up
+void ClearUniverseChanges(Universe *universe)
+{
+    ClearLifeChanges((universe->engine == ENGINE_GENERATIONS)? &universe->generations.alive : &universe->grid);
+}
+
+// Copy every cell state, rows*cols bytes in row-major order
+void GetUniverseStates(const Universe *universe, uint8_t *states)
+{
+    if (universe->engine == ENGINE_GENERATIONS) GetGenerationsStates(universe->generations, states);
+    else GetLifeStates(universe->grid, states);
+}
+
+// Grid holding the live cells of the selected engine, for readers of the bit-packed layout
+LifeGrid GetUniverseGrid(const Universe *universe)
+{
+    return (universe->engine == ENGINE_GENERATIONS)? universe->generations.alive : universe->grid;
+}
+
+// Live cells of a rectangle, off the universe ones dead
+LifeClip CopyUniverseRegion(const Universe *universe, int row, int col, int height, int width)
+{
+    return CopyLifeRegion(GetUniverseGrid(universe), row, col, height, width);
+}
+
+// Blit the cells of clip as whole words, the Generations engine takes them cell by cell
+void PasteUniverseClip(Universe *universe, LifeClip clip, int row, int col, ClipBlend blend)
+{
+    if (clip.cells == NULL) return;
+
+    JournalEvent event = { .type = JOURNAL_PASTE, .row = row, .col = col, .height = clip.rows, .width = clip.cols, .value = blend,
+        .payloadSize = (int)((size_t)clip.rows*clip.stride*sizeof(uint64_t)), .payload = clip.cells };
+    RecordEvent(universe, event);
+    if (universe->engine == ENGINE_GENERATIONS)
+    {
+        PasteGenerationsClip(universe, clip, row, col, blend);
+        return;
+    }
+
+    uint64_t *before = CopySparseRows(universe, row, clip.rows);
+    PasteLifeClip(&universe->grid, clip, row, col, blend);
+    UpdateSparseRegion(universe, before, row, clip.rows);
+}
+
+void FillUniverseRegion(Universe *universe, int row, int col, int height, int width, int state)
+{
+    RecordEvent(universe, (JournalEvent){ .type = JOURNAL_FILL, .row = row, .col = col, .height = height, .width = width, .value = state });
+    if (universe->engine == ENGINE_GENERATIONS)
+    {
+        for (int i = 0; i < height; i++)
+        {
+            for (int j = 0; j < width; j++) SetCellState(universe, row + i, col + j, state);
+        }
+        return;
+    }
+
+    uint64_t *before = CopySparseRows(universe, row, height);
+    FillLifeRegion(&universe->grid, row, col, height, width, state != 0);
+    UpdateSparseRegion(universe, before, row, height);
+}
+
+void RandomizeUniverseRegion(Universe *universe, int row, int col, int height, int width, double density, uint64_t seed)
+{
+    RecordEvent(universe, (JournalEvent){ .type = JOURNAL_RANDOM, .row = row, .col = col, .height = height, .width = width, .value = (int64_t)seed, .density = density });
+    if (universe->engine == ENGINE_GENERATIONS)
+    {
+        LifeClip noise = LoadLifeNoise(row, col, height, width, density, seed);
+        if (noise.cells != NULL) PasteGenerationsClip(universe, noise, row, col, CLIP_REPLACE);
+        UnloadLifeClip(noise);
+        return;
+    }
+
+    uint64_t *before = CopySparseRows(universe, row, height);
+    RandomizeLifeRegion(&universe->grid, row, col, height, width, density, seed);
+    UpdateSparseRegion(universe, before, row, height);
+}
+
+// Append every change from now on to journal, starting with the engine, topology and cells as they are
+// NOTE: NULL stops recording, the journal stays owned by the caller
+void SetUniverseJournal(Universe *universe, LifeJournal *journal)
+{
+    universe->journal = journal;
+    if (journal == NULL) return;
+
+    JournalEvent engine = { .type = JOURNAL_ENGINE, .value = universe->engine,
+        .payloadSize = (universe->rule != NULL)? (int)strlen(universe->rule) : 0, .payload = universe->rule };
+    RecordEvent(universe, engine);
+    RecordEvent(universe, (JournalEvent){ .type = JOURNAL_TOPOLOGY, .value = universe->grid.topology });
+
+    // Dying Generations states only survive as a full block of states, live cells travel as a packed clip
+    int rows = universe->grid.rows;
+    int cols = universe->grid.cols;
+    if (universe->engine == ENGINE_GENERATIONS)
+    {
+        uint8_t *states = malloc((size_t)rows*cols);
+        if (states != NULL)
+        {
+            GetUniverseStates(universe, states);
+            JournalEvent region = { .type = JOURNAL_REGION, .height = rows, .width = cols, .payloadSize = rows*cols, .payload = states };
+            RecordEvent(universe, region);
+        }
+        free(states);
+    }
+    else
+    {
+        LifeClip clip = CopyUniverseRegion(universe, 0, 0, rows, cols);
+        if (clip.cells != NULL)
+        {
+            JournalEvent paste = { .type = JOURNAL_PASTE, .height = rows, .width = cols, .value = CLIP_REPLACE,
+                .payloadSize = (int)((size_t)rows*clip.stride*sizeof(uint64_t)), .payload = clip.cells };
+            RecordEvent(universe, paste);
+        }
+        UnloadLifeClip(clip);
+    }
+}
+
+// Note a front end input in the journal, such as a key that pauses or changes speed
+void RecordUniverseInput(Universe *universe, int64_t input)
+{
+    RecordEvent(universe, (JournalEvent){ .type = JOURNAL_INPUT, .value = input });
+}
+
+// Replay a journal into a fresh universe, timing every event and the frames they were recorded on
+JournalReplay ReplayUniverseJournal(const LifeJournal *journal)
+{
+    JournalReplay replay = { 0 };
+    JournalInfo info = GetLifeJournalInfo(journal);
+    Universe *universe = LoadUniverse(info.rows, info.cols, info.topology);
+    double *frameSeconds = malloc(((info.events > 0)? info.events : 1)*sizeof(double));
+    if ((universe == NULL) || (frameSeconds == NULL))
+    {
+        UnloadUniverse(universe);
+        free(frameSeconds);
+        return replay;
+    }
+
+    JournalEvent event = { 0 };
+    size_t offset = 0;
+    int frames = 0;
+    double start = GetLifeSeconds();
+    while (NextLifeJournalEvent(journal, &offset, &event))
+    {
+        double eventStart = GetLifeSeconds();
+        ApplyJournalEvent(universe, event);
+        double seconds = GetLifeSeconds() - eventStart;
+
+        if ((frames == 0) || (event.frame != replay.lastFrame)) frameSeconds[frames++] = 0.0;
+        frameSeconds[frames - 1] += seconds;
+        replay.lastFrame = event.frame;
+        replay.events++;
+        if (event.type == JOURNAL_INPUT) replay.inputs++;
+        if (event.type == JOURNAL_STEP)
+        {
+            replay.generations += (event.value > 0)? event.value : 0;
+            replay.stepSeconds += seconds;
+        }
+    }
+    replay.seconds = GetLifeSeconds() - start;
+    replay.replayed = (offset == info.bytes);
+    replay.population = GetUniverseStats(universe).population;
+
+    // Frame times sorted for the percentiles
+    replay.frames = frames;
+    if (frames > 0)
+    {
+        qsort(frameSeconds, frames, sizeof(double), CompareSeconds);
+        double total = 0.0;
+        for (int i = 0; i < frames; i++) total += frameSeconds[i];
+        replay.frameMean = total/frames;
+        replay.frameMedian = frameSeconds[frames/2];
+        replay.frameP99 = frameSeconds[(int)(0.99*(frames - 1))];
+        replay.frameMax = frameSeconds[frames - 1];
+    }
+
+    free(frameSeconds);
+    UnloadUniverse(universe);
+    return replay;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+// Parse rule into the structure of engine, the plain birth/survival engines take no rule
+static bool ParseEngineRule(LifeEngine engine, const char *rule, GenerationsRule *generations, LargerRule *larger, HenselRule *isotropic)
+{
+    if (engine == ENGINE_GENERATIONS) return ParseGenerationsRule(rule, generations);
+    if (engine == ENGINE_LARGER) return ParseLargerRule(rule, larger);
+    if (engine == ENGINE_ISOTROPIC) return ParseHenselRule(rule, isotropic);
+    return true;
+}
+
+// Free the selected engine state, the grid keeps the live cells
+static void UnloadEngineState(Universe *universe)
+{
+    switch (universe->engine)
+    {
+        case ENGINE_SPARSE:
+            UnloadSparseLife(universe->sparse);
+            universe->sparse = (SparseLife){ 0 };
+            break;
+        case ENGINE_GENERATIONS:
+            if (universe->generations.planes[0] != NULL) StoreGenerationsLife(universe->generations, &universe->grid);
+            UnloadGenerationsLife(universe->generations);
+            universe->generations = (GenerationsLife){ 0 };
+            break;
+        case ENGINE_LARGER:
+            UnloadLargerLife(universe->larger);
+            universe->larger = (LargerLife){ 0 };
+            break;
+        default:
+            break;
+    }
+}
+
+// Set one cell without recording it, for the edits made of many cells
+static void SetCellState(Universe *universe, int row, int col, int state)
+{
+    if ((row < 0) || (col < 0) || (row >= universe->grid.rows) || (col >= universe->grid.cols)) return;
+
+    switch (universe->engine)
+    {
+        case ENGINE_GENERATIONS:
+        {
+            int states = universe->generations.rule.states;
+            SetGenerationsCell(&universe->generations, row, col, (state < 0)? 0 : (state >= states)? states - 1 : state);
+        } break;
+        case ENGINE_SPARSE:
+            if (SetSparseCell(&universe->sparse, &universe->grid, row, col, state != 0)) break;
+
+            DropSparseLife(universe);
+            SetLifeCell(&universe->grid, row, col, state != 0);
+            break;
+        default:
+            SetLifeCell(&universe->grid, row, col, state != 0);
+            break;
+    }
+}
+
+// Rows a bulk edit is about to change, kept for the sparse engine to count the flipped cells
+// NOTE: Returns NULL when the sparse engine is not selected or out of memory
+static uint64_t *CopySparseRows(const Universe *universe, int row, int height)
+{
+    if (universe->engine != ENGINE_SPARSE) return NULL;
+
+    int first = (row > 0)? row : 0;
+    int last = (row + height < universe->grid.rows)? row + height : universe->grid.rows;
+    if (last <= first) return NULL;
+
+    uint64_t *before = malloc((size_t)(last - first)*universe->grid.stride*sizeof(uint64_t));
+    if (before != NULL) memcpy(before, LIFE_ROW(universe->grid, universe->grid.cells, first), (size_t)(last - first)*universe->grid.stride*sizeof(uint64_t));
+    return before;
+}
+
+// Update the sparse counts after a bulk edit from the rows CopySparseRows() kept, and free them
+static void UpdateSparseRegion(Universe *universe, uint64_t *before, int row, int height)
+{
+    if (universe->engine == ENGINE_SPARSE)
+    {
+        int first = (row > 0)? row : 0;
+        int last = (row + height < universe->grid.rows)? row + height : universe->grid.rows;
+        if ((last > first) && ((before == NULL) || !UpdateSparseRows(&universe->sparse, &universe->grid, first, last - first, before))) DropSparseLife(universe);
+    }
+    free(before);
+}
+
+// Fall back to the bitwise engine when the sparse one runs out of memory, the grid holds every cell
+static void DropSparseLife(Universe *universe)
+{
+    UnloadSparseLife(universe->sparse);
+    universe->sparse = (SparseLife){ 0 };
+    universe->engine = ENGINE_BITWISE;
+}
+
+// Generations states live in bit planes, live clip cells become state 1 and erased ones state 0
+static void PasteGenerationsClip(Universe *universe, LifeClip clip, int row, int col, ClipBlend blend)
+{
+    for (int i = 0; i < clip.rows; i++)
+    {
+        const uint64_t *cells = clip.cells + (size_t)i*clip.stride;
+        for (int j = 0; j < clip.cols; j++)
+        {
+            bool alive = (cells[j/64] >> (j%64)) & 1;
+            if (!alive && (blend != CLIP_REPLACE)) continue;
+
+            int state = GetUniverseCell(universe, row + i, col + j);
+            if (blend == CLIP_REPLACE) state = alive;
+            else if (blend == CLIP_STAMP) state = 1;
+            else if (blend == CLIP_ERASE) state = 0;
+            else state = (state == 1)? 0 : 1;
+            SetCellState(universe, row + i, col + j, state);
+        }
+    }
+}
+
+// Append an event stamped with the current generation when a journal is attached
+static void RecordEvent(Universe *universe, JournalEvent event)
+{
+    if (universe->journal == NULL) return;
+
+    event.generation = universe->generation;
+    AppendLifeJournal(universe->journal, event);
+}
+
+// Redo one journal event, inputs leave the universe untouched
+static void ApplyJournalEvent(Universe *universe, JournalEvent event)
+{
+    switch (event.type)
+    {
+        case JOURNAL_STEP: StepUniverse(universe, (int)event.value); break;
+        case JOURNAL_CELL: SetUniverseCell(universe, event.row, event.col, (int)event.value); break;
+        case JOURNAL_REGION:
+        {
+            if ((int64_t)event.height*event.width != event.payloadSize) break;
+            SetUniverseRegion(universe, event.row, event.col, event.height, event.width, event.payload);
+        } break;
+        case JOURNAL_FILL: FillUniverseRegion(universe, event.row, event.col, event.height, event.width, (int)event.value); break;
+        case JOURNAL_RANDOM:
+            RandomizeUniverseRegion(universe, event.row, event.col, event.height, event.width, event.density, (uint64_t)event.value);
+            break;
+        case JOURNAL_PASTE:
+        {
+            // Payloads sit at any byte offset, the words are copied out before use
+            LifeClip clip = LoadLifeClip(event.height, event.width);
+            if ((clip.cells != NULL) && ((size_t)clip.rows*clip.stride*sizeof(uint64_t) == (size_t)event.payloadSize))
+            {
+                memcpy(clip.cells, event.payload, event.payloadSize);
+                PasteUniverseClip(universe, clip, event.row, event.col, (ClipBlend)event.value);
+            }
+            UnloadLifeClip(clip);
+        } break;
+        case JOURNAL_CLEAR: ClearUniverse(universe); break;
+        case JOURNAL_ENGINE:
+        {
+            char *rule = (event.payloadSize > 0)? malloc(event.payloadSize + 1) : NULL;
+            if (rule != NULL)
+            {
+                memcpy(rule, event.payload, event.payloadSize);
+                rule[event.payloadSize] = '\0';
+            }
+            if ((event.payloadSize == 0) || (rule != NULL)) SetUniverseEngine(universe, (LifeEngine)event.value, rule);
+            free(rule);
+        } break;
+        case JOURNAL_TOPOLOGY: SetUniverseTopology(universe, (GridTopology)event.value); break;
+        case JOURNAL_INPUT:
+        default: break;
+    }
+}
+
+static int CompareSeconds(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
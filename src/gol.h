@@ -0,0 +1,100 @@
+/**********************************************************************************************
+*
+*   libgol - Game of Life universes
+*
+*   Stable API over the simulation engines, usable without raylib or a GL context. A universe
+*   owns its cells and the state of the selected engine behind an opaque handle.
+*
+*   Build with "make libgol" for libgol.a and libgol.so. Cells are addressed by row and column
+*   from the top left corner. States are 0 for dead, 1 for alive and 2 and up for the dying
+*   states of Generations rules.
+*
+*   Example:
+*
+*       Universe *universe = LoadUniverse(512, 512, TOPOLOGY_TORUS);
+*       SetUniverseCell(universe, 10, 11, 1);
+*       StepUniverse(universe, 1000);
+*       UniverseStats stats = GetUniverseStats(universe);
+*       UnloadUniverse(universe);
+*
+**********************************************************************************************/
+
+#ifndef GOL_H
+#define GOL_H
+
+#include "life.h"
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum LifeEngine {
+    ENGINE_BITWISE = 0,     // B3/S23, 64 cells per word
+    ENGINE_SPARSE,          // B3/S23, only cells next to a change are evaluated
+    ENGINE_GENERATIONS,     // Multi-state rules, "B2/S345/C4"
+    ENGINE_LARGER,          // Larger than Life, "R5,C0,M1,S34..58,B34..45,NM"
+    ENGINE_ISOTROPIC        // Isotropic non-totalistic rules, "B3/S2-i34q"
+} LifeEngine;
+
+typedef struct Universe Universe;   // Cells and engine state, opaque
+
+typedef struct UniverseStats {
+    int rows;
+    int cols;
+    LifeEngine engine;
+    int states;             // Cell states of the rule, 2 for plain birth/survival rules
+    int64_t generation;     // Generations stepped since the universe was loaded
+    int64_t population;     // Live (state 1) cells
+    double stepSeconds;     // Wall time of the last StepUniverse() call
+} UniverseStats;
+
+// Timings of a journal replayed by ReplayUniverseJournal()
+typedef struct JournalReplay {
+    bool replayed;          // Every event decoded and ran, false when the universe could not be loaded
+    int events;
+    int inputs;             // Front end inputs, counted but not replayed
+    int frames;             // Recorded frames holding at least one event
+    int64_t lastFrame;
+    int64_t generations;    // Generations stepped
+    double seconds;         // Wall time of the whole replay
+    double stepSeconds;     // Part of seconds spent stepping, the rest went into edits
+    double frameMean;       // Wall time of the events of one frame
+    double frameMedian;
+    double frameP99;
+    double frameMax;
+    int64_t population;     // Live cells once done, the same on every replay of a journal
+} JournalReplay;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Universe Functions Declaration
+//----------------------------------------------------------------------------------
+Universe *LoadUniverse(int rows, int cols, GridTopology topology); // Dead universe on the bitwise engine, NULL on failure
+void UnloadUniverse(Universe *universe);
+bool SetUniverseEngine(Universe *universe, LifeEngine engine, const char *rule); // Switch engine and rule, NULL rule for the default
+bool IsUniverseRuleValid(LifeEngine engine, const char *rule);     // Whether the engine accepts the rule, NULL for the default
+void SetUniverseTopology(Universe *universe, GridTopology topology); // Takes effect on the next step
+void ClearUniverse(Universe *universe);
+int GetUniverseCell(const Universe *universe, int row, int col);
+void SetUniverseCell(Universe *universe, int row, int col, int state);
+void SetUniverseRegion(Universe *universe, int row, int col, int height, int width, const uint8_t *states); // Bulk load height*width states, row-major
+void StepUniverse(Universe *universe, int generations);          // Advance generations
+UniverseStats GetUniverseStats(const Universe *universe);
+void GetUniverseStates(const Universe *universe, uint8_t *states); // Snapshot of every state, rows*cols bytes row-major
+LifeGrid GetUniverseGrid(const Universe *universe);               // Live cells, bit-packed, valid until the next call changing the universe
+void ClearUniverseChanges(Universe *universe);                    // Forget the words GetUniverseGrid().changes marks as changed
+LifeClip CopyUniverseRegion(const Universe *universe, int row, int col, int height, int width); // Live cells of a rectangle, cells is NULL on failure
+void PasteUniverseClip(Universe *universe, LifeClip clip, int row, int col, ClipBlend blend); // Blit live cells, clipped to the universe
+void FillUniverseRegion(Universe *universe, int row, int col, int height, int width, int state); // Set every cell of a rectangle
+void RandomizeUniverseRegion(Universe *universe, int row, int col, int height, int width, double density, uint64_t seed); // Cells alive with probability density, same cells for a seed on any thread count
+void SetUniverseJournal(Universe *universe, LifeJournal *journal); // Record every change from the current cells on, NULL stops
+void RecordUniverseInput(Universe *universe, int64_t input);      // Note a front end input in the journal, cells are untouched
+JournalReplay ReplayUniverseJournal(const LifeJournal *journal);  // Run a journal headless on a fresh universe and time it
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GOL_H
@@ -0,0 +1,293 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Life grid
+*
+*   Bit-packed cell storage with a ghost border and generation stepping.
+*
+*   NOTE: The interior kernel works on 64 cells at a time with bit-sliced adders. It reads
+*   the ghost border like any other cell, so only the ghost refresh knows about topology.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define LIFE_PARALLEL_WORDS 16384   // Smaller grids step faster than the pool wakes up
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static void StepLifeBand(void *data, int begin, int end);
+static inline bool GetRowBit(const uint64_t *row, int col);
+static inline void SetRowBit(uint64_t *row, int col, bool alive);
+static void RefreshGhostDeadEdge(LifeGrid *grid);
+static void RefreshGhostTorus(LifeGrid *grid);
+static void RefreshGhostMirror(LifeGrid *grid);
+
+//----------------------------------------------------------------------------------
+// Life Grid Functions Definition
+//----------------------------------------------------------------------------------
+
+// Allocate a dead grid, cells is NULL on failure
+LifeGrid LoadLifeGrid(int rows, int cols, GridTopology topology)
+{
+    LifeGrid grid = { 0 };
+    grid.rows = rows;
+    grid.cols = cols;
+    grid.topology = topology;
+
+    // Left ghost word, cells plus right ghost bit, and one slack word the kernel reads past the end
+    grid.stride = (cols + 1 + 63)/64 + 2;
+
+    grid.cells = LoadGridBuffers(rows, grid.stride, &grid.memory);
+    if (grid.cells != NULL) grid.next = grid.cells + (size_t)(rows + 2)*grid.stride;
+    return grid;
+}
+
+void UnloadLifeGrid(LifeGrid grid)
+{
+    // Buffers swap every generation, the block starts at whichever comes first
+    UnloadGridBuffers((grid.cells < grid.next)? grid.cells : grid.next, grid.rows, grid.stride, grid.memory);
+    free(grid.changes);
+}
+
+void ClearLifeGrid(LifeGrid *grid)
+{
+    size_t words = (size_t)(grid->rows + 2)*grid->stride;
+    memset(grid->cells, 0, words*sizeof(uint64_t));
+    memset(grid->next, 0, words*sizeof(uint64_t));
+    MarkLifeChanges(grid, 0, 0, grid->rows, grid->cols);
+}
+
+bool GetLifeCell(LifeGrid grid, int row, int col)
+{
+    return GetRowBit(LIFE_ROW(grid, grid.cells, row), col);
+}
+
+void SetLifeCell(LifeGrid *grid, int row, int col, bool alive)
+{
+    SetRowBit(LIFE_ROW(*grid, grid->cells, row), col, alive);
+    if (grid->changes != NULL) MarkLifeChanges(grid, row, col, 1, 1);
+}
+
+// Fill ghost border for grid topology
+// NOTE: Only touches the border ring, O(rows + cols) per generation
+void RefreshGhostCells(LifeGrid *grid)
+{
+    switch (grid->topology)
+    {
+        case TOPOLOGY_TORUS: RefreshGhostTorus(grid); break;
+        case TOPOLOGY_MIRROR: RefreshGhostMirror(grid); break;
+        case TOPOLOGY_DEAD_EDGE:
+        default: RefreshGhostDeadEdge(grid); break;
+    }
+}
+
+// Advance one generation (B3/S23)
+void StepLifeGrid(LifeGrid *grid)
+{
+    RefreshGhostCells(grid);
+
+    // Row bands match the bands grid memory was first touched by
+    if ((size_t)grid->rows*grid->stride < LIFE_PARALLEL_WORDS) StepLifeRows(grid, 0, grid->rows);
+    else ParallelFor(grid->rows, StepLifeBand, grid);
+
+    uint64_t *swap = grid->cells;
+    grid->cells = grid->next;
+    grid->next = swap;
+}
+
+// Write rows [begin, end) of the next generation into grid->next
+// NOTE: Ghost cells are used as they are, callers stepping tiles fill them from the neighbours
+void StepLifeRows(LifeGrid *grid, int begin, int end)
+{
+    int lastWord = 1 + (grid->cols - 1)/64;
+    uint64_t lastMask = (grid->cols%64 == 0)? ~0ULL : ((1ULL << (grid->cols%64)) - 1);
+
+    for (int row = begin; row < end; row++)
+    {
+        const uint64_t *above = LIFE_ROW(*grid, grid->cells, row - 1);
+        const uint64_t *center = LIFE_ROW(*grid, grid->cells, row);
+        const uint64_t *below = LIFE_ROW(*grid, grid->cells, row + 1);
+        uint64_t *out = LIFE_ROW(*grid, grid->next, row);
+
+        for (int w = 1; w <= lastWord; w++)
+        {
+            // Neighbours to the west and east of every bit, pulling carries from adjacent words
+            uint64_t aW = (above[w] << 1) | (above[w - 1] >> 63);
+            uint64_t aE = (above[w] >> 1) | (above[w + 1] << 63);
+            uint64_t cW = (center[w] << 1) | (center[w - 1] >> 63);
+            uint64_t cE = (center[w] >> 1) | (center[w + 1] << 63);
+            uint64_t bW = (below[w] << 1) | (below[w - 1] >> 63);
+            uint64_t bE = (below[w] >> 1) | (below[w + 1] << 63);
+
+            // Row sums: above and below are 0..3, center (without self) is 0..2
+            uint64_t t = aW ^ above[w];
+            uint64_t a1 = t ^ aE;
+            uint64_t a2 = (aW & above[w]) | (t & aE);
+            t = bW ^ below[w];
+            uint64_t b1 = t ^ bE;
+            uint64_t b2 = (bW & below[w]) | (t & bE);
+            uint64_t c1 = cW ^ cE;
+            uint64_t c2 = cW & cE;
+
+            // Add the ones column, its carry joins the twos column
+            t = a1 ^ b1;
+            uint64_t s0 = t ^ c1;
+            uint64_t k1 = (a1 & b1) | (t & c1);
+
+            // Neighbour count is 2 or 3 exactly when the twos column sums to one
+            t = a2 ^ b2;
+            uint64_t t0 = t ^ c2;
+            uint64_t t1 = (a2 & b2) | (t & c2);
+            uint64_t twos = (t0 ^ k1) & ~t1;
+
+            out[w] = twos & (s0 | center[w]);
+        }
+
+        // Bits past the last column would otherwise leak into the right ghost cell
+        out[lastWord] &= lastMask;
+        if (grid->changes != NULL) MarkLifeRowChanges(grid, row, center, out);
+    }
+}
+
+// Expand cells into one byte per cell, row-major
+void GetLifeStates(LifeGrid grid, uint8_t *states)
+{
+    for (int row = 0; row < grid.rows; row++)
+    {
+        const uint64_t *cells = LIFE_ROW(grid, grid.cells, row);
+        for (int col = 0; col < grid.cols; col++) states[(size_t)row*grid.cols + col] = (cells[1 + col/64] >> (col%64)) & 1;
+    }
+}
+
+// Keep a bitmap of the words changed by steps and edits, for readers that only revisit changed parts
+// NOTE: Bits are only ever set, the owner of the grid clears them once every reader has seen them
+bool TrackLifeChanges(LifeGrid *grid)
+{
+    if (grid->changes == NULL) grid->changes = calloc((size_t)grid->rows*LIFE_CHANGE_STRIDE(*grid), sizeof(uint64_t));
+    return grid->changes != NULL;
+}
+
+// Mark every word holding a cell of the rectangle, clipped to the grid
+void MarkLifeChanges(LifeGrid *grid, int row, int col, int height, int width)
+{
+    if (grid->changes == NULL) return;
+
+    int top = (row > 0)? row : 0;
+    int bottom = (row + height < grid->rows)? row + height : grid->rows;
+    int left = (col > 0)? col : 0;
+    int right = (col + width < grid->cols)? col + width : grid->cols;
+    if ((top >= bottom) || (left >= right)) return;
+
+    int stride = LIFE_CHANGE_STRIDE(*grid);
+    for (int r = top; r < bottom; r++)
+    {
+        uint64_t *changes = grid->changes + (size_t)r*stride;
+        for (int w = left/64; w <= (right - 1)/64; w++) changes[w/64] |= 1ULL << (w%64);
+    }
+}
+
+// Mark the words of row that differ between two copies of it, both laid out like a grid row
+// NOTE: Only touches the bits of one row, so threads stepping different rows can mark at once
+void MarkLifeRowChanges(LifeGrid *grid, int row, const uint64_t *before, const uint64_t *after)
+{
+    if (grid->changes == NULL) return;
+
+    int words = (grid->cols + 63)/64;
+    uint64_t lastMask = (grid->cols%64 == 0)? ~0ULL : ((1ULL << (grid->cols%64)) - 1);
+    uint64_t *changes = grid->changes + (size_t)row*LIFE_CHANGE_STRIDE(*grid);
+
+    for (int w = 0; w < words; w++)
+    {
+        // The right ghost cell shares the last word and is not a change
+        uint64_t diff = before[1 + w] ^ after[1 + w];
+        if (w == words - 1) diff &= lastMask;
+        if (diff != 0) changes[w/64] |= 1ULL << (w%64);
+    }
+}
+
+void ClearLifeChanges(LifeGrid *grid)
+{
+    if (grid->changes != NULL) memset(grid->changes, 0, (size_t)grid->rows*LIFE_CHANGE_STRIDE(*grid)*sizeof(uint64_t));
+}
+
+// Monotonic wall clock in seconds, Windows has no clock_gettime() and reads the UTC clock instead
+double GetLifeSeconds(void)
+{
+    struct timespec now;
+#if defined(_WIN32)
+    timespec_get(&now, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#endif
+    return (double)now.tv_sec + now.tv_nsec/1e9;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+static void StepLifeBand(void *data, int begin, int end)
+{
+    StepLifeRows((LifeGrid *)data, begin, end);
+}
+
+// Column -1 is the top bit of the ghost word, column cols is the bit right after the last cell
+static inline bool GetRowBit(const uint64_t *row, int col)
+{
+    int bit = col + 64;
+    return (row[bit/64] >> (bit%64)) & 1;
+}
+
+static inline void SetRowBit(uint64_t *row, int col, bool alive)
+{
+    int bit = col + 64;
+    if (alive) row[bit/64] |= 1ULL << (bit%64);
+    else row[bit/64] &= ~(1ULL << (bit%64));
+}
+
+// NOTE: Ghost words of the buffer swapped in may still hold bits from an earlier refresh
+static void RefreshGhostDeadEdge(LifeGrid *grid)
+{
+    memset(LIFE_ROW(*grid, grid->cells, -1), 0, grid->stride*sizeof(uint64_t));
+    memset(LIFE_ROW(*grid, grid->cells, grid->rows), 0, grid->stride*sizeof(uint64_t));
+    for (int row = 0; row < grid->rows; row++)
+    {
+        uint64_t *cells = LIFE_ROW(*grid, grid->cells, row);
+        SetRowBit(cells, -1, false);
+        SetRowBit(cells, grid->cols, false);
+    }
+}
+
+static void RefreshGhostTorus(LifeGrid *grid)
+{
+    for (int row = 0; row < grid->rows; row++)
+    {
+        uint64_t *cells = LIFE_ROW(*grid, grid->cells, row);
+        SetRowBit(cells, -1, GetRowBit(cells, grid->cols - 1));
+        SetRowBit(cells, grid->cols, GetRowBit(cells, 0));
+    }
+
+    // Whole rows are copied after the column ghosts so the corners wrap diagonally
+    memcpy(LIFE_ROW(*grid, grid->cells, -1), LIFE_ROW(*grid, grid->cells, grid->rows - 1), grid->stride*sizeof(uint64_t));
+    memcpy(LIFE_ROW(*grid, grid->cells, grid->rows), LIFE_ROW(*grid, grid->cells, 0), grid->stride*sizeof(uint64_t));
+}
+
+static void RefreshGhostMirror(LifeGrid *grid)
+{
+    for (int row = 0; row < grid->rows; row++)
+    {
+        uint64_t *cells = LIFE_ROW(*grid, grid->cells, row);
+        SetRowBit(cells, -1, GetRowBit(cells, 0));
+        SetRowBit(cells, grid->cols, GetRowBit(cells, grid->cols - 1));
+    }
+
+    memcpy(LIFE_ROW(*grid, grid->cells, -1), LIFE_ROW(*grid, grid->cells, 0), grid->stride*sizeof(uint64_t));
+    memcpy(LIFE_ROW(*grid, grid->cells, grid->rows), LIFE_ROW(*grid, grid->cells, grid->rows - 1), grid->stride*sizeof(uint64_t));
+}
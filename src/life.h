@@ -0,0 +1,621 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Life grid
+*
+*   Bit-packed cell storage with a ghost border and generation stepping.
+*
+*   Every row is stored as 64-bit words, one bit per cell. Word 0 of each row is a ghost word
+*   whose top bit holds the cell left of column 0, and the bit right after the last column
+*   holds the cell right of it. Row 0 and row (rows + 1) of the buffer are ghost rows.
+*   Ghost cells are refreshed once per generation for the selected topology, so the stepping
+*   kernel never has to check bounds.
+*
+*   A grid can also track which words changed since its owner last cleared them, one bit per
+*   word, so readers like the population pyramid only revisit the parts that moved.
+*
+**********************************************************************************************/
+
+#ifndef LIFE_H
+#define LIFE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define GENERATIONS_MAX_STATES 16   // Four bit planes
+#define GENERATIONS_MAX_PLANES 4
+#define LARGER_MAX_RADIUS 500
+#define PARALLEL_MAX_WORKERS 63     // Worker threads besides the calling thread
+#define PYRAMID_FIRST_LEVEL 3       // 8x8 blocks, smaller blocks are counted from the cells
+#define PYRAMID_TILE_LEVEL 6        // 64x64 tiles are the unit of change tracking
+#define PYRAMID_MAX_LEVELS 32
+#define LIFE_AGE_MAX 255            // Ages saturate at the largest byte
+#define SEARCH_MAX_PATTERN 62       // Rows and columns of a searched pattern, its dead ring fits one word
+
+// Words of grid row (-1 and rows are the ghost rows) inside one of its buffers
+#define LIFE_ROW(grid, buffer, row) ((buffer) + (size_t)((row) + 1)*(grid).stride)
+
+// Words of the change bitmap per grid row, one bit per word of visible cells
+#define LIFE_CHANGE_STRIDE(grid) (((grid).cols + 64*64 - 1)/(64*64))
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum GridTopology { TOPOLOGY_DEAD_EDGE = 0, TOPOLOGY_TORUS, TOPOLOGY_MIRROR } GridTopology;
+
+// Memory backing the cell buffers of a grid, from plain heap up to explicit huge pages
+typedef enum GridMemory {
+    MEMORY_HEAP = 0,        // calloc(), small grids
+    MEMORY_PAGES,           // Own mapping on base pages, first touched by row band
+    MEMORY_HUGE_PAGES,      // Own mapping marked for transparent huge pages, first touched by row band
+    MEMORY_HUGE_TLB         // Explicit huge pages from the hugetlb pool, first touched by row band
+} GridMemory;
+
+typedef struct LifeGrid {
+    int rows;               // Number of visible rows
+    int cols;               // Number of visible columns
+    int stride;             // 64-bit words per buffer row, ghost words included
+    GridTopology topology;  // How ghost cells are filled
+    uint64_t *cells;        // Current generation, (rows + 2)*stride words
+    uint64_t *next;         // Scratch buffer for the next generation
+    GridMemory memory;      // How cells and next were allocated, both share one block
+    uint64_t *changes;      // Words changed since ClearLifeChanges(), rows*LIFE_CHANGE_STRIDE words, NULL when not tracked
+} LifeGrid;
+
+typedef struct GridMemoryInfo {
+    GridMemory memory;
+    size_t pageBytes;       // Page size asked for the buffers
+    int threads;            // Threads the row bands were first touched by
+    int numaNodes;          // Memory nodes of the system, 1 when unknown
+} GridMemoryInfo;
+
+typedef struct SparseLife {
+    int rows;               // Number of rows of the tracked grid
+    int cols;               // Number of columns of the tracked grid
+    GridTopology topology;  // Topology the counts were built for
+    uint8_t *counts;        // Live neighbours of every cell
+    uint8_t *queued;        // Cell is already in the pending list
+    int64_t *pending;       // Cells to evaluate next generation, as row*cols + col
+    int64_t pendingCount;   // Number of pending cells
+    int64_t pendingCapacity; // Cells pending has room for, grows with the active cells
+    int64_t *flips;         // Scratch list of cells flipping this generation
+    int64_t flipCapacity;   // Cells flips has room for
+} SparseLife;
+
+// Multi-state rule, bit n of birth/survive is set when n live neighbours apply
+typedef struct GenerationsRule {
+    uint16_t birth;
+    uint16_t survive;
+    int states;             // Number of states C, 2 behaves like a plain B/S rule
+} GenerationsRule;
+
+typedef struct GenerationsLife {
+    int rows;
+    int cols;
+    int stride;                                 // Same word layout as LifeGrid rows
+    int planeCount;                             // Bit planes needed for rule.states
+    GenerationsRule rule;
+    LifeGrid alive;                             // State 1 cells with ghost border, drives neighbour counts
+    uint64_t *planes[GENERATIONS_MAX_PLANES];   // Plane k holds bit k of every cell state, rows*stride words
+    uint64_t *scratch[GENERATIONS_MAX_PLANES];  // Next generation planes
+} GenerationsLife;
+
+// Larger than Life rule, counts in [min, max] survive or are born
+typedef struct LargerRule {
+    int radius;
+    bool middle;            // Count includes the cell itself (M1)
+    bool vonNeumann;        // Diamond neighbourhood (NN) instead of square (NM)
+    int surviveMin;
+    int surviveMax;
+    int birthMin;
+    int birthMax;
+} LargerRule;
+
+typedef struct LargerLife {
+    LargerRule rule;
+    int halo;               // Padding around the grid, radius + 1
+    int width;              // Padded table width
+    int height;             // Padded table height
+    uint8_t *padded;        // Cells with a topology-filled halo
+    uint32_t *tableA;       // Summed-area table (Moore) or down-right diagonal prefix sums (von Neumann)
+    uint32_t *tableB;       // Down-left diagonal prefix sums, von Neumann only
+} LargerLife;
+
+// Isotropic non-totalistic rule compiled from Hensel notation, indexed by the 3x3 neighbourhood
+typedef struct HenselRule {
+    uint8_t table[512];
+} HenselRule;
+
+// Live cells per 2^k x 2^k block for every level k, the last level is a single block
+typedef struct LifePyramid {
+    int rows;
+    int cols;
+    int levels;                             // Number of levels, block side 2^k at level k
+    bool counted;                           // Every tile was counted once, later updates only recount changed tiles
+    uint32_t *counts[PYRAMID_MAX_LEVELS];   // Block counts from PYRAMID_FIRST_LEVEL up, row-major
+    uint8_t *dirty[PYRAMID_MAX_LEVELS];     // Blocks changed by the last update, from PYRAMID_TILE_LEVEL up
+} LifePyramid;
+
+// Generations each cell has kept its state, alive or dead, saturating at LIFE_AGE_MAX
+typedef struct LifeAges {
+    int rows;
+    int cols;
+    int stride;                             // Same word layout as LifeGrid rows
+    int ageStride;                          // Bytes per row of ages, 64 per word of cells
+    uint8_t *ages;                          // rows*ageStride ages, row-major
+    uint64_t *previous;                     // Cells seen by the last update, rows*stride words
+} LifeAges;
+
+// Changes recorded in a session journal, and what the fields of each one hold
+typedef enum JournalEventType {
+    JOURNAL_STEP = 0,       // value generations
+    JOURNAL_CELL,           // value state of the cell at (row, col)
+    JOURNAL_REGION,         // height*width states of the rectangle at (row, col) as payload, row-major
+    JOURNAL_FILL,           // value state of every cell of the rectangle
+    JOURNAL_RANDOM,         // value seed, density of the rectangle
+    JOURNAL_PASTE,          // value blend, a height x width clip at (row, col) as payload words
+    JOURNAL_CLEAR,
+    JOURNAL_ENGINE,         // value engine, rule text as payload, none for the default rule
+    JOURNAL_TOPOLOGY,       // value topology
+    JOURNAL_INPUT           // value front end input such as a key code, cells are untouched
+} JournalEventType;
+
+typedef struct JournalEvent {
+    JournalEventType type;
+    int64_t frame;          // Front end frame the event happened on
+    int64_t generation;     // Universe generation before the event
+    int row;
+    int col;
+    int height;
+    int width;
+    int64_t value;
+    double density;
+    int payloadSize;        // Bytes of payload
+    const void *payload;    // Copied when appended, points into the journal when decoded
+} JournalEvent;
+
+typedef struct LifeJournal LifeJournal; // Encoded events of a session
+
+typedef struct JournalInfo {
+    int rows;
+    int cols;
+    GridTopology topology;
+    int events;
+    int64_t frames;         // Frame of the last event
+    int64_t generations;    // Generation of the last event
+    size_t bytes;           // Encoded size of the events
+} JournalInfo;
+
+typedef enum ExportFormat { EXPORT_GIF = 0, EXPORT_PNG_SEQUENCE, EXPORT_Y4M } ExportFormat;
+
+typedef struct ExportSettings {
+    ExportFormat format;
+    const char *path;       // Output file, for PNG sequences a printf pattern taking the generation ("gen_%06d.png")
+    int every;              // Record one generation out of every
+    int scale;              // Pixels per cell side
+    int frameDelay;         // Time per frame in 1/100 s, GIF delay and Y4M frame rate
+    int queueFrames;        // Snapshots waiting for encoders before SubmitLifeExport() blocks
+    int workers;            // Encoder threads, 0 uses every online core
+} ExportSettings;
+
+typedef struct LifeExport LifeExport;   // Recording in progress, owns its encoder threads
+
+typedef struct LifeTrace LifeTrace;     // Trace being written, owns its I/O thread
+typedef struct LifeTraceReader LifeTraceReader;
+
+typedef struct TraceInfo {
+    int rows;
+    int cols;
+    int keyframeInterval;   // Generations between keyframes
+    int firstGeneration;
+    int lastGeneration;     // Last generation stored in a complete block
+} TraceInfo;
+
+typedef struct LifeShare LifeShare;     // Published shared memory segment, owned by the simulation
+typedef struct LifeShareReader LifeShareReader;
+
+typedef struct ShareInfo {
+    int rows;
+    int cols;
+    int words;              // Words per row, ghost words dropped
+    int frames;             // Generations kept in the ring
+    int latestGeneration;   // Generation published last, -1 before the first one
+} ShareInfo;
+
+typedef struct LifeServer LifeServer;   // Generation stream server, owns its network thread
+typedef struct LifeClient LifeClient;   // Viewer connection to a LifeServer
+
+typedef struct StreamInfo {
+    int rows;
+    int cols;
+    int generation;         // Generation of the last message, -1 before the first one
+    int keyframes;          // Keyframes received, more than one means deltas were skipped
+    int deltas;
+    int64_t bytes;          // Message bytes received
+} StreamInfo;
+
+typedef struct LifeMapped LifeMapped;   // Board stored in a tiled, memory-mapped file
+
+typedef struct MappedInfo {
+    int rows;
+    int cols;
+    GridTopology topology;
+    int tileSize;           // Tile side in cells, every tile is one contiguous block of the file
+    int tilesDown;
+    int tilesAcross;
+    int prefetchTiles;      // Tiles read ahead within the RAM budget
+    int64_t generation;
+    int64_t fileBytes;
+    double stepSeconds;     // Wall time of the last StepLifeMapped() call
+} MappedInfo;
+
+typedef struct LifeCluster LifeCluster; // Worker processes stepping one subdomain each
+
+typedef struct ClusterSettings {
+    int tileRows;           // Subdomains down the board
+    int tileCols;           // Subdomains across the board
+    int halo;               // Ghost cells around each subdomain, generations stepped between exchanges
+    int threads;            // ParallelFor() threads per worker process, 0 for one
+} ClusterSettings;
+
+typedef struct ClusterStats {
+    int workers;
+    int64_t generation;     // Generations stepped since the cluster started
+    int64_t population;
+    double stepSeconds;     // Wall time of the last StepLifeCluster() call
+    double exchangeSeconds; // Longest time a worker spent on halo exchange in that call
+} ClusterStats;
+
+typedef struct LifeCensus LifeCensus;   // Random soup search results, objects counted by apgcode
+
+typedef struct CensusStats {
+    uint64_t seed;          // Soup n is the same for a given seed whatever the thread count
+    int64_t soups;          // Soups run so far
+    int64_t objects;        // Objects classified
+    int64_t generations;    // Generations stepped over every soup
+    int64_t unstable;       // Soups still active at the generation limit
+    int64_t escaped;        // Cells removed at the board edge, mostly gliders flying off
+    int codes;              // Distinct apgcodes seen
+    int threads;            // Threads of the last run
+    double seconds;         // Wall time of every run
+    double soupsPerCore;    // Soups per second per thread
+} CensusStats;
+
+typedef struct CensusObject {
+    const char *code;       // apgcode, "xs4_33" for the block
+    int64_t count;
+    int64_t firstSoup;      // Lowest soup it came out of
+} CensusObject;
+
+typedef struct LifeBatch LifeBatch;     // Many boards of one size stepped together, 64 per word
+
+typedef struct BatchUniverse {
+    bool stable;            // Settled and retired, frozen until reset
+    int period;             // 1 for still lifes, 2 for period 2 oscillators, 0 while running
+    int64_t generations;    // Generations stepped since loaded or reset
+} BatchUniverse;
+
+typedef struct BatchInfo {
+    int rows;
+    int cols;
+    int universes;
+    int groups;             // Words per cell
+    int running;
+    int stable;
+    int64_t generation;     // Generations stepped by the batch
+    double stepSeconds;     // Wall time of the last StepLifeBatch() call
+} BatchInfo;
+
+// Cells that count as touching when objects are labelled
+typedef enum ObjectAdjacency { ADJACENCY_ORTHOGONAL = 0, ADJACENCY_MOORE } ObjectAdjacency;
+
+typedef struct LifeObjects LifeObjects; // Connected groups of live cells of the last labelled grid
+
+typedef struct LifeObject {
+    int top;                // Bounding box in board cells
+    int left;
+    int rows;
+    int cols;
+    int population;
+    bool wraps;             // Crosses a torus edge, the box then covers both sides
+    uint64_t hash;          // Same for every rotation and reflection of the shape, 0 when too large or wrapping
+    const char *name;       // Known still life, oscillator or spaceship, NULL otherwise
+} LifeObject;
+
+typedef struct ObjectsInfo {
+    int objects;
+    int known;              // Objects with a name
+    int64_t cells;
+    int64_t runs;           // Horizontal runs of live cells labelled
+    int threads;
+    double seconds;         // Wall time of the last labelling
+} ObjectsInfo;
+
+typedef struct LifeSearch LifeSearch;   // Pattern in every phase and orientation, with the matches of the last search
+
+typedef struct SearchMatch {
+    int row;                // Top left cell of the matched bounding box
+    int col;
+    int rows;
+    int cols;
+    int symmetry;           // Bit 0 flips rows, bit 1 flips columns, bit 2 then transposes
+    int phase;              // Generations the pattern was stepped
+} SearchMatch;
+
+typedef struct SearchInfo {
+    int variants;           // Distinct phases and orientations looked for
+    int matches;
+    int threads;
+    double seconds;         // Wall time of the last search
+} SearchInfo;
+
+// How PasteLifeClip() combines clip cells with the grid cells under them
+typedef enum ClipBlend {
+    CLIP_REPLACE = 0,       // Every clip cell, dead ones included, replaces the cell under it
+    CLIP_STAMP,             // Live clip cells are added
+    CLIP_ERASE,             // Live clip cells clear the cells under them
+    CLIP_XOR                // Live clip cells toggle the cells under them
+} ClipBlend;
+
+// Rectangle of cells packed like grid rows without ghost cells
+typedef struct LifeClip {
+    int rows;
+    int cols;
+    int stride;             // Words per row
+    uint64_t *cells;        // rows*stride words, bits past the last column are clear
+} LifeClip;
+
+// Board cells of a rectangle for a cluster worker, called in the worker process, cells NULL on failure
+typedef LifeClip (*ClusterLoader)(void *data, int row, int col, int rows, int cols);
+
+// Job run by ParallelFor() on the index range [begin, end)
+typedef void (*ParallelJob)(void *data, int begin, int end);
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Life Grid Functions Declaration
+//----------------------------------------------------------------------------------
+LifeGrid LoadLifeGrid(int rows, int cols, GridTopology topology); // Allocate a dead grid, cells is NULL on failure
+void UnloadLifeGrid(LifeGrid grid);
+void ClearLifeGrid(LifeGrid *grid);
+bool GetLifeCell(LifeGrid grid, int row, int col);
+void SetLifeCell(LifeGrid *grid, int row, int col, bool alive);
+void RefreshGhostCells(LifeGrid *grid);                           // Fill ghost border for grid topology
+void StepLifeGrid(LifeGrid *grid);                                // Advance one generation (B3/S23)
+void StepLifeRows(LifeGrid *grid, int begin, int end);            // Next generation of rows [begin, end) into grid->next, ghosts as they are
+void GetLifeStates(LifeGrid grid, uint8_t *states);               // Expand cells into one byte per cell, row-major
+bool TrackLifeChanges(LifeGrid *grid);                            // Record changed words from now on, false when out of memory
+void MarkLifeChanges(LifeGrid *grid, int row, int col, int height, int width); // Record the words of a rectangle as changed
+void MarkLifeRowChanges(LifeGrid *grid, int row, const uint64_t *before, const uint64_t *after); // Record the words two versions of a row differ in
+void ClearLifeChanges(LifeGrid *grid);                            // Forget the changes recorded so far
+double GetLifeSeconds(void);                                      // Monotonic wall clock in seconds, for timing steps
+
+//----------------------------------------------------------------------------------
+// Grid Memory Functions Declaration
+//----------------------------------------------------------------------------------
+void SetLifeGridMemory(GridMemory preferred);                     // Memory for grids loaded from now on, MEMORY_HUGE_PAGES by default
+GridMemory GetLifeGridMemory(void);                               // Memory asked for grids loaded from now on
+GridMemoryInfo GetLifeGridMemoryInfo(LifeGrid grid);
+const char *GetGridMemoryName(GridMemory memory);
+uint64_t *LoadGridBuffers(int rows, int stride, GridMemory *memory); // Both zeroed cell buffers in one block, NULL on failure
+void UnloadGridBuffers(uint64_t *buffers, int rows, int stride, GridMemory memory);
+
+//----------------------------------------------------------------------------------
+// Sparse Engine Functions Declaration
+//----------------------------------------------------------------------------------
+SparseLife LoadSparseLife(LifeGrid *grid);                        // Build neighbour counts, counts is NULL on failure
+void UnloadSparseLife(SparseLife sparse);
+bool SetSparseCell(SparseLife *sparse, LifeGrid *grid, int row, int col, bool alive); // Edit a cell, counts updated in place, false when out of memory
+bool UpdateSparseRows(SparseLife *sparse, LifeGrid *grid, int row, int height, const uint64_t *before); // Count the cells a bulk edit flipped, false when out of memory
+int64_t StepSparseLife(SparseLife *sparse, LifeGrid *grid);       // Advance one generation, returns changed cells, -1 when out of memory
+
+//----------------------------------------------------------------------------------
+// Generations Engine Functions Declaration
+//----------------------------------------------------------------------------------
+bool ParseGenerationsRule(const char *text, GenerationsRule *rule);  // Parse "B2/S345/C4" or "345/2/4"
+GenerationsLife LoadGenerationsLife(LifeGrid grid, GenerationsRule rule); // Live grid cells become state 1, planes are NULL on failure
+void UnloadGenerationsLife(GenerationsLife life);
+int GetGenerationsCell(GenerationsLife life, int row, int col);
+void SetGenerationsCell(GenerationsLife *life, int row, int col, int state);
+void GetGenerationsStates(GenerationsLife life, uint8_t *states);   // Expand states into one byte per cell, row-major
+void StoreGenerationsLife(GenerationsLife life, LifeGrid *grid);    // Write state 1 cells back to a grid
+void StepGenerationsLife(GenerationsLife *life);                    // Advance one generation
+
+//----------------------------------------------------------------------------------
+// Larger than Life Functions Declaration
+//----------------------------------------------------------------------------------
+bool ParseLargerRule(const char *text, LargerRule *rule);         // Parse "R5,C0,M1,S34..58,B34..45,NM"
+LargerLife LoadLargerLife(LifeGrid grid, LargerRule rule);        // Allocate tables, padded is NULL on failure
+void UnloadLargerLife(LargerLife life);
+void StepLargerLife(LargerLife *life, LifeGrid *grid);            // Advance one generation, O(1) per cell for any radius
+
+//----------------------------------------------------------------------------------
+// Isotropic Engine Functions Declaration
+//----------------------------------------------------------------------------------
+bool ParseHenselRule(const char *text, HenselRule *rule);         // Compile "B3/S2-i34q" into a lookup table
+void StepHenselLife(const HenselRule *rule, LifeGrid *grid);      // Advance one generation
+
+//----------------------------------------------------------------------------------
+// Population Pyramid Functions Declaration
+//----------------------------------------------------------------------------------
+LifePyramid LoadLifePyramid(LifeGrid grid);                       // Allocate empty counts, counts are NULL on failure
+void UnloadLifePyramid(LifePyramid pyramid);
+int UpdateLifePyramid(LifePyramid *pyramid, LifeGrid grid);       // Recount tiles holding changed words, returns their number
+int GetPyramidPopulation(LifePyramid pyramid, LifeGrid grid, int level, int blockRow, int blockCol); // Live cells of one block
+
+//----------------------------------------------------------------------------------
+// Cell Ages Functions Declaration
+//----------------------------------------------------------------------------------
+LifeAges LoadLifeAges(LifeGrid grid);                             // Every cell at age 0, ages is NULL on failure
+void UnloadLifeAges(LifeAges ages);
+void UpdateLifeAges(LifeAges *ages, LifeGrid grid);               // One generation older, changed cells back to 0
+int GetLifeAge(LifeAges ages, int row, int col);                  // Generations a cell has kept its state
+
+//----------------------------------------------------------------------------------
+// Export Functions Declaration
+//----------------------------------------------------------------------------------
+LifeExport *OpenLifeExport(ExportSettings settings, int rows, int cols); // Open the output and start encoders, NULL on failure
+bool SubmitLifeExport(LifeExport *exporter, LifeGrid grid, int generation); // Queue a snapshot when generation%every is 0
+int CloseLifeExport(LifeExport *exporter);                        // Drain and finish, returns frames written or -1 on error
+
+//----------------------------------------------------------------------------------
+// Trace Functions Declaration
+//----------------------------------------------------------------------------------
+LifeTrace *OpenLifeTrace(const char *path, LifeGrid grid, int generation, int keyframeInterval); // Start with a keyframe, NULL on failure
+bool AppendLifeTrace(LifeTrace *trace, LifeGrid grid);            // Record the next generation, false once writing failed
+void KeepLifeTraceChanges(LifeTrace *trace, LifeGrid grid);      // Carry the changes marked on grid to the next record before they are cleared
+bool CloseLifeTrace(LifeTrace *trace);                            // Flush, write the index and close
+LifeTraceReader *OpenLifeTraceReader(const char *path);           // Load the index, NULL if not a trace
+void CloseLifeTraceReader(LifeTraceReader *reader);
+TraceInfo GetLifeTraceInfo(const LifeTraceReader *reader);
+bool SeekLifeTrace(LifeTraceReader *reader, int generation, LifeGrid *grid); // Load the cells of one generation
+
+//----------------------------------------------------------------------------------
+// Journal Functions Declaration
+//----------------------------------------------------------------------------------
+LifeJournal *LoadLifeJournal(int rows, int cols, GridTopology topology); // Empty journal, NULL on failure
+LifeJournal *LoadLifeJournalFile(const char *fileName);           // Saved journal, NULL if missing or not a journal
+void UnloadLifeJournal(LifeJournal *journal);
+bool SaveLifeJournal(const LifeJournal *journal, const char *fileName);
+void SetLifeJournalFrame(LifeJournal *journal, int64_t frame);    // Frame stamped on the next events
+bool AppendLifeJournal(LifeJournal *journal, JournalEvent event); // Encode at the current frame, false when out of memory
+bool NextLifeJournalEvent(const LifeJournal *journal, size_t *offset, JournalEvent *event); // Decode in order from offset 0
+JournalInfo GetLifeJournalInfo(const LifeJournal *journal);
+
+//----------------------------------------------------------------------------------
+// Shared Memory Functions Declaration
+//----------------------------------------------------------------------------------
+LifeShare *OpenLifeShare(const char *name, int rows, int cols, int frames); // Create a segment with a ring of frames, NULL on failure
+void PublishLifeShare(LifeShare *share, LifeGrid grid, int generation); // Copy the grid into the next frame, lock free
+void CloseLifeShare(LifeShare *share);                            // Unmap and unlink the segment
+LifeShareReader *OpenLifeShareReader(const char *name);           // Map a segment read-only, NULL if not a grid segment
+void CloseLifeShareReader(LifeShareReader *reader);
+ShareInfo GetLifeShareInfo(const LifeShareReader *reader);
+const uint64_t *PeekLifeShare(const LifeShareReader *reader, int generation, uint64_t *sequence); // Cells in place, generation < 0 for the latest
+bool CheckLifeShare(const uint64_t *cells, uint64_t sequence);    // Peeked cells were not rewritten while being read
+bool ReadLifeShare(const LifeShareReader *reader, int generation, LifeGrid *grid); // Copy a generation into a grid
+
+//----------------------------------------------------------------------------------
+// Stream Server Functions Declaration
+//----------------------------------------------------------------------------------
+LifeServer *OpenLifeServer(const char *address, LifeGrid grid, int generation); // Listen on "unix:path" or "tcp:host:port", NULL on failure
+void PublishLifeServer(LifeServer *server, LifeGrid grid, int generation); // Hand a generation to the network thread, never blocks on viewers
+int GetLifeServerClients(LifeServer *server);                     // Viewers connected
+void CloseLifeServer(LifeServer *server);
+LifeClient *OpenLifeClient(const char *address);                  // Connect and read the stream size, NULL on failure
+void CloseLifeClient(LifeClient *client);
+StreamInfo GetLifeClientInfo(const LifeClient *client);
+bool ReceiveLifeClient(LifeClient *client, LifeGrid *grid);       // Wait for the next message and apply it to grid
+
+//----------------------------------------------------------------------------------
+// Mapped Board Functions Declaration
+//----------------------------------------------------------------------------------
+LifeMapped *CreateLifeMapped(const char *path, int rows, int cols, GridTopology topology, int64_t budget); // New dead board file, NULL on failure
+LifeMapped *OpenLifeMapped(const char *path, int64_t budget);     // Board file written before, NULL if not a board file
+void CloseLifeMapped(LifeMapped *board);                          // Flush and unmap, the file keeps the last generation
+MappedInfo GetLifeMappedInfo(const LifeMapped *board);
+bool GetMappedCell(const LifeMapped *board, int row, int col);
+void SetMappedCell(LifeMapped *board, int row, int col, bool alive);
+bool StepLifeMapped(LifeMapped *board, int generations);          // Advance tile by tile within the RAM budget, false on a write error
+
+//----------------------------------------------------------------------------------
+// Cluster Functions Declaration
+//----------------------------------------------------------------------------------
+LifeCluster *StartLifeCluster(ClusterSettings settings, int rows, int cols, GridTopology topology, ClusterLoader loader, void *data); // Fork a worker per subdomain, each loading its own, NULL on failure
+bool StepLifeCluster(LifeCluster *cluster, int generations);      // Advance every subdomain, false once a worker failed
+ClusterStats GetLifeClusterStats(const LifeCluster *cluster);
+bool GatherLifeCluster(LifeCluster *cluster, LifeGrid *window, int row, int col); // Copy the board cells under a window at (row, col)
+void StopLifeCluster(LifeCluster *cluster);                       // Stop and reap the worker processes
+
+//----------------------------------------------------------------------------------
+// Census Functions Declaration
+//----------------------------------------------------------------------------------
+LifeCensus *LoadLifeCensus(uint64_t seed, int maxGenerations);    // Empty census for soups of seed, NULL on failure
+void UnloadLifeCensus(LifeCensus *census);
+bool RunLifeCensus(LifeCensus *census, int soups);                // Run the next soups on every ParallelFor() thread
+CensusStats GetLifeCensusStats(const LifeCensus *census);
+int GetLifeCensusObjects(const LifeCensus *census, CensusObject *objects, int count); // Most common objects first, codes valid until the next run
+bool SaveLifeCensus(const LifeCensus *census, const char *fileName); // Write every object count and the unstable soups as text
+
+//----------------------------------------------------------------------------------
+// Batch Functions Declaration
+//----------------------------------------------------------------------------------
+LifeBatch *LoadLifeBatch(int rows, int cols, GridTopology topology, int universes); // Dead boards, all running, NULL on failure
+void UnloadLifeBatch(LifeBatch *batch);
+int StepLifeBatch(LifeBatch *batch, int generations);            // Advance running universes, returns how many retired
+void ResetBatchUniverse(LifeBatch *batch, int universe);         // Clear a universe and start it running again
+void LoadBatchUniverse(LifeBatch *batch, int universe, LifeGrid grid); // Refill a universe from a grid of the batch size
+void StoreBatchUniverse(const LifeBatch *batch, int universe, LifeGrid *grid);
+bool GetBatchCell(const LifeBatch *batch, int universe, int row, int col);
+void SetBatchCell(LifeBatch *batch, int universe, int row, int col, bool alive);
+BatchUniverse GetBatchUniverse(const LifeBatch *batch, int universe);
+BatchInfo GetLifeBatchInfo(const LifeBatch *batch);
+
+//----------------------------------------------------------------------------------
+// Object Functions Declaration
+//----------------------------------------------------------------------------------
+LifeObjects *LoadLifeObjects(ObjectAdjacency adjacency);         // Empty labelling with known shapes hashed, NULL on failure
+void UnloadLifeObjects(LifeObjects *objects);
+int LabelLifeObjects(LifeObjects *objects, LifeGrid grid);       // Label live cells on every ParallelFor() thread, -1 when out of memory
+int GetLifeObjects(const LifeObjects *objects, LifeObject *list, int count); // Objects of the last labelling, top to bottom
+ObjectsInfo GetLifeObjectsInfo(const LifeObjects *objects);
+
+//----------------------------------------------------------------------------------
+// Search Functions Declaration
+//----------------------------------------------------------------------------------
+LifeSearch *LoadLifeSearch(LifeGrid pattern, int phases, bool isolated); // Variants of the live cells of pattern, NULL on failure
+void UnloadLifeSearch(LifeSearch *search);
+int RunLifeSearch(LifeSearch *search, LifeGrid grid);            // Search every ParallelFor() band, -1 when out of memory
+int GetLifeSearchMatches(const LifeSearch *search, SearchMatch *matches, int count); // Matches of the last search, top to bottom
+SearchInfo GetLifeSearchInfo(const LifeSearch *search);
+
+//----------------------------------------------------------------------------------
+// Clip Functions Declaration
+//----------------------------------------------------------------------------------
+LifeClip LoadLifeClip(int rows, int cols);                       // Dead clip, cells is NULL on failure
+void UnloadLifeClip(LifeClip clip);
+LifeClip LoadLifePattern(const char *fileName);                  // Pattern of an RLE file, cells is NULL on failure
+LifeClip CopyLifeRegion(LifeGrid grid, int row, int col, int rows, int cols); // Cells of a rectangle, off the grid ones dead
+void PasteLifeClip(LifeGrid *grid, LifeClip clip, int row, int col, ClipBlend blend); // Blit with the top left clip cell at (row, col)
+void FillLifeRegion(LifeGrid *grid, int row, int col, int rows, int cols, bool alive);
+LifeClip RotateLifeClip(LifeClip clip);                          // Clockwise quarter turn into a new clip
+void FlipLifeClip(LifeClip *clip, bool horizontal);              // Mirror left to right or top to bottom in place
+void RandomizeLifeRegion(LifeGrid *grid, int row, int col, int rows, int cols, double density, uint64_t seed); // Cells alive with probability density
+LifeClip LoadLifeNoise(int row, int col, int rows, int cols, double density, uint64_t seed); // Same random cells as a clip, cells is NULL on failure
+
+//----------------------------------------------------------------------------------
+// Parallel Functions Declaration
+//----------------------------------------------------------------------------------
+int GetParallelWorkers(void);                                     // Threads used by ParallelFor(), caller included
+void SetParallelWorkers(int count);                               // Takes effect when the pool starts, 0 uses every core
+void ParallelFor(int count, ParallelJob job, void *data);         // Split [0, count) across threads and wait
+void CloseParallelWorkers(void);                                  // Join worker threads
+
+//----------------------------------------------------------------------------------
+// Bit Functions Definition
+//----------------------------------------------------------------------------------
+
+// Set bits of a word, inline so the per word counting loops stay one instruction
+static inline int CountLifeBits(uint64_t bits)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(bits);
+#else
+    bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+    bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((bits*0x0101010101010101ULL) >> 56);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIFE_H
@@ -0,0 +1,146 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Cell ages
+*
+*   One byte per cell counting the generations it has kept its state, alive or dead, and
+*   saturating at LIFE_AGE_MAX. Ages feed the heat map view: cells that keep flipping stay
+*   young, so activity hot spots stand out against settled still lifes and empty space.
+*
+*   Updates compare the grid against the cells seen last time one word at a time, and the
+*   64 ages of a word are stepped eight to a 64 bit register: changed cells are spread from
+*   bits to whole bytes and cleared, the others get a saturating byte increment. Rows are
+*   padded to whole words so there is no tail loop, and run over the ParallelFor() threads.
+*
+*   NOTE: Nothing here runs unless ages are loaded, the engines do not know about them.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define BYTES_LOW 0x0101010101010101ULL
+#define BYTES_HIGH 0x8080808080808080ULL
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct AgesJob {
+    LifeAges *ages;
+    LifeGrid grid;
+} AgesJob;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static void UpdateAgeRows(void *data, int begin, int end);
+static inline uint64_t SpreadBits(uint64_t bits);
+static inline uint64_t StepAges(uint64_t ages, uint64_t changed);
+
+//----------------------------------------------------------------------------------
+// Cell Ages Functions Definition
+//----------------------------------------------------------------------------------
+
+// Ages for the grid size, every cell at age 0 and the grid taken as the cells last seen, ages is NULL on failure
+LifeAges LoadLifeAges(LifeGrid grid)
+{
+    LifeAges ages = { 0 };
+    ages.rows = grid.rows;
+    ages.cols = grid.cols;
+    ages.stride = grid.stride;
+    ages.ageStride = 64*((grid.cols + 63)/64);
+
+    ages.ages = calloc((size_t)ages.rows*ages.ageStride, sizeof(uint8_t));
+    ages.previous = malloc((size_t)ages.rows*ages.stride*sizeof(uint64_t));
+    if ((ages.ages == NULL) || (ages.previous == NULL))
+    {
+        UnloadLifeAges(ages);
+        return (LifeAges){ 0 };
+    }
+    for (int row = 0; row < ages.rows; row++)
+    {
+        memcpy(ages.previous + (size_t)row*ages.stride, LIFE_ROW(grid, grid.cells, row), ages.stride*sizeof(uint64_t));
+    }
+
+    return ages;
+}
+
+void UnloadLifeAges(LifeAges ages)
+{
+    free(ages.ages);
+    free(ages.previous);
+}
+
+// Age every cell by one generation, cells that changed since the last update restart at 0
+void UpdateLifeAges(LifeAges *ages, LifeGrid grid)
+{
+    AgesJob job = { ages, grid };
+    ParallelFor(ages->rows, UpdateAgeRows, &job);
+}
+
+// Generations a cell has kept its state, as of the last update
+int GetLifeAge(LifeAges ages, int row, int col)
+{
+    if ((row < 0) || (col < 0) || (row >= ages.rows) || (col >= ages.cols)) return 0;
+
+    return ages.ages[(size_t)row*ages.ageStride + col];
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Rows [begin, end) stepped a word of cells at a time
+static void UpdateAgeRows(void *data, int begin, int end)
+{
+    AgesJob *job = (AgesJob *)data;
+    LifeAges *ages = job->ages;
+    int words = (ages->cols + 63)/64;
+    uint64_t lastMask = (ages->cols%64 == 0)? ~0ULL : ((1ULL << (ages->cols%64)) - 1);
+
+    for (int row = begin; row < end; row++)
+    {
+        const uint64_t *cells = LIFE_ROW(job->grid, job->grid.cells, row) + 1;
+        uint64_t *previous = ages->previous + (size_t)row*ages->stride + 1;
+        uint8_t *bytes = ages->ages + (size_t)row*ages->ageStride;
+
+        for (int w = 0; w < words; w++)
+        {
+            // The ghost cell past the last column is not a cell of its own
+            uint64_t mask = (w == words - 1)? lastMask : ~0ULL;
+            uint64_t changed = (cells[w] ^ previous[w]) & mask;
+            previous[w] = cells[w];
+
+            for (int k = 0; k < 8; k++)
+            {
+                uint64_t eight;
+                memcpy(&eight, bytes + 64*w + 8*k, sizeof(eight));
+                eight = StepAges(eight, SpreadBits((changed >> 8*k) & 0xFF));
+                memcpy(bytes + 64*w + 8*k, &eight, sizeof(eight));
+            }
+        }
+    }
+}
+
+// Bit i of the low byte spread to all of byte i, 0xFF bytes for set bits
+static inline uint64_t SpreadBits(uint64_t bits)
+{
+    uint64_t picked = (bits*BYTES_LOW) & 0x8040201008040201ULL;
+    uint64_t set = (picked | ((picked & ~BYTES_HIGH) + (BYTES_HIGH - BYTES_LOW))) & BYTES_HIGH;
+    return (set >> 7)*0xFF;
+}
+
+// Eight ages incremented up to LIFE_AGE_MAX, bytes of changed cleared
+static inline uint64_t StepAges(uint64_t ages, uint64_t changed)
+{
+    // Adding 1 to the low seven bits of a byte never carries into the next one
+    uint64_t high = ages & BYTES_HIGH;
+    uint64_t low = (ages & ~BYTES_HIGH) + BYTES_LOW;
+    uint64_t saturated = ((low & high) >> 7)*0xFF;
+
+    return ((low ^ high) | saturated) & ~changed;
+}
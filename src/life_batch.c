@@ -0,0 +1,336 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Batched universes
+*
+*   Steps many small boards of the same size at once. Boards are bit-sliced: every word
+*   holds one cell of 64 universes, bit k belonging to universe k of its group, so one
+*   pass of the B3/S23 adder network advances 64 universes per word. Groups of 64 are
+*   interleaved innermost, the words of one cell for every group sitting next to each other,
+*   so the compiler can vectorize the inner loop with each vector lane on different universes.
+*
+*   Layout, ghost border included: word ((row + 1)*(cols + 2) + col + 1)*groups + group.
+*
+*   Three buffers rotate so every step also compares the new generation with the last two.
+*   A universe that comes back to either settled into still lifes or period 2 oscillators
+*   (empty boards included). It is then retired: its lane is frozen, counted as stable and
+*   can be refilled with a new universe while the others keep running.
+*
+*   NOTE: Universes retire on the first repeat, longer periods and gliders keep running
+*   until the caller replaces them.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+struct LifeBatch {
+    int rows;
+    int cols;
+    GridTopology topology;
+    int universes;
+    int groups;             // Words per cell, 64 universes each
+    size_t rowWords;        // Words per buffer row, ghost columns included
+    uint64_t *cells;        // Current generation
+    uint64_t *next;
+    uint64_t *older;        // Generation before the current one
+    uint64_t *rowStill;     // Per row and group, lanes that changed since the last generation
+    uint64_t *rowCycle;     // Per row and group, lanes that changed since two generations ago
+    uint64_t *active;       // Per group, lanes still running
+    BatchUniverse *lanes;
+    int64_t generation;
+    double stepSeconds;
+};
+
+typedef struct BatchJob {
+    LifeBatch *batch;
+} BatchJob;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static void StepBatchRows(void *data, int begin, int end);
+static void RefreshBatchGhosts(LifeBatch *batch);
+static void SetLaneBit(uint64_t *word, int lane, bool alive);
+
+//----------------------------------------------------------------------------------
+// Batch Functions Definition
+//----------------------------------------------------------------------------------
+
+// Allocate universes dead boards, all running
+LifeBatch *LoadLifeBatch(int rows, int cols, GridTopology topology, int universes)
+{
+    if ((rows <= 0) || (cols <= 0) || (universes <= 0)) return NULL;
+
+    LifeBatch *batch = calloc(1, sizeof(LifeBatch));
+    if (batch == NULL) return NULL;
+
+    batch->rows = rows;
+    batch->cols = cols;
+    batch->topology = topology;
+    batch->universes = universes;
+    batch->groups = (universes + 63)/64;
+    batch->rowWords = (size_t)(cols + 2)*batch->groups;
+
+    size_t words = (rows + 2)*batch->rowWords;
+    batch->cells = calloc(words, sizeof(uint64_t));
+    batch->next = calloc(words, sizeof(uint64_t));
+    batch->older = calloc(words, sizeof(uint64_t));
+    batch->rowStill = calloc((size_t)rows*batch->groups, sizeof(uint64_t));
+    batch->rowCycle = calloc((size_t)rows*batch->groups, sizeof(uint64_t));
+    batch->active = calloc(batch->groups, sizeof(uint64_t));
+    batch->lanes = calloc(universes, sizeof(BatchUniverse));
+    if ((batch->cells == NULL) || (batch->next == NULL) || (batch->older == NULL) || (batch->rowStill == NULL) ||
+        (batch->rowCycle == NULL) || (batch->active == NULL) || (batch->lanes == NULL))
+    {
+        UnloadLifeBatch(batch);
+        return NULL;
+    }
+
+    // Lanes past the last universe never run
+    for (int u = 0; u < universes; u++) batch->active[u/64] |= 1ULL << (u%64);
+
+    return batch;
+}
+
+void UnloadLifeBatch(LifeBatch *batch)
+{
+    if (batch == NULL) return;
+
+    free(batch->cells);
+    free(batch->next);
+    free(batch->older);
+    free(batch->rowStill);
+    free(batch->rowCycle);
+    free(batch->active);
+    free(batch->lanes);
+    free(batch);
+}
+
+// Clear one universe and start it running again, to refill a retired lane
+void ResetBatchUniverse(LifeBatch *batch, int universe)
+{
+    if ((universe < 0) || (universe >= batch->universes)) return;
+
+    int group = universe/64;
+    uint64_t clear = ~(1ULL << (universe%64));
+    size_t words = (batch->rows + 2)*batch->rowWords;
+    for (size_t i = group; i < words; i += batch->groups)
+    {
+        batch->cells[i] &= clear;
+        batch->older[i] &= clear;
+    }
+
+    batch->active[group] |= ~clear;
+    batch->lanes[universe] = (BatchUniverse){ 0 };
+}
+
+// Refill one universe from a grid of the batch size
+void LoadBatchUniverse(LifeBatch *batch, int universe, LifeGrid grid)
+{
+    if ((universe < 0) || (universe >= batch->universes) || (grid.rows != batch->rows) || (grid.cols != batch->cols)) return;
+
+    ResetBatchUniverse(batch, universe);
+    for (int row = 0; row < grid.rows; row++)
+    {
+        for (int col = 0; col < grid.cols; col++)
+        {
+            if (GetLifeCell(grid, row, col)) SetBatchCell(batch, universe, row, col, true);
+        }
+    }
+}
+
+void StoreBatchUniverse(const LifeBatch *batch, int universe, LifeGrid *grid)
+{
+    if ((universe < 0) || (universe >= batch->universes) || (grid->rows != batch->rows) || (grid->cols != batch->cols)) return;
+
+    for (int row = 0; row < grid->rows; row++)
+    {
+        for (int col = 0; col < grid->cols; col++) SetLifeCell(grid, row, col, GetBatchCell(batch, universe, row, col));
+    }
+}
+
+bool GetBatchCell(const LifeBatch *batch, int universe, int row, int col)
+{
+    if ((universe < 0) || (universe >= batch->universes) || (row < 0) || (col < 0) || (row >= batch->rows) || (col >= batch->cols)) return false;
+
+    size_t word = ((size_t)(row + 1)*(batch->cols + 2) + col + 1)*batch->groups + universe/64;
+    return (batch->cells[word] >> (universe%64)) & 1;
+}
+
+// Edits count as the state of the last two generations too, so they never look like a repeat
+void SetBatchCell(LifeBatch *batch, int universe, int row, int col, bool alive)
+{
+    if ((universe < 0) || (universe >= batch->universes) || (row < 0) || (col < 0) || (row >= batch->rows) || (col >= batch->cols)) return;
+
+    size_t word = ((size_t)(row + 1)*(batch->cols + 2) + col + 1)*batch->groups + universe/64;
+    SetLaneBit(&batch->cells[word], universe%64, alive);
+    SetLaneBit(&batch->older[word], universe%64, alive);
+}
+
+BatchUniverse GetBatchUniverse(const LifeBatch *batch, int universe)
+{
+    if ((universe < 0) || (universe >= batch->universes)) return (BatchUniverse){ 0 };
+
+    return batch->lanes[universe];
+}
+
+BatchInfo GetLifeBatchInfo(const LifeBatch *batch)
+{
+    BatchInfo info = { 0 };
+    info.rows = batch->rows;
+    info.cols = batch->cols;
+    info.universes = batch->universes;
+    info.groups = batch->groups;
+    info.generation = batch->generation;
+    info.stepSeconds = batch->stepSeconds;
+    for (int u = 0; u < batch->universes; u++) info.stable += batch->lanes[u].stable;
+    info.running = info.universes - info.stable;
+    return info;
+}
+
+// Advance every running universe, returns the universes that retired during these generations
+int StepLifeBatch(LifeBatch *batch, int generations)
+{
+    double start = GetLifeSeconds();
+    int retired = 0;
+    BatchJob job = { batch };
+
+    for (int i = 0; i < generations; i++)
+    {
+        RefreshBatchGhosts(batch);
+        ParallelFor(batch->rows, StepBatchRows, &job);
+
+        uint64_t *swap = batch->older;
+        batch->older = batch->cells;
+        batch->cells = batch->next;
+        batch->next = swap;
+        batch->generation++;
+
+        for (int group = 0; group < batch->groups; group++)
+        {
+            uint64_t active = batch->active[group];
+            if (active == 0) continue;
+
+            uint64_t changed = 0, cycled = 0;
+            for (int row = 0; row < batch->rows; row++)
+            {
+                changed |= batch->rowStill[(size_t)row*batch->groups + group];
+                cycled |= batch->rowCycle[(size_t)row*batch->groups + group];
+            }
+            uint64_t settled = active & (~changed | ~cycled);
+            batch->active[group] = active & ~settled;
+
+            for (int lane = 0; lane < 64; lane++)
+            {
+                if (!((active >> lane) & 1)) continue;
+
+                BatchUniverse *universe = &batch->lanes[group*64 + lane];
+                universe->generations++;
+                if ((settled >> lane) & 1)
+                {
+                    universe->stable = true;
+                    universe->period = ((changed >> lane) & 1)? 2 : 1;
+                    retired++;
+                }
+            }
+        }
+    }
+
+    batch->stepSeconds = GetLifeSeconds() - start;
+    return retired;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Same adder network as StepLifeRows(), one cell of every universe per word
+static void StepBatchRows(void *data, int begin, int end)
+{
+    LifeBatch *batch = ((BatchJob *)data)->batch;
+    int groups = batch->groups;
+    size_t rowWords = batch->rowWords;
+    const uint64_t *active = batch->active;
+
+    for (int row = begin; row < end; row++)
+    {
+        uint64_t *still = batch->rowStill + (size_t)row*groups;
+        uint64_t *cycle = batch->rowCycle + (size_t)row*groups;
+        memset(still, 0, groups*sizeof(uint64_t));
+        memset(cycle, 0, groups*sizeof(uint64_t));
+
+        for (int col = 0; col < batch->cols; col++)
+        {
+            size_t base = (size_t)(row + 1)*rowWords + (size_t)(col + 1)*groups;
+            const uint64_t *center = batch->cells + base;
+            const uint64_t *above = center - rowWords;
+            const uint64_t *below = center + rowWords;
+            const uint64_t *older = batch->older + base;
+            uint64_t *out = batch->next + base;
+
+            for (int g = 0; g < groups; g++)
+            {
+                uint64_t aW = above[g - groups], aN = above[g], aE = above[g + groups];
+                uint64_t cW = center[g - groups], cC = center[g], cE = center[g + groups];
+                uint64_t bW = below[g - groups], bS = below[g], bE = below[g + groups];
+
+                uint64_t t = aW ^ aN;
+                uint64_t a1 = t ^ aE;
+                uint64_t a2 = (aW & aN) | (t & aE);
+                t = bW ^ bS;
+                uint64_t b1 = t ^ bE;
+                uint64_t b2 = (bW & bS) | (t & bE);
+                uint64_t c1 = cW ^ cE;
+                uint64_t c2 = cW & cE;
+
+                t = a1 ^ b1;
+                uint64_t s0 = t ^ c1;
+                uint64_t k1 = (a1 & b1) | (t & c1);
+
+                t = a2 ^ b2;
+                uint64_t t0 = t ^ c2;
+                uint64_t t1 = (a2 & b2) | (t & c2);
+                uint64_t twos = (t0 ^ k1) & ~t1;
+
+                // Retired lanes keep their cells
+                uint64_t cell = ((twos & (s0 | cC)) & active[g]) | (cC & ~active[g]);
+                out[g] = cell;
+                still[g] |= cell ^ cC;
+                cycle[g] |= cell ^ older[g];
+            }
+        }
+    }
+}
+
+// Ghost cells for the topology, dead edge ghosts are never written and stay clear
+static void RefreshBatchGhosts(LifeBatch *batch)
+{
+    if (batch->topology == TOPOLOGY_DEAD_EDGE) return;
+
+    bool torus = (batch->topology == TOPOLOGY_TORUS);
+    int groups = batch->groups;
+    size_t cellBytes = groups*sizeof(uint64_t);
+    for (int row = 0; row < batch->rows; row++)
+    {
+        uint64_t *cells = batch->cells + (size_t)(row + 1)*batch->rowWords;
+        memcpy(cells, cells + (size_t)(torus? batch->cols : 1)*groups, cellBytes);
+        memcpy(cells + (size_t)(batch->cols + 1)*groups, cells + (size_t)(torus? 1 : batch->cols)*groups, cellBytes);
+    }
+
+    // Whole rows after the column ghosts so the corners follow the topology on both axes
+    size_t rowBytes = batch->rowWords*sizeof(uint64_t);
+    memcpy(batch->cells, batch->cells + (size_t)(torus? batch->rows : 1)*batch->rowWords, rowBytes);
+    memcpy(batch->cells + (size_t)(batch->rows + 1)*batch->rowWords, batch->cells + (size_t)(torus? 1 : batch->rows)*batch->rowWords, rowBytes);
+}
+
+static void SetLaneBit(uint64_t *word, int lane, bool alive)
+{
+    if (alive) *word |= 1ULL << lane;
+    else *word &= ~(1ULL << lane);
+}
+
@@ -0,0 +1,689 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Soup census
+*
+*   Runs random 16x16 soups to stabilization and counts the objects they leave behind, the
+*   way apgsearch does. Throughput is the point: every ParallelFor() thread runs one soup at a
+*   time on its own board and takes the next soup number when done.
+*
+*   Soup n of a seed is drawn from a SplitMix64 stream started at seed + n*golden ratio, so a
+*   census can be split over runs and machines and every soup can be replayed on its own.
+*   Soups grow on a 512x512 dead edge board that only steps the rows holding live cells.
+*   Cells reaching the border are removed, so gliders flying off do not crash into the edge.
+*   A soup is stable once its population repeats with some period up to 60 over a window
+*   of at least 60 generations.
+*
+*   The stable board is split into 8-connected components. Each is run alone until it
+*   comes back to its own shape, giving its period and whether it moved, and is named by its
+*   apgcode: "xs" still lifes, "xp" oscillators and "xq" spaceships, then the extended
+*   Wechsler code of the phase and orientation with the shortest, then lowest, code.
+*   Components that never come back alone, like parts of pseudo objects, count as "zz_pseudo",
+*   and those wider than 40 cells as "zz_large".
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define CENSUS_BOARD 512
+#define CENSUS_SOUP 16
+#define CENSUS_BORDER 2             // Cells this close to the edge are removed every generation
+#define CENSUS_HISTORY 512          // Populations kept, more than window plus period
+#define CENSUS_MAX_PERIOD 60
+#define CENSUS_MIN_WINDOW 60
+#define CENSUS_MAX_OBJECT 40        // Larger bounding boxes are not classified
+#define CENSUS_OBJECT_GRID (CENSUS_MAX_OBJECT + 2*(CENSUS_MAX_PERIOD + 2))
+#define CENSUS_CODE_LENGTH 512      // Longest code of a CENSUS_MAX_OBJECT square object fits
+#define CENSUS_MAX_UNSTABLE 4096    // Unstable soups listed in the census file
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct CensusEntry {
+    char *code;
+    int64_t count;
+    int64_t firstSoup;
+} CensusEntry;
+
+// Open addressing table of apgcodes
+typedef struct CensusTable {
+    CensusEntry *entries;
+    int capacity;           // Power of two
+    int count;
+    bool failed;            // An allocation failed, some objects were not counted
+} CensusTable;
+
+struct LifeCensus {
+    uint64_t seed;
+    int maxGenerations;
+    int64_t nextSoup;
+    CensusTable table;
+    int64_t unstableSoups[CENSUS_MAX_UNSTABLE];
+    CensusStats stats;
+    CensusEntry *sorted;    // Most common first, rebuilt after every run
+};
+
+// Board, scratch space and counts of one thread
+typedef struct CensusWorker {
+    LifeGrid board;
+    LifeGrid object;        // One component stepped alone
+    uint8_t *visited;       // Board cells already put in a component
+    int *component;         // Board cells of the component being labelled
+    uint8_t *shape;         // Bitmaps of the phase being encoded and its transform
+    uint8_t *transformed;
+    int populations[CENSUS_HISTORY];
+    CensusTable table;
+    int64_t unstable[CENSUS_MAX_UNSTABLE];
+    int unstableCount;
+    int64_t soups;
+    int64_t objects;
+    int64_t generations;
+    int64_t escaped;
+} CensusWorker;
+
+typedef struct CensusJob {
+    LifeCensus *census;
+    CensusWorker *workers;
+    int64_t nextSoup;       // Taken with an atomic add
+    int64_t endSoup;
+} CensusJob;
+
+// Rows of a buffer that may hold live cells
+typedef struct RowSpan {
+    int first;
+    int last;               // One past the last row, first == last when empty
+} RowSpan;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static void RunCensusThread(void *data, int begin, int end);
+static bool LoadCensusWorker(CensusWorker *worker);
+static void UnloadCensusWorker(CensusWorker *worker);
+static int RunSoup(CensusWorker *worker, uint64_t seed, int64_t soup, int maxGenerations);
+static void CountObjects(CensusWorker *worker, int64_t soup, RowSpan live);
+static void ClassifyObject(CensusWorker *worker, int count, int top, int left, int height, int width, char *code);
+static bool ExtractShape(const CensusWorker *worker, int top, int left, int bottom, int right, int *height, int *width, int *population, int *shapeTop, int *shapeLeft);
+static void EncodeShape(CensusWorker *worker, int height, int width, char *best);
+static int EncodeWechsler(const uint8_t *cells, int height, int width, char *code);
+static void AddCensusEntry(CensusTable *table, const char *code, int64_t count, int64_t firstSoup);
+static void UnloadCensusTable(CensusTable *table);
+static int CompareEntries(const void *a, const void *b);
+static uint64_t NextSplitMix(uint64_t *state);
+
+//----------------------------------------------------------------------------------
+// Census Functions Definition
+//----------------------------------------------------------------------------------
+LifeCensus *LoadLifeCensus(uint64_t seed, int maxGenerations)
+{
+    if (maxGenerations <= 0) return NULL;
+
+    LifeCensus *census = calloc(1, sizeof(LifeCensus));
+    if (census == NULL) return NULL;
+
+    census->seed = seed;
+    census->maxGenerations = maxGenerations;
+    census->stats.seed = seed;
+    return census;
+}
+
+void UnloadLifeCensus(LifeCensus *census)
+{
+    if (census == NULL) return;
+
+    UnloadCensusTable(&census->table);
+    free(census->sorted);
+    free(census);
+}
+
+// Run soups from where the last run stopped, one thread per ParallelFor() chunk
+bool RunLifeCensus(LifeCensus *census, int soups)
+{
+    if (soups <= 0) return true;
+
+    int threads = GetParallelWorkers();
+    CensusWorker *workers = calloc(threads, sizeof(CensusWorker));
+    bool loaded = (workers != NULL);
+    for (int i = 0; loaded && (i < threads); i++) loaded = LoadCensusWorker(&workers[i]);
+
+    if (loaded)
+    {
+        double start = GetLifeSeconds();
+        CensusJob job = { census, workers, census->nextSoup, census->nextSoup + soups };
+        ParallelFor(threads, RunCensusThread, &job);
+        census->nextSoup += soups;
+        census->stats.seconds += GetLifeSeconds() - start;
+        census->stats.threads = threads;
+
+        for (int i = 0; i < threads; i++)
+        {
+            CensusWorker *worker = &workers[i];
+            for (int k = 0; k < worker->table.capacity; k++)
+            {
+                CensusEntry *entry = &worker->table.entries[k];
+                if (entry->code != NULL) AddCensusEntry(&census->table, entry->code, entry->count, entry->firstSoup);
+            }
+            for (int k = 0; k < worker->unstableCount; k++)
+            {
+                if (census->stats.unstable < CENSUS_MAX_UNSTABLE) census->unstableSoups[census->stats.unstable] = worker->unstable[k];
+                census->stats.unstable++;
+            }
+            census->stats.soups += worker->soups;
+            census->stats.objects += worker->objects;
+            census->stats.generations += worker->generations;
+            census->stats.escaped += worker->escaped;
+            if (worker->table.failed) census->table.failed = true;
+        }
+        census->stats.codes = census->table.count;
+        census->stats.soupsPerCore = (census->stats.seconds > 0.0)? census->stats.soups/census->stats.seconds/threads : 0.0;
+
+        // Sorted view for readers, entries point into the table
+        free(census->sorted);
+        census->sorted = malloc((census->table.count + 1)*sizeof(CensusEntry));
+        if (census->sorted != NULL)
+        {
+            int count = 0;
+            for (int k = 0; k < census->table.capacity; k++)
+            {
+                if (census->table.entries[k].code != NULL) census->sorted[count++] = census->table.entries[k];
+            }
+            qsort(census->sorted, count, sizeof(CensusEntry), CompareEntries);
+        }
+    }
+
+    for (int i = 0; (workers != NULL) && (i < threads); i++) UnloadCensusWorker(&workers[i]);
+    free(workers);
+
+    return loaded && !census->table.failed && (census->sorted != NULL);
+}
+
+CensusStats GetLifeCensusStats(const LifeCensus *census)
+{
+    return census->stats;
+}
+
+// Fill up to count objects, most common first, returns how many were filled
+int GetLifeCensusObjects(const LifeCensus *census, CensusObject *objects, int count)
+{
+    if (census->sorted == NULL) return 0;
+
+    int filled = (count < census->table.count)? count : census->table.count;
+    for (int i = 0; i < filled; i++)
+    {
+        objects[i].code = census->sorted[i].code;
+        objects[i].count = census->sorted[i].count;
+        objects[i].firstSoup = census->sorted[i].firstSoup;
+    }
+    return filled;
+}
+
+bool SaveLifeCensus(const LifeCensus *census, const char *fileName)
+{
+    FILE *file = fopen(fileName, "w");
+    if (file == NULL) return false;
+
+    const CensusStats *stats = &census->stats;
+    fprintf(file, "# cgameoflife soup census, B3/S23, %dx%d soups\n", CENSUS_SOUP, CENSUS_SOUP);
+    fprintf(file, "# seed %llu, soups 0 to %lld\n", (unsigned long long)stats->seed, (long long)census->nextSoup - 1);
+    fprintf(file, "# %lld soups, %lld objects, %lld generations, %lld unstable, %lld cells escaped\n", (long long)stats->soups,
+        (long long)stats->objects, (long long)stats->generations, (long long)stats->unstable, (long long)stats->escaped);
+    fprintf(file, "# %.1f soups/s/core on %d threads\n", stats->soupsPerCore, stats->threads);
+    fprintf(file, "#\n# apgcode count first_soup\n");
+
+    for (int i = 0; (census->sorted != NULL) && (i < census->table.count); i++)
+    {
+        fprintf(file, "%s %lld %lld\n", census->sorted[i].code, (long long)census->sorted[i].count, (long long)census->sorted[i].firstSoup);
+    }
+
+    if (stats->unstable > 0)
+    {
+        fprintf(file, "#\n# unstable soups after %d generations\n", census->maxGenerations);
+        int listed = (stats->unstable < CENSUS_MAX_UNSTABLE)? (int)stats->unstable : CENSUS_MAX_UNSTABLE;
+        for (int i = 0; i < listed; i++) fprintf(file, "# soup %lld\n", (long long)census->unstableSoups[i]);
+    }
+
+    bool written = !ferror(file);
+    return (fclose(file) == 0) && written;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// One chunk per thread, soups are handed out one at a time so long soups do not stall a chunk
+static void RunCensusThread(void *data, int begin, int end)
+{
+    CensusJob *job = (CensusJob *)data;
+    for (int i = begin; i < end; i++)
+    {
+        CensusWorker *worker = &job->workers[i];
+        for (;;)
+        {
+#if defined(_MSC_VER)
+            int64_t soup = _InterlockedExchangeAdd64((volatile long long *)&job->nextSoup, 1);
+#else
+            int64_t soup = __atomic_fetch_add(&job->nextSoup, 1, __ATOMIC_RELAXED);
+#endif
+            if (soup >= job->endSoup) break;
+
+            int generations = RunSoup(worker, job->census->seed, soup, job->census->maxGenerations);
+            worker->soups++;
+            worker->generations += (generations < 0)? job->census->maxGenerations : generations;
+            if (generations < 0)
+            {
+                if (worker->unstableCount < CENSUS_MAX_UNSTABLE) worker->unstable[worker->unstableCount] = soup;
+                worker->unstableCount++;
+            }
+        }
+    }
+}
+
+// NOTE: Board sizes stay below the threshold where StepLifeGrid() and LoadLifeGrid() call
+// ParallelFor(), which must not run from inside a job
+static bool LoadCensusWorker(CensusWorker *worker)
+{
+    worker->board = LoadLifeGrid(CENSUS_BOARD, CENSUS_BOARD, TOPOLOGY_DEAD_EDGE);
+    worker->object = LoadLifeGrid(CENSUS_OBJECT_GRID, CENSUS_OBJECT_GRID, TOPOLOGY_DEAD_EDGE);
+    worker->visited = calloc((size_t)CENSUS_BOARD*CENSUS_BOARD, 1);
+    worker->component = malloc((size_t)CENSUS_BOARD*CENSUS_BOARD*sizeof(int));
+    worker->shape = malloc((size_t)CENSUS_OBJECT_GRID*CENSUS_OBJECT_GRID);
+    worker->transformed = malloc((size_t)CENSUS_OBJECT_GRID*CENSUS_OBJECT_GRID);
+
+    return (worker->board.cells != NULL) && (worker->object.cells != NULL) && (worker->visited != NULL) &&
+        (worker->component != NULL) && (worker->shape != NULL) && (worker->transformed != NULL);
+}
+
+static void UnloadCensusWorker(CensusWorker *worker)
+{
+    if (worker->board.cells != NULL) UnloadLifeGrid(worker->board);
+    if (worker->object.cells != NULL) UnloadLifeGrid(worker->object);
+    free(worker->visited);
+    free(worker->component);
+    free(worker->shape);
+    free(worker->transformed);
+    UnloadCensusTable(&worker->table);
+}
+
+// Run one soup to stabilization and count its objects, returns the generations it took or -1
+static int RunSoup(CensusWorker *worker, uint64_t seed, int64_t soup, int maxGenerations)
+{
+    LifeGrid *board = &worker->board;
+    int lastWord = 1 + (board->cols - 1)/64;
+    ClearLifeGrid(board);
+
+    uint64_t state = seed + (uint64_t)soup*0x9E3779B97F4A7C15ULL;
+    int first = (CENSUS_BOARD - CENSUS_SOUP)/2;
+    for (int row = 0; row < CENSUS_SOUP; row += 4)
+    {
+        uint64_t bits = NextSplitMix(&state);
+        for (int i = 0; i < 4*CENSUS_SOUP; i++) SetLifeCell(board, first + row + i/CENSUS_SOUP, first + i%CENSUS_SOUP, (bits >> i) & 1);
+    }
+
+    // Only rows next to live cells are stepped, so the rows the other buffer
+    // last held outside them are cleared instead of being rewritten
+    RowSpan live = { first, first + CENSUS_SOUP };
+    RowSpan stale = { 0, 0 };
+    for (int generation = 1; generation <= maxGenerations; generation++)
+    {
+        RowSpan step = { (live.first > 0)? live.first - 1 : 0, (live.last < board->rows)? live.last + 1 : board->rows };
+        for (int row = stale.first; row < stale.last; row++)
+        {
+            if ((row < step.first) || (row >= step.last)) memset(LIFE_ROW(*board, board->next, row), 0, board->stride*sizeof(uint64_t));
+        }
+        StepLifeRows(board, step.first, step.last);
+        uint64_t *swap = board->cells;
+        board->cells = board->next;
+        board->next = swap;
+        stale = live;
+
+        // Border cells go, then the population and live rows are recounted
+        int population = 0;
+        live = (RowSpan){ step.last, step.first };
+        for (int row = step.first; row < step.last; row++)
+        {
+            uint64_t *cells = LIFE_ROW(*board, board->cells, row);
+            if ((row < CENSUS_BORDER) || (row >= board->rows - CENSUS_BORDER))
+            {
+                for (int w = 1; w <= lastWord; w++) worker->escaped += CountLifeBits(cells[w]);
+                memset(cells + 1, 0, lastWord*sizeof(uint64_t));
+                continue;
+            }
+
+            uint64_t edges = cells[1] & ((1ULL << CENSUS_BORDER) - 1);
+            uint64_t far = cells[lastWord] & ~(~0ULL >> CENSUS_BORDER);
+            worker->escaped += CountLifeBits(edges) + CountLifeBits(far);
+            cells[1] &= ~edges;
+            cells[lastWord] &= ~far;
+
+            int count = 0;
+            for (int w = 1; w <= lastWord; w++) count += CountLifeBits(cells[w]);
+            if (count == 0) continue;
+            population += count;
+            if (row < live.first) live.first = row;
+            live.last = row + 1;
+        }
+        if (population == 0) return generation;
+
+        int *history = worker->populations;
+        history[generation%CENSUS_HISTORY] = population;
+        for (int period = 1; period <= CENSUS_MAX_PERIOD; period++)
+        {
+            int window = (3*period > CENSUS_MIN_WINDOW)? 3*period : CENSUS_MIN_WINDOW;
+            if (generation < window + period) break;
+
+            int i = 0;
+            while ((i < window) && (history[(generation - i)%CENSUS_HISTORY] == history[(generation - i - period)%CENSUS_HISTORY])) i++;
+            if (i == window)
+            {
+                CountObjects(worker, soup, live);
+                return generation;
+            }
+        }
+    }
+
+    return -1;
+}
+
+// Label the 8-connected components of the stable board and count each by its apgcode
+static void CountObjects(CensusWorker *worker, int64_t soup, RowSpan live)
+{
+    const LifeGrid *board = &worker->board;
+    int cols = board->cols;
+    char code[CENSUS_CODE_LENGTH + 32];
+
+    for (int row = live.first; row < live.last; row++)
+    {
+        for (int col = 0; col < cols; col++)
+        {
+            size_t cell = (size_t)row*cols + col;
+            if (worker->visited[cell] || !GetLifeCell(*board, row, col)) continue;
+
+            // Flood fill, the component list doubles as the stack
+            int count = 0;
+            int next = 0;
+            int top = row, bottom = row, left = col, right = col;
+            worker->component[count++] = (int)cell;
+            worker->visited[cell] = 1;
+            while (next < count)
+            {
+                int r = worker->component[next]/cols;
+                int c = worker->component[next]%cols;
+                next++;
+                if (r < top) top = r;
+                if (r > bottom) bottom = r;
+                if (c < left) left = c;
+                if (c > right) right = c;
+
+                for (int dr = -1; dr <= 1; dr++)
+                {
+                    for (int dc = -1; dc <= 1; dc++)
+                    {
+                        int nr = r + dr, nc = c + dc;
+                        if ((nr < 0) || (nc < 0) || (nr >= board->rows) || (nc >= cols)) continue;
+                        size_t neighbour = (size_t)nr*cols + nc;
+                        if (worker->visited[neighbour] || !GetLifeCell(*board, nr, nc)) continue;
+                        worker->visited[neighbour] = 1;
+                        worker->component[count++] = (int)neighbour;
+                    }
+                }
+            }
+
+            int height = bottom - top + 1;
+            int width = right - left + 1;
+            if ((height > CENSUS_MAX_OBJECT) || (width > CENSUS_MAX_OBJECT)) strcpy(code, "zz_large");
+            else ClassifyObject(worker, count, top, left, height, width, code);
+            AddCensusEntry(&worker->table, code, 1, soup);
+            worker->objects++;
+        }
+    }
+
+    // Visited marks are cleared cell by cell, cheaper than the whole board
+    for (int row = live.first; row < live.last; row++) memset(worker->visited + (size_t)row*cols, 0, cols);
+}
+
+// Step one component alone until it comes back to its own shape and name it
+static void ClassifyObject(CensusWorker *worker, int count, int top, int left, int height, int width, char *code)
+{
+    LifeGrid *object = &worker->object;
+    int origin = CENSUS_MAX_PERIOD + 2;
+    int cols = worker->board.cols;
+    ClearLifeGrid(object);
+    for (int i = 0; i < count; i++)
+    {
+        int r = worker->component[i]/cols - top;
+        int c = worker->component[i]%cols - left;
+        SetLifeCell(object, origin + r, origin + c, true);
+    }
+
+    // Phase 0 as the reference, kept apart from the scratch bitmaps
+    uint8_t reference[CENSUS_MAX_OBJECT*CENSUS_MAX_OBJECT];
+    for (int r = 0; r < height; r++)
+    {
+        for (int c = 0; c < width; c++) reference[r*width + c] = GetLifeCell(*object, origin + r, origin + c);
+    }
+
+    char best[CENSUS_CODE_LENGTH];
+    best[0] = '\0';
+    memcpy(worker->shape, reference, (size_t)height*width);
+    EncodeShape(worker, height, width, best);
+
+    for (int period = 1; period <= CENSUS_MAX_PERIOD; period++)
+    {
+        StepLifeGrid(object);
+
+        // Nothing outruns light speed, so the object is within period cells of where it started
+        int shapeHeight, shapeWidth, population, shapeTop, shapeLeft;
+        if (!ExtractShape(worker, origin - period, origin - period, origin + height + period, origin + width + period,
+            &shapeHeight, &shapeWidth, &population, &shapeTop, &shapeLeft)) break;
+
+        if ((shapeHeight == height) && (shapeWidth == width) && (memcmp(worker->shape, reference, (size_t)height*width) == 0))
+        {
+            bool moved = (shapeTop != origin) || (shapeLeft != origin);
+            if (moved) sprintf(code, "xq%d_%s", period, best);
+            else if (period == 1) sprintf(code, "xs%d_%s", count, best);
+            else sprintf(code, "xp%d_%s", period, best);
+            return;
+        }
+
+        if ((shapeHeight > CENSUS_MAX_OBJECT) || (shapeWidth > CENSUS_MAX_OBJECT)) break;
+        EncodeShape(worker, shapeHeight, shapeWidth, best);
+    }
+
+    strcpy(code, "zz_pseudo");
+}
+
+// Copy the live cells inside [top, bottom)x[left, right) of the object grid to worker->shape,
+// cropped to their bounding box, returns false when there are none
+static bool ExtractShape(const CensusWorker *worker, int top, int left, int bottom, int right, int *height, int *width, int *population, int *shapeTop, int *shapeLeft)
+{
+    const LifeGrid *object = &worker->object;
+    if (top < 0) top = 0;
+    if (left < 0) left = 0;
+    if (bottom > object->rows) bottom = object->rows;
+    if (right > object->cols) right = object->cols;
+
+    int minRow = bottom, maxRow = -1, minCol = right, maxCol = -1;
+    *population = 0;
+    for (int r = top; r < bottom; r++)
+    {
+        for (int c = left; c < right; c++)
+        {
+            if (!GetLifeCell(*object, r, c)) continue;
+            (*population)++;
+            if (r < minRow) minRow = r;
+            if (r > maxRow) maxRow = r;
+            if (c < minCol) minCol = c;
+            if (c > maxCol) maxCol = c;
+        }
+    }
+    if (*population == 0) return false;
+
+    *height = maxRow - minRow + 1;
+    *width = maxCol - minCol + 1;
+    *shapeTop = minRow;
+    *shapeLeft = minCol;
+    for (int r = 0; r < *height; r++)
+    {
+        for (int c = 0; c < *width; c++) worker->shape[r*(*width) + c] = GetLifeCell(*object, minRow + r, minCol + c);
+    }
+    return true;
+}
+
+// Keep in best the shortest, then lowest, code of worker->shape over the 8 symmetries
+static void EncodeShape(CensusWorker *worker, int height, int width, char *best)
+{
+    if ((height > CENSUS_MAX_OBJECT) || (width > CENSUS_MAX_OBJECT)) return;
+
+    char code[CENSUS_CODE_LENGTH];
+    for (int symmetry = 0; symmetry < 8; symmetry++)
+    {
+        bool transpose = (symmetry & 4) != 0;
+        int outHeight = transpose? width : height;
+        int outWidth = transpose? height : width;
+        for (int r = 0; r < outHeight; r++)
+        {
+            for (int c = 0; c < outWidth; c++)
+            {
+                int sr = transpose? c : r;
+                int sc = transpose? r : c;
+                if (symmetry & 1) sr = height - 1 - sr;
+                if (symmetry & 2) sc = width - 1 - sc;
+                worker->transformed[r*outWidth + c] = worker->shape[sr*width + sc];
+            }
+        }
+
+        int length = EncodeWechsler(worker->transformed, outHeight, outWidth, code);
+        int bestLength = (int)strlen(best);
+        if ((bestLength == 0) || (length < bestLength) || ((length == bestLength) && (strcmp(code, best) < 0))) strcpy(best, code);
+    }
+}
+
+// Extended Wechsler code: 5 row strips separated by 'z', one base 32 digit per column
+// with the top row as bit 0, zero runs shortened to 'w' (2), 'x' (3) and 'y' plus a digit (4 up)
+static int EncodeWechsler(const uint8_t *cells, int height, int width, char *code)
+{
+    static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    int length = 0;
+
+    for (int strip = 0; strip < height; strip += 5)
+    {
+        if (strip > 0) code[length++] = 'z';
+
+        int zeros = 0;
+        for (int c = 0; c < width; c++)
+        {
+            int value = 0;
+            for (int bit = 0; (bit < 5) && (strip + bit < height); bit++) value |= cells[(strip + bit)*width + c] << bit;
+            if (value == 0)
+            {
+                zeros++;
+                continue;
+            }
+
+            // Zero columns before a live one, trailing zeros of a strip are dropped
+            while (zeros > 0)
+            {
+                if (zeros == 1) { code[length++] = '0'; zeros = 0; }
+                else if (zeros == 2) { code[length++] = 'w'; zeros = 0; }
+                else if (zeros == 3) { code[length++] = 'x'; zeros = 0; }
+                else
+                {
+                    int run = (zeros - 4 > 35)? 35 : zeros - 4;
+                    code[length++] = 'y';
+                    code[length++] = digits[run];
+                    zeros -= run + 4;
+                }
+            }
+            code[length++] = digits[value];
+        }
+    }
+
+    code[length] = '\0';
+    return length;
+}
+
+static void AddCensusEntry(CensusTable *table, const char *code, int64_t count, int64_t firstSoup)
+{
+    if (table->failed) return;
+
+    // Grow at half full, so probes stay short
+    if (2*(table->count + 1) > table->capacity)
+    {
+        int capacity = (table->capacity > 0)? 2*table->capacity : 64;
+        CensusEntry *entries = calloc(capacity, sizeof(CensusEntry));
+        if (entries == NULL)
+        {
+            table->failed = true;
+            return;
+        }
+        for (int i = 0; i < table->capacity; i++)
+        {
+            if (table->entries[i].code == NULL) continue;
+
+            uint32_t hash = 2166136261u;
+            for (const char *p = table->entries[i].code; *p != '\0'; p++) hash = (hash ^ (unsigned char)*p)*16777619u;
+            int slot = (int)(hash & (capacity - 1));
+            while (entries[slot].code != NULL) slot = (slot + 1) & (capacity - 1);
+            entries[slot] = table->entries[i];
+        }
+        free(table->entries);
+        table->entries = entries;
+        table->capacity = capacity;
+    }
+
+    uint32_t hash = 2166136261u;
+    for (const char *p = code; *p != '\0'; p++) hash = (hash ^ (unsigned char)*p)*16777619u;
+    int slot = (int)(hash & (table->capacity - 1));
+    while ((table->entries[slot].code != NULL) && (strcmp(table->entries[slot].code, code) != 0)) slot = (slot + 1) & (table->capacity - 1);
+
+    CensusEntry *entry = &table->entries[slot];
+    if (entry->code == NULL)
+    {
+        entry->code = malloc(strlen(code) + 1);
+        if (entry->code == NULL)
+        {
+            table->failed = true;
+            return;
+        }
+        strcpy(entry->code, code);
+        entry->firstSoup = firstSoup;
+        table->count++;
+    }
+    entry->count += count;
+    if (firstSoup < entry->firstSoup) entry->firstSoup = firstSoup;
+}
+
+static void UnloadCensusTable(CensusTable *table)
+{
+    for (int i = 0; i < table->capacity; i++) free(table->entries[i].code);
+    free(table->entries);
+    *table = (CensusTable){ 0 };
+}
+
+// Most common first, ties by code so census files diff cleanly
+static int CompareEntries(const void *a, const void *b)
+{
+    const CensusEntry *entryA = (const CensusEntry *)a;
+    const CensusEntry *entryB = (const CensusEntry *)b;
+    if (entryA->count != entryB->count) return (entryA->count > entryB->count)? -1 : 1;
+    return strcmp(entryA->code, entryB->code);
+}
+
+static uint64_t NextSplitMix(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
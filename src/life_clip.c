@@ -0,0 +1,492 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Region clips
+*
+*   Rectangles of cells cut out of a grid, turned and flipped, and blitted back: copy,
+*   paste, stamp and fill for the region editing tools.
+*
+*   A clip packs its rows like a grid without ghost cells, bit c%64 of word c/64 holding
+*   column c, and bits past the last column always clear. Every blit moves whole words: a
+*   destination word is made of two source words funnel shifted into place and merged
+*   through a mask of the columns it covers, so copying or pasting a 10000x10000 region
+*   costs about 1.5 million word operations spread over the ParallelFor() threads.
+*
+*   Turning a clip goes through 64x64 bit block transposes, flipping through reversed words.
+*   Patterns are loaded from RLE files into clips and stamped like any other clip.
+*
+*   Random fills are counter based: the 64 cells of grid word w in row r come from hashes of
+*   (seed, r, w, draw) alone, so a seed gives the same cells whatever the region filled, the
+*   thread count or the order words are visited in. A cell is alive when its random 64 bit
+*   fraction falls below density*2^64, drawn a bit at a time from the top, which makes the
+*   density exact to 2^-64 for a handful of draws per word. Draws run over NOISE_LANES words at
+*   once in plain loops the compiler vectorizes where the target has 64 bit multiplies.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define CLIP_PARALLEL_WORDS 16384       // Smaller blits finish before the pool wakes up
+#define CLIP_MAX_PATTERN (1 << 20)      // Widest and tallest RLE pattern loaded
+#define NOISE_LANES 16                  // Words of random cells drawn side by side
+#define NOISE_GAMMA 0x9E3779B97F4A7C15ULL   // Golden ratio step between the draws of a word
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct BlitJob {
+    LifeGrid *grid;
+    LifeClip clip;
+    int row;                // Grid cell under the top left clip cell, may lie off the grid
+    int col;
+    ClipBlend blend;
+    bool fill;              // Blit every clip cell as alive instead of reading the clip, for fills
+    uint64_t threshold;     // Random cells are alive when their 64 bit fraction falls below this, never 0
+    int lowestBit;          // Lowest set bit of threshold, cells still undecided past it are dead
+    uint64_t key;           // Hashed seed of the random cells
+} BlitJob;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static void CopyRows(void *data, int begin, int end);
+static void BlitRows(void *data, int begin, int end);
+static void NoiseRows(void *data, int begin, int end);
+static void NoiseClipRows(void *data, int begin, int end);
+static void RunBlit(BlitJob *job, void (*rows)(void *, int, int), int count);
+static bool SetNoiseDensity(BlitJob *job, double density, uint64_t seed);
+static void FillNoise(uint64_t *noise, const BlitJob *job, int row, int word);
+static uint64_t MixBits(uint64_t bits);
+static uint64_t ReadBits(const uint64_t *words, int count, int bit);
+static uint64_t GetColumnMask(int from, int to);
+static void TransposeBlock(uint64_t *block);
+static uint64_t ReverseBits(uint64_t bits);
+
+//----------------------------------------------------------------------------------
+// Clip Functions Definition
+//----------------------------------------------------------------------------------
+
+// Dead clip, cells is NULL on failure
+LifeClip LoadLifeClip(int rows, int cols)
+{
+    LifeClip clip = { 0 };
+    if ((rows <= 0) || (cols <= 0)) return clip;
+
+    clip.rows = rows;
+    clip.cols = cols;
+    clip.stride = (cols + 63)/64;
+    clip.cells = calloc((size_t)rows*clip.stride, sizeof(uint64_t));
+    return clip;
+}
+
+void UnloadLifeClip(LifeClip clip)
+{
+    free(clip.cells);
+}
+
+// Cells of a rectangle of grid, cells off the grid come out dead
+LifeClip CopyLifeRegion(LifeGrid grid, int row, int col, int rows, int cols)
+{
+    LifeClip clip = LoadLifeClip(rows, cols);
+    if (clip.cells == NULL) return clip;
+
+    BlitJob job = { .grid = &grid, .clip = clip, .row = row, .col = col, .blend = CLIP_REPLACE };
+    RunBlit(&job, CopyRows, rows);
+    return clip;
+}
+
+// Blit clip with its top left cell over (row, col), cells falling off the grid are dropped
+void PasteLifeClip(LifeGrid *grid, LifeClip clip, int row, int col, ClipBlend blend)
+{
+    if (clip.cells == NULL) return;
+
+    BlitJob job = { .grid = grid, .clip = clip, .row = row, .col = col, .blend = blend };
+    RunBlit(&job, BlitRows, clip.rows);
+    MarkLifeChanges(grid, row, col, clip.rows, clip.cols);
+}
+
+// Set every cell of a rectangle, clipped to the grid
+void FillLifeRegion(LifeGrid *grid, int row, int col, int rows, int cols, bool alive)
+{
+    if ((rows <= 0) || (cols <= 0)) return;
+
+    LifeClip shape = { rows, cols, (cols + 63)/64, NULL };
+    BlitJob job = { .grid = grid, .clip = shape, .row = row, .col = col, .blend = alive? CLIP_STAMP : CLIP_ERASE, .fill = true };
+    RunBlit(&job, BlitRows, rows);
+    MarkLifeChanges(grid, row, col, rows, cols);
+}
+
+// Cells of a rectangle alive with probability density, clipped to the grid
+// NOTE: A cell only depends on seed and its position, filling a larger region with the same seed gives the same cells
+void RandomizeLifeRegion(LifeGrid *grid, int row, int col, int rows, int cols, double density, uint64_t seed)
+{
+    if ((rows <= 0) || (cols <= 0)) return;
+
+    LifeClip shape = { rows, cols, (cols + 63)/64, NULL };
+    BlitJob job = { .grid = grid, .clip = shape, .row = row, .col = col, .blend = CLIP_REPLACE };
+    if (!SetNoiseDensity(&job, density, seed))
+    {
+        FillLifeRegion(grid, row, col, rows, cols, density >= 1.0);
+        return;
+    }
+    RunBlit(&job, NoiseRows, rows);
+    MarkLifeChanges(grid, row, col, rows, cols);
+}
+
+// Random cells RandomizeLifeRegion() would put in a rectangle, into a clip, cells is NULL on failure
+LifeClip LoadLifeNoise(int row, int col, int rows, int cols, double density, uint64_t seed)
+{
+    LifeClip clip = LoadLifeClip(rows, cols);
+    if (clip.cells == NULL) return clip;
+
+    BlitJob job = { .clip = clip, .row = row, .col = col, .blend = CLIP_REPLACE };
+    if (SetNoiseDensity(&job, density, seed)) RunBlit(&job, NoiseClipRows, rows);
+    else if (density >= 1.0)
+    {
+        for (int r = 0; r < rows; r++)
+        {
+            for (int w = 0; w < clip.stride; w++) clip.cells[(size_t)r*clip.stride + w] = GetColumnMask(0, cols - 64*w);
+        }
+    }
+    return clip;
+}
+
+// Quarter turn clockwise into a new clip, cells is NULL on failure
+LifeClip RotateLifeClip(LifeClip clip)
+{
+    LifeClip turned = LoadLifeClip(clip.cols, clip.rows);
+    if ((turned.cells == NULL) || (clip.cells == NULL)) return turned;
+
+    // Transpose one 64x64 block at a time, block (i, j) lands on block (j, i)
+    uint64_t block[64];
+    for (int i = 0; i < (clip.rows + 63)/64; i++)
+    {
+        for (int j = 0; j < clip.stride; j++)
+        {
+            for (int k = 0; k < 64; k++) block[k] = (64*i + k < clip.rows)? clip.cells[(size_t)(64*i + k)*clip.stride + j] : 0;
+            TransposeBlock(block);
+            for (int k = 0; (k < 64) && (64*j + k < turned.rows); k++) turned.cells[(size_t)(64*j + k)*turned.stride + i] = block[k];
+        }
+    }
+
+    // Transposed and mirrored left to right is a clockwise turn
+    FlipLifeClip(&turned, true);
+    return turned;
+}
+
+// Mirror a clip in place, left to right when horizontal, top to bottom otherwise
+void FlipLifeClip(LifeClip *clip, bool horizontal)
+{
+    if (clip->cells == NULL) return;
+
+    if (!horizontal)
+    {
+        for (int top = 0, bottom = clip->rows - 1; top < bottom; top++, bottom--)
+        {
+            uint64_t *a = clip->cells + (size_t)top*clip->stride;
+            uint64_t *b = clip->cells + (size_t)bottom*clip->stride;
+            for (int w = 0; w < clip->stride; w++)
+            {
+                uint64_t swap = a[w];
+                a[w] = b[w];
+                b[w] = swap;
+            }
+        }
+        return;
+    }
+
+    // Reversing the words of a row mirrors all stride*64 bits, the padding then sits in front
+    uint64_t *reversed = malloc(clip->stride*sizeof(uint64_t));
+    if (reversed == NULL) return;
+
+    int padding = clip->stride*64 - clip->cols;
+    for (int row = 0; row < clip->rows; row++)
+    {
+        uint64_t *cells = clip->cells + (size_t)row*clip->stride;
+        for (int w = 0; w < clip->stride; w++) reversed[w] = ReverseBits(cells[clip->stride - 1 - w]);
+        for (int w = 0; w < clip->stride; w++) cells[w] = ReadBits(reversed, clip->stride, 64*w + padding);
+    }
+    free(reversed);
+}
+
+// Pattern from an RLE file, with "x = <cols>, y = <rows>" as its first line after comments
+// NOTE: Any cell letter but 'b' is alive, cells is NULL when the file is missing or malformed
+LifeClip LoadLifePattern(const char *fileName)
+{
+    LifeClip clip = { 0 };
+    FILE *file = fopen(fileName, "r");
+    if (file == NULL) return clip;
+
+    char line[1024];
+    int cols = 0, rows = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        if (line[0] == '#') continue;
+        if (sscanf(line, " x = %d , y = %d", &cols, &rows) != 2) cols = rows = 0;
+        break;
+    }
+    if ((cols <= 0) || (rows <= 0) || (cols > CLIP_MAX_PATTERN) || (rows > CLIP_MAX_PATTERN))
+    {
+        fclose(file);
+        return clip;
+    }
+
+    clip = LoadLifeClip(rows, cols);
+    int row = 0, col = 0, count = 0;
+    bool done = false;
+    for (int c = fgetc(file); (clip.cells != NULL) && !done && (c != EOF); c = fgetc(file))
+    {
+        if ((c >= '0') && (c <= '9'))
+        {
+            count = (count > CLIP_MAX_PATTERN)? count : count*10 + (c - '0');
+            continue;
+        }
+        if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n')) continue;
+
+        int run = (count > 0)? count : 1;
+        count = 0;
+        if (c == '!') done = true;
+        else if (c == '$')
+        {
+            row += run;
+            col = 0;
+        }
+        else if (c == 'b') col += run;
+        else
+        {
+            for (int i = 0; (i < run) && (col < cols); i++, col++)
+            {
+                if (row < rows) clip.cells[(size_t)row*clip.stride + col/64] |= 1ULL << (col%64);
+            }
+        }
+    }
+    fclose(file);
+
+    return clip;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Clip rows [begin, end) read from the grid
+static void CopyRows(void *data, int begin, int end)
+{
+    BlitJob *job = (BlitJob *)data;
+    LifeGrid grid = *job->grid;
+    int gridWords = (grid.cols + 63)/64;
+
+    for (int r = begin; r < end; r++)
+    {
+        uint64_t *cells = job->clip.cells + (size_t)r*job->clip.stride;
+        int row = job->row + r;
+        if ((row < 0) || (row >= grid.rows))
+        {
+            memset(cells, 0, job->clip.stride*sizeof(uint64_t));
+            continue;
+        }
+
+        // Grid columns past the last one hold the ghost cell, masked off like columns before the first
+        const uint64_t *source = LIFE_ROW(grid, grid.cells, row) + 1;
+        for (int w = 0; w < job->clip.stride; w++)
+        {
+            int first = job->col + 64*w;
+            uint64_t mask = GetColumnMask(-first, grid.cols - first) & GetColumnMask(0, job->clip.cols - 64*w);
+            cells[w] = ReadBits(source, gridWords, first) & mask;
+        }
+    }
+}
+
+// Clip rows [begin, end) written to the grid, one grid word at a time
+static void BlitRows(void *data, int begin, int end)
+{
+    BlitJob *job = (BlitJob *)data;
+    LifeGrid *grid = job->grid;
+    int left = (job->col > 0)? job->col : 0;
+    int right = (job->col + job->clip.cols < grid->cols)? job->col + job->clip.cols : grid->cols;
+    if (left >= right) return;
+
+    for (int r = begin; r < end; r++)
+    {
+        int row = job->row + r;
+        if ((row < 0) || (row >= grid->rows)) continue;
+
+        uint64_t *target = LIFE_ROW(*grid, grid->cells, row) + 1;
+        const uint64_t *source = job->fill? NULL : job->clip.cells + (size_t)r*job->clip.stride;
+        for (int w = left/64; w <= (right - 1)/64; w++)
+        {
+            uint64_t mask = GetColumnMask(left - 64*w, right - 64*w);
+            uint64_t bits = job->fill? ~0ULL : ReadBits(source, job->clip.stride, 64*w - job->col);
+            switch (job->blend)
+            {
+                case CLIP_REPLACE: target[w] = (target[w] & ~mask) | (bits & mask); break;
+                case CLIP_STAMP: target[w] |= bits & mask; break;
+                case CLIP_ERASE: target[w] &= ~(bits & mask); break;
+                case CLIP_XOR: target[w] ^= bits & mask; break;
+            }
+        }
+    }
+}
+
+// Grid rows [begin, end) of the region replaced by random cells, NOISE_LANES words at a time
+static void NoiseRows(void *data, int begin, int end)
+{
+    BlitJob *job = (BlitJob *)data;
+    LifeGrid *grid = job->grid;
+    int left = (job->col > 0)? job->col : 0;
+    int right = (job->col + job->clip.cols < grid->cols)? job->col + job->clip.cols : grid->cols;
+    if (left >= right) return;
+
+    uint64_t noise[NOISE_LANES];
+    for (int r = begin; r < end; r++)
+    {
+        int row = job->row + r;
+        if ((row < 0) || (row >= grid->rows)) continue;
+
+        uint64_t *target = LIFE_ROW(*grid, grid->cells, row) + 1;
+        for (int w = left/64; w <= (right - 1)/64; w += NOISE_LANES)
+        {
+            FillNoise(noise, job, row, w);
+            for (int k = 0; (k < NOISE_LANES) && (w + k <= (right - 1)/64); k++)
+            {
+                uint64_t mask = GetColumnMask(left - 64*(w + k), right - 64*(w + k));
+                target[w + k] = (target[w + k] & ~mask) | (noise[k] & mask);
+            }
+        }
+    }
+}
+
+// Clip rows [begin, end) of random cells, grid aligned words shifted over to the clip columns
+static void NoiseClipRows(void *data, int begin, int end)
+{
+    BlitJob *job = (BlitJob *)data;
+    int first = (job->col >= 0)? job->col/64 : -((63 - job->col)/64);
+    int shift = job->col - 64*first;
+
+    uint64_t noise[NOISE_LANES];
+    for (int r = begin; r < end; r++)
+    {
+        uint64_t *cells = job->clip.cells + (size_t)r*job->clip.stride;
+        for (int w = 0; w < job->clip.stride; w += NOISE_LANES - 1)
+        {
+            FillNoise(noise, job, job->row + r, first + w);
+            for (int k = 0; (k < NOISE_LANES - 1) && (w + k < job->clip.stride); k++)
+            {
+                cells[w + k] = ReadBits(noise, NOISE_LANES, shift + 64*k) & GetColumnMask(0, job->clip.cols - 64*(w + k));
+            }
+        }
+    }
+}
+
+static void RunBlit(BlitJob *job, void (*rows)(void *, int, int), int count)
+{
+    if ((size_t)count*job->clip.stride >= CLIP_PARALLEL_WORDS) ParallelFor(count, rows, job);
+    else rows(job, 0, count);
+}
+
+// Threshold of a density, false when every cell comes out the same and no draws are needed
+static bool SetNoiseDensity(BlitJob *job, double density, uint64_t seed)
+{
+    if (!(density > 0.0) || (density >= 1.0)) return false;
+
+    job->threshold = (uint64_t)(density*18446744073709551616.0);
+    if (job->threshold == 0) return false;
+
+    job->lowestBit = 0;
+    while (((job->threshold >> job->lowestBit) & 1) == 0) job->lowestBit++;
+    job->key = MixBits(seed);
+    return true;
+}
+
+// NOISE_LANES words of random cells from grid word of row on
+// NOTE: Draws compare each cell with the threshold a bit at a time from the top, a cell is settled by the first bit
+// that differs, so a group of words usually stops after 8 to 10 draws. Cells already settled never change, stopping
+// early gives the same bits as drawing all 64
+static void FillNoise(uint64_t *noise, const BlitJob *job, int row, int word)
+{
+    uint64_t counter[NOISE_LANES];
+    uint64_t open[NOISE_LANES];
+    for (int k = 0; k < NOISE_LANES; k++)
+    {
+        counter[k] = MixBits(job->key ^ (((uint64_t)(uint32_t)row << 32) | (uint32_t)(word + k)));
+        open[k] = ~0ULL;
+        noise[k] = 0;
+    }
+
+    for (int bit = 63; bit >= job->lowestBit; bit--)
+    {
+        uint64_t below = ((job->threshold >> bit) & 1)? ~0ULL : 0;
+        uint64_t undecided = 0;
+        for (int k = 0; k < NOISE_LANES; k++)
+        {
+            uint64_t draw = MixBits(counter[k] + (uint64_t)bit*NOISE_GAMMA);
+            noise[k] |= open[k] & below & ~draw;
+            open[k] &= ~(draw ^ below);
+            undecided |= open[k];
+        }
+        if (undecided == 0) break;
+    }
+}
+
+// Bijective 64 bit hash, two multiply rounds of the SplitMix64 finalizer kind
+static uint64_t MixBits(uint64_t bits)
+{
+    bits = (bits ^ (bits >> 32))*0xD6E8FEB86659FD93ULL;
+    bits = (bits ^ (bits >> 32))*0xD6E8FEB86659FD93ULL;
+    return bits ^ (bits >> 32);
+}
+
+// 64 bits from bit on, bits before 0 or past count words read as clear
+static uint64_t ReadBits(const uint64_t *words, int count, int bit)
+{
+    if ((bit <= -64) || (bit >= count*64)) return 0;
+
+    int shift = ((bit%64) + 64)%64;
+    int word = (bit - shift)/64;
+    uint64_t low = (word >= 0)? words[word] : 0;
+    uint64_t high = (word + 1 < count)? words[word + 1] : 0;
+
+    return (shift == 0)? low : (low >> shift) | (high << (64 - shift));
+}
+
+// Bits [from, to) of one word, both clamped to [0, 64]
+static uint64_t GetColumnMask(int from, int to)
+{
+    if (from < 0) from = 0;
+    if (to > 64) to = 64;
+    if (from >= to) return 0;
+
+    uint64_t high = (to == 64)? ~0ULL : ((1ULL << to) - 1);
+    return high & ~((1ULL << from) - 1);
+}
+
+// Transpose a 64x64 bit matrix in place, bit c of word r swaps with bit r of word c
+static void TransposeBlock(uint64_t *block)
+{
+    uint64_t mask = 0x00000000FFFFFFFFULL;
+    for (int width = 32; width != 0; width >>= 1, mask ^= mask << width)
+    {
+        for (int k = 0; k < 64; k = (k + width + 1) & ~width)
+        {
+            uint64_t swap = ((block[k] >> width) ^ block[k + width]) & mask;
+            block[k] ^= swap << width;
+            block[k + width] ^= swap;
+        }
+    }
+}
+
+static uint64_t ReverseBits(uint64_t bits)
+{
+    bits = ((bits >> 1) & 0x5555555555555555ULL) | ((bits & 0x5555555555555555ULL) << 1);
+    bits = ((bits >> 2) & 0x3333333333333333ULL) | ((bits & 0x3333333333333333ULL) << 2);
+    bits = ((bits >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((bits & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    bits = ((bits >> 8) & 0x00FF00FF00FF00FFULL) | ((bits & 0x00FF00FF00FF00FFULL) << 8);
+    bits = ((bits >> 16) & 0x0000FFFF0000FFFFULL) | ((bits & 0x0000FFFF0000FFFFULL) << 16);
+    return (bits >> 32) | (bits << 32);
+}
@@ -0,0 +1,693 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Domain decomposition
+*
+*   Splits a board into rectangular subdomains, each stepped by its own worker process. The
+*   coordinator only knows the board size: every worker loads its own subdomain through a
+*   loader callback, so a board can be larger than any one process could hold.
+*
+*   Every worker keeps its subdomain plus a halo of h cells on each side. Errors from the
+*   halo edge move inward one cell per generation, so after refreshing the halo a worker can
+*   step up to h generations on its own. Workers then publish the h cells along the border of
+*   their subdomain in a shared memory outbox and read their halo from their neighbours'
+*   outboxes. Outboxes are double buffered and a barrier per exchange keeps a worker from
+*   overwriting cells a neighbour is still reading.
+*
+*   The coordinator, the process that started the cluster, talks to every worker over a
+*   socket pair: it sends the generations to run and collects population and timing once
+*   they are done, or gathers the cells under a window of the board into a grid of its own.
+*
+*   Cells move between grids, outboxes and sockets a word at a time. Outbox rows start on a
+*   word: the h top and bottom rows hold the whole subdomain width, the left and right column
+*   strips hold the h end cells of every row.
+*
+*   Torus and mirror boards fill halos past the board edge by wrapping or reflecting. Dead
+*   edge boards have no halo along the board edge, the worker grid border is dead already.
+*
+*   NOTE: Workers are forked, so the cluster is for POSIX systems and must be started from a
+*   process that can fork safely, Windows builds never start one. They step plain B3/S23.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#if !defined(_WIN32)
+
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define CLUSTER_MAX_WORKERS 256
+#define CLUSTER_SPINS 4096          // Barrier polls before yielding the core
+
+#if defined(MSG_NOSIGNAL)
+    #define CLUSTER_SEND_FLAGS MSG_NOSIGNAL
+#else
+    #define CLUSTER_SEND_FLAGS 0
+#endif
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum ClusterCommandType { CLUSTER_RUN = 1, CLUSTER_GATHER, CLUSTER_STOP } ClusterCommandType;
+
+typedef struct ClusterCommand {
+    int32_t type;
+    int32_t generations;
+    int32_t row;                // Subdomain rectangle to gather
+    int32_t col;
+    int32_t rows;
+    int32_t cols;
+} ClusterCommand;
+
+typedef struct ClusterReply {
+    int64_t generation;
+    int64_t population;         // Live cells of the subdomain
+    double exchangeSeconds;     // Time spent in barriers and halo copies during the last run
+} ClusterReply;
+
+// Sense reversing barrier shared by the workers
+typedef struct ClusterBarrier {
+    uint32_t waiting;
+    uint32_t sense;
+} ClusterBarrier;
+
+// Subdomain of one worker and where its outboxes sit in the shared mapping
+typedef struct ClusterBlock {
+    int firstRow;
+    int firstCol;
+    int rows;
+    int cols;
+    size_t outbox[2];           // Word offsets of the two outbox buffers
+    size_t rowWords;            // Words per row strip row and per column strip row
+    size_t haloWords;
+} ClusterBlock;
+
+struct LifeCluster {
+    ClusterSettings settings;
+    int rows;
+    int cols;
+    GridTopology topology;
+    int workers;
+    ClusterBlock blocks[CLUSTER_MAX_WORKERS];
+    int *rowOwner;              // Block row of every board row
+    int *colOwner;              // Block column of every board column
+
+    void *shared;               // Barrier followed by the outboxes
+    size_t sharedSize;
+    pid_t pids[CLUSTER_MAX_WORKERS];
+    int sockets[CLUSTER_MAX_WORKERS];
+    bool failed;                // A worker died or stopped answering
+    ClusterStats stats;
+};
+
+// Worker side view of its own subdomain
+typedef struct ClusterWorker {
+    LifeCluster *cluster;
+    int index;
+    LifeGrid grid;              // Subdomain with its halo
+    int haloTop;
+    int haloLeft;
+    int parity;                 // Outbox holding the current generation
+    uint32_t sense;
+    int64_t generation;
+} ClusterWorker;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static void RunClusterWorker(LifeCluster *cluster, int index, ClusterLoader loader, void *data, int socket);
+static void WaitClusterBarrier(ClusterWorker *worker);
+static void WriteOutbox(ClusterWorker *worker);
+static void FillHalo(ClusterWorker *worker);
+static void FillHaloRun(ClusterWorker *worker, uint64_t *cells, int boardRow, int col, int end);
+static int64_t CountSubdomain(const ClusterWorker *worker);
+static const uint64_t *GetBorderRow(const ClusterBlock *block, const uint64_t *outbox, int halo, int row, int *col);
+static int MapBoardIndex(GridTopology topology, int value, int size);
+static void CopyCells(uint64_t *words, const uint64_t *cells, size_t bit, int count);
+static uint64_t ReadBits(const uint64_t *words, size_t bit, int count);
+static void WriteBits(uint64_t *words, size_t bit, uint64_t bits, int count);
+static uint64_t ReverseBits(uint64_t bits);
+static bool SendAll(int socket, const void *data, size_t size);
+static bool ReceiveAll(int socket, void *data, size_t size);
+
+//----------------------------------------------------------------------------------
+// Cluster Functions Definition
+//----------------------------------------------------------------------------------
+
+// Fork one worker per subdomain of a rows x cols board, each loading its own cells with loader
+// NOTE: Returns NULL when the split does not fit the halo, workers can not be started or a loader failed
+LifeCluster *StartLifeCluster(ClusterSettings settings, int rows, int cols, GridTopology topology, ClusterLoader loader, void *data)
+{
+    int workers = settings.tileRows*settings.tileCols;
+    if ((settings.tileRows <= 0) || (settings.tileCols <= 0) || (workers > CLUSTER_MAX_WORKERS) || (settings.halo <= 0)) return NULL;
+
+    // Halo cells must come from the border strips of the neighbouring subdomains
+    int minRows = rows/settings.tileRows;
+    int minCols = cols/settings.tileCols;
+    if ((minRows < settings.halo) || (minCols < settings.halo)) return NULL;
+
+    LifeCluster *cluster = calloc(1, sizeof(LifeCluster));
+    if (cluster == NULL) return NULL;
+
+    cluster->settings = settings;
+    cluster->rows = rows;
+    cluster->cols = cols;
+    cluster->topology = topology;
+    cluster->workers = workers;
+    cluster->rowOwner = malloc(rows*sizeof(int));
+    cluster->colOwner = malloc(cols*sizeof(int));
+    if ((cluster->rowOwner == NULL) || (cluster->colOwner == NULL))
+    {
+        free(cluster->rowOwner);
+        free(cluster->colOwner);
+        free(cluster);
+        return NULL;
+    }
+
+    // Even split, outboxes hold two h wide rows and two h wide columns of border cells
+    int halo = settings.halo;
+    size_t words = (sizeof(ClusterBarrier) + sizeof(uint64_t) - 1)/sizeof(uint64_t);
+    for (int i = 0; i < settings.tileRows; i++)
+    {
+        for (int j = 0; j < settings.tileCols; j++)
+        {
+            ClusterBlock *block = &cluster->blocks[i*settings.tileCols + j];
+            block->firstRow = (int)((int64_t)rows*i/settings.tileRows);
+            block->firstCol = (int)((int64_t)cols*j/settings.tileCols);
+            block->rows = (int)((int64_t)rows*(i + 1)/settings.tileRows) - block->firstRow;
+            block->cols = (int)((int64_t)cols*(j + 1)/settings.tileCols) - block->firstCol;
+            block->rowWords = (block->cols + 63)/64;
+            block->haloWords = (halo + 63)/64;
+
+            for (int p = 0; p < 2; p++)
+            {
+                block->outbox[p] = words;
+                words += 2*(size_t)halo*block->rowWords + 2*(size_t)block->rows*block->haloWords;
+            }
+        }
+    }
+    for (int i = 0; i < settings.tileRows; i++)
+    {
+        ClusterBlock *block = &cluster->blocks[i*settings.tileCols];
+        for (int row = block->firstRow; row < block->firstRow + block->rows; row++) cluster->rowOwner[row] = i;
+    }
+    for (int j = 0; j < settings.tileCols; j++)
+    {
+        ClusterBlock *block = &cluster->blocks[j];
+        for (int col = block->firstCol; col < block->firstCol + block->cols; col++) cluster->colOwner[col] = j;
+    }
+
+    // Anonymous shared mapping, created before forking so every worker inherits it
+    cluster->sharedSize = words*sizeof(uint64_t);
+    cluster->shared = mmap(NULL, cluster->sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (cluster->shared == MAP_FAILED)
+    {
+        free(cluster->rowOwner);
+        free(cluster->colOwner);
+        free(cluster);
+        return NULL;
+    }
+
+    int started = 0;
+    for (; started < workers; started++)
+    {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) break;
+
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            // Worker keeps only its end of its own channel
+            for (int i = 0; i < started; i++) close(cluster->sockets[i]);
+            close(pair[0]);
+            RunClusterWorker(cluster, started, loader, data, pair[1]);
+            _exit(0);
+        }
+        close(pair[1]);
+        if (pid < 0)
+        {
+            close(pair[0]);
+            break;
+        }
+        cluster->pids[started] = pid;
+        cluster->sockets[started] = pair[0];
+    }
+
+    // Workers answer once their first outbox is written
+    bool ready = (started == workers);
+    for (int i = 0; ready && (i < workers); i++)
+    {
+        ClusterReply reply;
+        ready = ReceiveAll(cluster->sockets[i], &reply, sizeof(reply));
+    }
+    if (!ready)
+    {
+        cluster->workers = started;
+        cluster->failed = true;
+        StopLifeCluster(cluster);
+        return NULL;
+    }
+
+    return cluster;
+}
+
+// Advance every subdomain, returns false once a worker failed
+bool StepLifeCluster(LifeCluster *cluster, int generations)
+{
+    if (cluster->failed) return false;
+    if (generations <= 0) return true;
+
+    double start = GetLifeSeconds();
+    ClusterCommand command = { CLUSTER_RUN, generations, 0, 0, 0, 0 };
+    for (int i = 0; i < cluster->workers; i++)
+    {
+        if (!SendAll(cluster->sockets[i], &command, sizeof(command))) cluster->failed = true;
+    }
+
+    int64_t population = 0;
+    double exchangeSeconds = 0.0;
+    for (int i = 0; (i < cluster->workers) && !cluster->failed; i++)
+    {
+        ClusterReply reply;
+        if (!ReceiveAll(cluster->sockets[i], &reply, sizeof(reply)))
+        {
+            cluster->failed = true;
+            break;
+        }
+        population += reply.population;
+        if (reply.exchangeSeconds > exchangeSeconds) exchangeSeconds = reply.exchangeSeconds;
+        cluster->stats.generation = reply.generation;
+    }
+    if (cluster->failed) return false;
+
+    cluster->stats.population = population;
+    cluster->stats.stepSeconds = GetLifeSeconds() - start;
+    cluster->stats.exchangeSeconds = exchangeSeconds;
+    return true;
+}
+
+ClusterStats GetLifeClusterStats(const LifeCluster *cluster)
+{
+    ClusterStats stats = cluster->stats;
+    stats.workers = cluster->workers;
+    return stats;
+}
+
+// Copy the board cells under window, its top left cell sitting on board cell (row, col)
+// NOTE: Window cells past the board edge are left as they are, only the workers owning cells under the window send any
+bool GatherLifeCluster(LifeCluster *cluster, LifeGrid *window, int row, int col)
+{
+    if (cluster->failed) return false;
+
+    for (int i = 0; (i < cluster->workers) && !cluster->failed; i++)
+    {
+        const ClusterBlock *block = &cluster->blocks[i];
+        int top = (row > block->firstRow)? row : block->firstRow;
+        int left = (col > block->firstCol)? col : block->firstCol;
+        int bottom = (row + window->rows < block->firstRow + block->rows)? row + window->rows : block->firstRow + block->rows;
+        int right = (col + window->cols < block->firstCol + block->cols)? col + window->cols : block->firstCol + block->cols;
+        if ((top >= bottom) || (left >= right)) continue;
+
+        ClusterCommand command = { CLUSTER_GATHER, 0, top - block->firstRow, left - block->firstCol, bottom - top, right - left };
+        int words = (command.cols + 63)/64;
+        uint64_t *rowBits = malloc(words*sizeof(uint64_t));
+        if ((rowBits == NULL) || !SendAll(cluster->sockets[i], &command, sizeof(command))) cluster->failed = true;
+
+        // Rows arrive packed from the first gathered column
+        for (int r = top; (r < bottom) && !cluster->failed; r++)
+        {
+            if (!ReceiveAll(cluster->sockets[i], rowBits, words*sizeof(uint64_t)))
+            {
+                cluster->failed = true;
+                break;
+            }
+
+            uint64_t *cells = LIFE_ROW(*window, window->cells, r - row) + 1;
+            for (int w = 0; w < words; w++)
+            {
+                int count = (command.cols - 64*w < 64)? command.cols - 64*w : 64;
+                WriteBits(cells, (size_t)(left - col) + 64*w, rowBits[w], count);
+            }
+        }
+        free(rowBits);
+        MarkLifeChanges(window, top - row, left - col, bottom - top, right - left);
+    }
+
+    return !cluster->failed;
+}
+
+// Stop the workers and release the shared mapping
+void StopLifeCluster(LifeCluster *cluster)
+{
+    if (cluster == NULL) return;
+
+    ClusterCommand command = { CLUSTER_STOP, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < cluster->workers; i++)
+    {
+        // A failed cluster may have workers stuck in a barrier waiting for a dead one
+        if (cluster->failed) kill(cluster->pids[i], SIGKILL);
+        else SendAll(cluster->sockets[i], &command, sizeof(command));
+        close(cluster->sockets[i]);
+    }
+    for (int i = 0; i < cluster->workers; i++) waitpid(cluster->pids[i], NULL, 0);
+
+    munmap(cluster->shared, cluster->sharedSize);
+    free(cluster->rowOwner);
+    free(cluster->colOwner);
+    free(cluster);
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Worker process: load the subdomain, then serve commands until told to stop
+static void RunClusterWorker(LifeCluster *cluster, int index, ClusterLoader loader, void *data, int socket)
+{
+    ClusterWorker worker = { 0 };
+    const ClusterBlock *block = &cluster->blocks[index];
+    int halo = cluster->settings.halo;
+    bool dead = (cluster->topology == TOPOLOGY_DEAD_EDGE);
+
+    // Along a dead board edge the worker grid border itself is the board edge
+    worker.cluster = cluster;
+    worker.index = index;
+    worker.haloTop = (dead && (block->firstRow == 0))? 0 : halo;
+    worker.haloLeft = (dead && (block->firstCol == 0))? 0 : halo;
+    int haloBottom = (dead && (block->firstRow + block->rows == cluster->rows))? 0 : halo;
+    int haloRight = (dead && (block->firstCol + block->cols == cluster->cols))? 0 : halo;
+
+    SetParallelWorkers((cluster->settings.threads > 0)? cluster->settings.threads : 1);
+    worker.grid = LoadLifeGrid(worker.haloTop + block->rows + haloBottom, worker.haloLeft + block->cols + haloRight, TOPOLOGY_DEAD_EDGE);
+    if (worker.grid.cells == NULL) return;
+
+    LifeClip cells = loader(data, block->firstRow, block->firstCol, block->rows, block->cols);
+    if ((cells.cells == NULL) || (cells.rows != block->rows) || (cells.cols != block->cols))
+    {
+        UnloadLifeClip(cells);
+        UnloadLifeGrid(worker.grid);
+        return;
+    }
+    PasteLifeClip(&worker.grid, cells, worker.haloTop, worker.haloLeft, CLIP_REPLACE);
+    UnloadLifeClip(cells);
+    WriteOutbox(&worker);
+
+    ClusterReply reply = { 0 };
+    if (!SendAll(socket, &reply, sizeof(reply)))
+    {
+        UnloadLifeGrid(worker.grid);
+        return;
+    }
+
+    ClusterCommand command;
+    while (ReceiveAll(socket, &command, sizeof(command)) && (command.type != CLUSTER_STOP))
+    {
+        if (command.type == CLUSTER_RUN)
+        {
+            double exchangeSeconds = 0.0;
+            for (int left = command.generations; left > 0;)
+            {
+                int steps = (left < halo)? left : halo;
+
+                double start = GetLifeSeconds();
+                WaitClusterBarrier(&worker);
+                FillHalo(&worker);
+                exchangeSeconds += GetLifeSeconds() - start;
+
+                for (int i = 0; i < steps; i++) StepLifeGrid(&worker.grid);
+                worker.parity ^= 1;
+                WriteOutbox(&worker);
+                worker.generation += steps;
+                left -= steps;
+            }
+
+            reply.generation = worker.generation;
+            reply.population = CountSubdomain(&worker);
+            reply.exchangeSeconds = exchangeSeconds;
+            if (!SendAll(socket, &reply, sizeof(reply))) break;
+        }
+        else if (command.type == CLUSTER_GATHER)
+        {
+            int words = (command.cols + 63)/64;
+            uint64_t *rowBits = malloc(words*sizeof(uint64_t));
+            if (rowBits == NULL) break;
+
+            bool sent = true;
+            for (int row = command.row; (row < command.row + command.rows) && sent; row++)
+            {
+                const uint64_t *rowCells = LIFE_ROW(worker.grid, worker.grid.cells, worker.haloTop + row) + 1;
+                CopyCells(rowBits, rowCells, (size_t)worker.haloLeft + command.col, command.cols);
+                sent = SendAll(socket, rowBits, words*sizeof(uint64_t));
+            }
+            free(rowBits);
+            if (!sent) break;
+        }
+    }
+
+    UnloadLifeGrid(worker.grid);
+}
+
+static void WaitClusterBarrier(ClusterWorker *worker)
+{
+    ClusterBarrier *barrier = (ClusterBarrier *)worker->cluster->shared;
+    worker->sense ^= 1;
+
+    // Last one in resets the count and flips the sense, releasing the others
+    if (__atomic_add_fetch(&barrier->waiting, 1, __ATOMIC_ACQ_REL) == (uint32_t)worker->cluster->workers)
+    {
+        __atomic_store_n(&barrier->waiting, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&barrier->sense, worker->sense, __ATOMIC_RELEASE);
+        return;
+    }
+
+    int spins = 0;
+    while (__atomic_load_n(&barrier->sense, __ATOMIC_ACQUIRE) != worker->sense)
+    {
+        if (++spins >= CLUSTER_SPINS) sched_yield();
+    }
+}
+
+// Publish the border cells of the subdomain in the outbox of the current parity
+static void WriteOutbox(ClusterWorker *worker)
+{
+    const ClusterBlock *block = &worker->cluster->blocks[worker->index];
+    int halo = worker->cluster->settings.halo;
+    uint64_t *outbox = (uint64_t *)worker->cluster->shared + block->outbox[worker->parity];
+    uint64_t *leftStrip = outbox + 2*(size_t)halo*block->rowWords;
+    uint64_t *rightStrip = leftStrip + (size_t)block->rows*block->haloWords;
+
+    for (int row = 0; row < block->rows; row++)
+    {
+        const uint64_t *cells = LIFE_ROW(worker->grid, worker->grid.cells, worker->haloTop + row) + 1;
+
+        // Full rows near the top and bottom, the h cells at each end of every row
+        if (row < halo) CopyCells(outbox + (size_t)row*block->rowWords, cells, worker->haloLeft, block->cols);
+        if (row >= block->rows - halo) CopyCells(outbox + (size_t)(row - (block->rows - halo) + halo)*block->rowWords, cells, worker->haloLeft, block->cols);
+        CopyCells(leftStrip + (size_t)row*block->haloWords, cells, worker->haloLeft, halo);
+        CopyCells(rightStrip + (size_t)row*block->haloWords, cells, (size_t)worker->haloLeft + block->cols - halo, halo);
+    }
+}
+
+// Refill every halo cell from the outbox of the subdomain owning it
+static void FillHalo(ClusterWorker *worker)
+{
+    LifeCluster *cluster = worker->cluster;
+    const ClusterBlock *block = &cluster->blocks[worker->index];
+    LifeGrid *grid = &worker->grid;
+
+    for (int row = 0; row < grid->rows; row++)
+    {
+        uint64_t *cells = LIFE_ROW(*grid, grid->cells, row) + 1;
+        int boardRow = MapBoardIndex(cluster->topology, block->firstRow - worker->haloTop + row, cluster->rows);
+
+        // Inside the subdomain only the halo columns are refilled
+        if ((row < worker->haloTop) || (row >= worker->haloTop + block->rows)) FillHaloRun(worker, cells, boardRow, 0, grid->cols);
+        else
+        {
+            FillHaloRun(worker, cells, boardRow, 0, worker->haloLeft);
+            FillHaloRun(worker, cells, boardRow, worker->haloLeft + block->cols, grid->cols);
+        }
+    }
+}
+
+// Halo columns [col, end) of one worker grid row, up to 64 cells copied at a time
+// NOTE: A run stops at the board edge and at subdomain borders. Mirror boards read the cells past the edge backwards,
+// those runs are read forwards and bit reversed
+static void FillHaloRun(ClusterWorker *worker, uint64_t *cells, int boardRow, int col, int end)
+{
+    LifeCluster *cluster = worker->cluster;
+    const ClusterBlock *block = &cluster->blocks[worker->index];
+    int halo = cluster->settings.halo;
+    int size = cluster->cols;
+    const ClusterBlock *owners = &cluster->blocks[cluster->rowOwner[boardRow]*cluster->settings.tileCols];
+
+    while (col < end)
+    {
+        int value = block->firstCol - worker->haloLeft + col;
+        int boardCol = MapBoardIndex(cluster->topology, value, size);
+        bool backwards = (cluster->topology == TOPOLOGY_MIRROR) && ((value < 0) || (value >= size));
+
+        int count = end - col;
+        if ((value < 0) && (-value < count)) count = -value;
+        if ((value >= 0) && (value < size) && (size - value < count)) count = size - value;
+        if (count > 64) count = 64;
+
+        const ClusterBlock *owner = &owners[cluster->colOwner[boardCol]];
+        int ownerLeft = backwards? boardCol - owner->firstCol + 1 : owner->firstCol + owner->cols - boardCol;
+        if (ownerLeft < count) count = ownerLeft;
+
+        // Cells of the run as owner columns, counted forwards from the first one
+        int ownerCol = (backwards? boardCol - count + 1 : boardCol) - owner->firstCol;
+        const uint64_t *outbox = (const uint64_t *)cluster->shared + owner->outbox[worker->parity];
+        const uint64_t *strip = GetBorderRow(owner, outbox, halo, boardRow - owner->firstRow, &ownerCol);
+        uint64_t bits = ReadBits(strip, ownerCol, count);
+        if (backwards) bits = ReverseBits(bits) >> (64 - count);
+
+        WriteBits(cells, col, bits, count);
+        col += count;
+    }
+}
+
+// Live cells of the subdomain, halo excluded
+static int64_t CountSubdomain(const ClusterWorker *worker)
+{
+    const ClusterBlock *block = &worker->cluster->blocks[worker->index];
+    int64_t population = 0;
+    for (int row = 0; row < block->rows; row++)
+    {
+        const uint64_t *cells = LIFE_ROW(worker->grid, worker->grid.cells, worker->haloTop + row) + 1;
+        for (int col = 0; col < block->cols; col += 64)
+        {
+            population += CountLifeBits(ReadBits(cells, (size_t)worker->haloLeft + col, (block->cols - col < 64)? block->cols - col : 64));
+        }
+    }
+    return population;
+}
+
+// Outbox row holding a border cell of the block, col moved to the bit of the cell in that row
+// NOTE: Rows near the top and bottom come from the row strips, the others from the column strip holding col
+static const uint64_t *GetBorderRow(const ClusterBlock *block, const uint64_t *outbox, int halo, int row, int *col)
+{
+    if (row < halo) return outbox + (size_t)row*block->rowWords;
+    if (row >= block->rows - halo) return outbox + (size_t)(row - (block->rows - halo) + halo)*block->rowWords;
+
+    const uint64_t *leftStrip = outbox + 2*(size_t)halo*block->rowWords;
+    if (*col < halo) return leftStrip + (size_t)row*block->haloWords;
+
+    *col -= block->cols - halo;
+    return leftStrip + ((size_t)block->rows + row)*block->haloWords;
+}
+
+// Bring a row or column index past the board edge back onto the board
+static int MapBoardIndex(GridTopology topology, int value, int size)
+{
+    if ((value >= 0) && (value < size)) return value;
+    if (topology == TOPOLOGY_MIRROR) return (value < 0)? -1 - value : 2*size - 1 - value;
+    return (value + size)%size;
+}
+
+// Copy count cells of a grid row, starting at bit, into words from bit 0 on
+static void CopyCells(uint64_t *words, const uint64_t *cells, size_t bit, int count)
+{
+    for (int done = 0; done < count; done += 64) words[done/64] = ReadBits(cells, bit + done, (count - done < 64)? count - done : 64);
+}
+
+// Read count bits, 1 to 64, starting at bit, the word after the first is only read when the bits reach into it
+static uint64_t ReadBits(const uint64_t *words, size_t bit, int count)
+{
+    const uint64_t *word = words + bit/64;
+    int shift = (int)(bit%64);
+    uint64_t bits = word[0] >> shift;
+    if (shift + count > 64) bits |= word[1] << (64 - shift);
+
+    return (count == 64)? bits : bits & ((1ULL << count) - 1);
+}
+
+// Replace count bits, 1 to 64, starting at bit, the other bits are kept
+static void WriteBits(uint64_t *words, size_t bit, uint64_t bits, int count)
+{
+    uint64_t *word = words + bit/64;
+    int shift = (int)(bit%64);
+    uint64_t mask = (count == 64)? ~0ULL : ((1ULL << count) - 1);
+
+    word[0] = (word[0] & ~(mask << shift)) | (bits << shift);
+    if (shift + count > 64) word[1] = (word[1] & ~(mask >> (64 - shift))) | (bits >> (64 - shift));
+}
+
+static uint64_t ReverseBits(uint64_t bits)
+{
+    bits = ((bits >> 1) & 0x5555555555555555ULL) | ((bits & 0x5555555555555555ULL) << 1);
+    bits = ((bits >> 2) & 0x3333333333333333ULL) | ((bits & 0x3333333333333333ULL) << 2);
+    bits = ((bits >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((bits & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    bits = ((bits >> 8) & 0x00FF00FF00FF00FFULL) | ((bits & 0x00FF00FF00FF00FFULL) << 8);
+    bits = ((bits >> 16) & 0x0000FFFF0000FFFFULL) | ((bits & 0x0000FFFF0000FFFFULL) << 16);
+    return (bits >> 32) | (bits << 32);
+}
+
+static bool SendAll(int socket, const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    while (size > 0)
+    {
+        ssize_t sent = send(socket, bytes, size, CLUSTER_SEND_FLAGS);
+        if (sent <= 0) return false;
+        bytes += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+static bool ReceiveAll(int socket, void *data, size_t size)
+{
+    unsigned char *bytes = (unsigned char *)data;
+    while (size > 0)
+    {
+        ssize_t received = recv(socket, bytes, size, 0);
+        if (received <= 0) return false;
+        bytes += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+#else
+
+//----------------------------------------------------------------------------------
+// Cluster Functions Definition (Windows)
+//----------------------------------------------------------------------------------
+
+// Windows has no fork(), the cluster never starts and the other calls never get a cluster
+LifeCluster *StartLifeCluster(ClusterSettings settings, int rows, int cols, GridTopology topology, ClusterLoader loader, void *data)
+{
+    return NULL;
+}
+
+bool StepLifeCluster(LifeCluster *cluster, int generations)
+{
+    return false;
+}
+
+ClusterStats GetLifeClusterStats(const LifeCluster *cluster)
+{
+    return (ClusterStats){ 0 };
+}
+
+bool GatherLifeCluster(LifeCluster *cluster, LifeGrid *window, int row, int col)
+{
+    return false;
+}
+
+void StopLifeCluster(LifeCluster *cluster)
+{
+}
+
+#endif
@@ -0,0 +1,615 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Export
+*
+*   Records generations to an animated GIF, a PNG sequence or raw Y4M video for ffmpeg.
+*
+*   The simulation thread only copies the cell words into a free slot of a bounded queue.
+*   Worker threads rasterize and encode the snapshots, frames are compressed in parallel and
+*   appended to the file in submission order. Nothing here depends on raylib, so recording
+*   works without a window.
+*
+*   NOTE: SubmitLifeExport() blocks while every slot is waiting for a worker, so the queue
+*   size is how far the simulation may run ahead of the encoders.
+*
+**********************************************************************************************/
+
+#include "life.h"
+#include "life_thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define EXPORT_MAX_WORKERS 16
+#define GIF_MAX_CODES 4096
+#define PNG_STORED_BLOCK 65535      // Largest uncompressed deflate block
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ExportBuffer {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+    bool failed;            // Allocation failed, contents are incomplete
+} ExportBuffer;
+
+typedef struct ExportWorker {
+    LifeExport *exporter;
+    pthread_t thread;
+    unsigned char *pixels;  // Rasterized frame, one palette index per pixel
+    uint16_t (*dictionary)[4]; // GIF LZW trie, GIF_MAX_CODES entries
+    ExportBuffer encoded;
+} ExportWorker;
+
+typedef struct GifWriter {
+    ExportBuffer *out;
+    unsigned char block[256];   // Length byte and up to 255 data bytes
+    int blockSize;
+    uint32_t bits;
+    int bitCount;
+    int codeSize;
+} GifWriter;
+
+struct LifeExport {
+    ExportSettings settings;
+    int rows;
+    int cols;
+    int words;              // Words per snapshot row, ghost words dropped
+    int width;              // Frame size in pixels
+    int height;
+    FILE *file;             // Single output file, NULL for PNG sequences
+
+    pthread_mutex_t lock;
+    pthread_cond_t slotFree;
+    pthread_cond_t slotFilled;
+    pthread_cond_t frameWritten;
+
+    uint64_t **slots;       // Snapshot buffers, settings.queueFrames of them
+    int *freeSlots;         // Stack of unused slots
+    int freeCount;
+    int *queue;             // Filled slots in submission order, ring buffer
+    int *queueFrame;        // Frame index of each queue entry
+    int *queueGeneration;   // Generation of each queue entry
+    int queueHead;
+    int queueCount;
+
+    int submitted;          // Frames handed to the queue
+    int nextWrite;          // Frame index the file expects next
+    int written;            // Frames written successfully
+    bool closing;
+    bool failed;            // An encoder or write failed
+
+    int workerCount;
+    ExportWorker workers[EXPORT_MAX_WORKERS];
+};
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static uint32_t crcTable[256] = { 0 };
+static pthread_once_t crcOnce = PTHREAD_ONCE_INIT;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static void *ExportWorkerMain(void *arg);
+static void RasterizeSnapshot(const LifeExport *exporter, const uint64_t *snapshot, unsigned char *pixels);
+static void EncodeFrame(const LifeExport *exporter, ExportWorker *worker);
+static void EncodeGifFrame(const LifeExport *exporter, ExportWorker *worker, const unsigned char *pixels, ExportBuffer *out);
+static void PutGifCode(GifWriter *writer, int code);
+static void FlushGifCodes(GifWriter *writer);
+static void EncodePngFrame(const LifeExport *exporter, const unsigned char *pixels, ExportBuffer *out);
+static bool WriteFileHeader(LifeExport *exporter);
+
+static void AppendBytes(ExportBuffer *buffer, const void *data, size_t size);
+static void AppendByte(ExportBuffer *buffer, unsigned char value);
+static void AppendBig32(ExportBuffer *buffer, uint32_t value);
+static void AppendLittle16(ExportBuffer *buffer, int value);
+static void BuildCrcTable(void);
+static uint32_t UpdateCrc(uint32_t crc, const unsigned char *data, size_t size);
+
+//----------------------------------------------------------------------------------
+// Export Functions Definition
+//----------------------------------------------------------------------------------
+
+// Start the encoder threads and write the file header, NULL on failure
+LifeExport *OpenLifeExport(ExportSettings settings, int rows, int cols)
+{
+    if (settings.every < 1) settings.every = 1;
+    if (settings.scale < 1) settings.scale = 1;
+    if (settings.frameDelay < 1) settings.frameDelay = 1;
+    if (settings.queueFrames < 1) settings.queueFrames = 8;
+    if (settings.workers <= 0)
+    {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        settings.workers = (cores > 0)? (int)cores : 1;
+    }
+    if (settings.workers > EXPORT_MAX_WORKERS) settings.workers = EXPORT_MAX_WORKERS;
+
+    // GIF stores sizes in 16 bits
+    if (((int64_t)cols*settings.scale > 65535) || ((int64_t)rows*settings.scale > 65535)) return NULL;
+
+    LifeExport *exporter = calloc(1, sizeof(LifeExport));
+    if (exporter == NULL) return NULL;
+
+    exporter->settings = settings;
+    exporter->rows = rows;
+    exporter->cols = cols;
+    exporter->words = (cols + 63)/64;
+    exporter->width = cols*settings.scale;
+    exporter->height = rows*settings.scale;
+
+    pthread_mutex_init(&exporter->lock, NULL);
+    pthread_cond_init(&exporter->slotFree, NULL);
+    pthread_cond_init(&exporter->slotFilled, NULL);
+    pthread_cond_init(&exporter->frameWritten, NULL);
+    pthread_once(&crcOnce, BuildCrcTable);
+
+    int slotCount = settings.queueFrames;
+    bool loaded = true;
+    exporter->slots = calloc(slotCount, sizeof(uint64_t *));
+    exporter->freeSlots = calloc(slotCount, sizeof(int));
+    exporter->queue = calloc(slotCount, sizeof(int));
+    exporter->queueFrame = calloc(slotCount, sizeof(int));
+    exporter->queueGeneration = calloc(slotCount, sizeof(int));
+    if ((exporter->slots == NULL) || (exporter->freeSlots == NULL) || (exporter->queue == NULL) ||
+        (exporter->queueFrame == NULL) || (exporter->queueGeneration == NULL)) loaded = false;
+
+    for (int i = 0; loaded && (i < slotCount); i++)
+    {
+        exporter->slots[i] = malloc((size_t)rows*exporter->words*sizeof(uint64_t));
+        if (exporter->slots[i] == NULL) loaded = false;
+        exporter->freeSlots[exporter->freeCount++] = i;
+    }
+    for (int i = 0; loaded && (i < settings.workers); i++)
+    {
+        exporter->workers[i].exporter = exporter;
+        exporter->workers[i].pixels = malloc((size_t)exporter->width*exporter->height);
+        exporter->workers[i].dictionary = malloc(GIF_MAX_CODES*sizeof(*exporter->workers[i].dictionary));
+        if ((exporter->workers[i].pixels == NULL) || (exporter->workers[i].dictionary == NULL)) loaded = false;
+    }
+
+    if (loaded && (settings.format != EXPORT_PNG_SEQUENCE))
+    {
+        exporter->file = fopen(settings.path, "wb");
+        if ((exporter->file == NULL) || !WriteFileHeader(exporter)) loaded = false;
+    }
+
+    for (int i = 0; loaded && (i < settings.workers); i++)
+    {
+        if (pthread_create(&exporter->workers[i].thread, NULL, ExportWorkerMain, &exporter->workers[i]) != 0) break;
+        exporter->workerCount++;
+    }
+    if (exporter->workerCount == 0) loaded = false;
+
+    if (!loaded)
+    {
+        CloseLifeExport(exporter);
+        return NULL;
+    }
+
+    return exporter;
+}
+
+// Queue a snapshot of the grid when generation is a multiple of the export interval
+bool SubmitLifeExport(LifeExport *exporter, LifeGrid grid, int generation)
+{
+    if ((generation%exporter->settings.every) != 0) return false;
+
+    pthread_mutex_lock(&exporter->lock);
+    while (exporter->freeCount == 0) pthread_cond_wait(&exporter->slotFree, &exporter->lock);
+    int slot = exporter->freeSlots[--exporter->freeCount];
+    pthread_mutex_unlock(&exporter->lock);
+
+    // Only the copy happens on the simulation thread
+    uint64_t *snapshot = exporter->slots[slot];
+    for (int row = 0; row < exporter->rows; row++)
+    {
+        memcpy(snapshot + (size_t)row*exporter->words, LIFE_ROW(grid, grid.cells, row) + 1, exporter->words*sizeof(uint64_t));
+    }
+
+    pthread_mutex_lock(&exporter->lock);
+    int tail = (exporter->queueHead + exporter->queueCount)%exporter->settings.queueFrames;
+    exporter->queue[tail] = slot;
+    exporter->queueFrame[tail] = exporter->submitted++;
+    exporter->queueGeneration[tail] = generation;
+    exporter->queueCount++;
+    pthread_cond_signal(&exporter->slotFilled);
+    pthread_mutex_unlock(&exporter->lock);
+
+    return true;
+}
+
+// Encode everything still queued, finish the file and free the exporter
+// NOTE: Returns the number of frames written, or -1 when a frame could not be encoded or written
+int CloseLifeExport(LifeExport *exporter)
+{
+    if (exporter == NULL) return -1;
+
+    pthread_mutex_lock(&exporter->lock);
+    exporter->closing = true;
+    pthread_cond_broadcast(&exporter->slotFilled);
+    pthread_mutex_unlock(&exporter->lock);
+    for (int i = 0; i < exporter->workerCount; i++) pthread_join(exporter->workers[i].thread, NULL);
+
+    if (exporter->file != NULL)
+    {
+        if ((exporter->settings.format == EXPORT_GIF) && (fputc(0x3B, exporter->file) == EOF)) exporter->failed = true;
+        if (fclose(exporter->file) != 0) exporter->failed = true;
+    }
+
+    int result = exporter->failed? -1 : exporter->written;
+
+    for (int i = 0; i < EXPORT_MAX_WORKERS; i++)
+    {
+        free(exporter->workers[i].pixels);
+        free(exporter->workers[i].dictionary);
+        free(exporter->workers[i].encoded.data);
+    }
+    for (int i = 0; (exporter->slots != NULL) && (i < exporter->settings.queueFrames); i++) free(exporter->slots[i]);
+    free(exporter->slots);
+    free(exporter->freeSlots);
+    free(exporter->queue);
+    free(exporter->queueFrame);
+    free(exporter->queueGeneration);
+    pthread_mutex_destroy(&exporter->lock);
+    pthread_cond_destroy(&exporter->slotFree);
+    pthread_cond_destroy(&exporter->slotFilled);
+    pthread_cond_destroy(&exporter->frameWritten);
+    free(exporter);
+
+    return result;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+static void *ExportWorkerMain(void *arg)
+{
+    ExportWorker *worker = (ExportWorker *)arg;
+    LifeExport *exporter = worker->exporter;
+
+    pthread_mutex_lock(&exporter->lock);
+    for (;;)
+    {
+        while ((exporter->queueCount == 0) && !exporter->closing) pthread_cond_wait(&exporter->slotFilled, &exporter->lock);
+        if (exporter->queueCount == 0) break;
+
+        int slot = exporter->queue[exporter->queueHead];
+        int frame = exporter->queueFrame[exporter->queueHead];
+        int generation = exporter->queueGeneration[exporter->queueHead];
+        exporter->queueHead = (exporter->queueHead + 1)%exporter->settings.queueFrames;
+        exporter->queueCount--;
+        pthread_mutex_unlock(&exporter->lock);
+
+        // The slot goes back as soon as it is rasterized, encoding works on the pixels
+        RasterizeSnapshot(exporter, exporter->slots[slot], worker->pixels);
+        pthread_mutex_lock(&exporter->lock);
+        exporter->freeSlots[exporter->freeCount++] = slot;
+        pthread_cond_signal(&exporter->slotFree);
+        pthread_mutex_unlock(&exporter->lock);
+
+        worker->encoded.size = 0;
+        worker->encoded.failed = false;
+        EncodeFrame(exporter, worker);
+
+        bool written = !worker->encoded.failed;
+        if (exporter->settings.format == EXPORT_PNG_SEQUENCE)
+        {
+            // Every frame is its own file, no ordering needed
+            char path[1024] = { 0 };
+            snprintf(path, sizeof(path), exporter->settings.path, generation);
+            FILE *file = written? fopen(path, "wb") : NULL;
+            written = (file != NULL) && (fwrite(worker->encoded.data, 1, worker->encoded.size, file) == worker->encoded.size);
+            if ((file != NULL) && (fclose(file) != 0)) written = false;
+
+            pthread_mutex_lock(&exporter->lock);
+        }
+        else
+        {
+            // Frames are appended in submission order, whichever worker finished first
+            pthread_mutex_lock(&exporter->lock);
+            while (exporter->nextWrite != frame) pthread_cond_wait(&exporter->frameWritten, &exporter->lock);
+            if (written) written = (fwrite(worker->encoded.data, 1, worker->encoded.size, exporter->file) == worker->encoded.size);
+            exporter->nextWrite++;
+            pthread_cond_broadcast(&exporter->frameWritten);
+        }
+
+        if (written) exporter->written++;
+        else exporter->failed = true;
+    }
+    pthread_mutex_unlock(&exporter->lock);
+
+    return NULL;
+}
+
+// Expand snapshot bits into one palette index per pixel, scale x scale pixels per cell
+static void RasterizeSnapshot(const LifeExport *exporter, const uint64_t *snapshot, unsigned char *pixels)
+{
+    int scale = exporter->settings.scale;
+    for (int row = 0; row < exporter->rows; row++)
+    {
+        const uint64_t *words = snapshot + (size_t)row*exporter->words;
+        unsigned char *line = pixels + (size_t)row*scale*exporter->width;
+        for (int col = 0; col < exporter->cols; col++)
+        {
+            unsigned char alive = (unsigned char)((words[col/64] >> (col%64)) & 1);
+            memset(line + (size_t)col*scale, alive, scale);
+        }
+        for (int copy = 1; copy < scale; copy++) memcpy(line + (size_t)copy*exporter->width, line, exporter->width);
+    }
+}
+
+static void EncodeFrame(const LifeExport *exporter, ExportWorker *worker)
+{
+    const unsigned char *pixels = worker->pixels;
+    ExportBuffer *out = &worker->encoded;
+    switch (exporter->settings.format)
+    {
+        case EXPORT_GIF: EncodeGifFrame(exporter, worker, pixels, out); break;
+        case EXPORT_PNG_SEQUENCE: EncodePngFrame(exporter, pixels, out); break;
+        case EXPORT_Y4M:
+        default:
+        {
+            // Full range luma only, dead cells black and live cells white
+            static const char frameHeader[] = "FRAME\n";
+            AppendBytes(out, frameHeader, sizeof(frameHeader) - 1);
+            size_t start = out->size;
+            AppendBytes(out, pixels, (size_t)exporter->width*exporter->height);
+            if (out->failed) break;
+            for (size_t i = start; i < out->size; i++) out->data[i] = out->data[i]? 255 : 0;
+        } break;
+    }
+}
+
+// Graphic control block, image descriptor and LZW compressed pixels of one GIF frame
+static void EncodeGifFrame(const LifeExport *exporter, ExportWorker *worker, const unsigned char *pixels, ExportBuffer *out)
+{
+    const unsigned char control[] = { 0x21, 0xF9, 0x04, 0x00 };
+    AppendBytes(out, control, sizeof(control));
+    AppendLittle16(out, exporter->settings.frameDelay);
+    AppendByte(out, 0);
+    AppendByte(out, 0);
+
+    AppendByte(out, 0x2C);
+    AppendLittle16(out, 0);
+    AppendLittle16(out, 0);
+    AppendLittle16(out, exporter->width);
+    AppendLittle16(out, exporter->height);
+    AppendByte(out, 0);
+
+    // Two colour palette, but GIF needs a minimum code size of 2: codes 0..3, clear 4, end 5
+    const int minCodeSize = 2;
+    const int clearCode = 1 << minCodeSize;
+    const int endCode = clearCode + 1;
+    AppendByte(out, minCodeSize);
+
+    // Dictionary as a trie, child[code][pixel] is the code extending code by pixel
+    uint16_t (*child)[4] = worker->dictionary;
+    memset(child, 0, GIF_MAX_CODES*sizeof(*child));
+    int nextCode = endCode + 1;
+    GifWriter writer = { .out = out, .codeSize = minCodeSize + 1 };
+
+    PutGifCode(&writer, clearCode);
+    size_t count = (size_t)exporter->width*exporter->height;
+    int current = pixels[0];
+    for (size_t i = 1; i < count; i++)
+    {
+        int pixel = pixels[i];
+        if (child[current][pixel] != 0)
+        {
+            current = child[current][pixel];
+            continue;
+        }
+
+        PutGifCode(&writer, current);
+        if (nextCode < GIF_MAX_CODES)
+        {
+            child[current][pixel] = (uint16_t)nextCode++;
+            // The decoder adds each entry one code later, and widens once its next entry needs another bit
+            if ((nextCode > (1 << writer.codeSize)) && (writer.codeSize < 12)) writer.codeSize++;
+        }
+        else
+        {
+            PutGifCode(&writer, clearCode);
+            memset(child, 0, GIF_MAX_CODES*sizeof(*child));
+            nextCode = endCode + 1;
+            writer.codeSize = minCodeSize + 1;
+        }
+        current = pixel;
+    }
+    PutGifCode(&writer, current);
+
+    // Reading the last code adds the entry the encoder never did, which may widen the end code
+    if ((nextCode == (1 << writer.codeSize)) && (writer.codeSize < 12)) writer.codeSize++;
+    PutGifCode(&writer, endCode);
+    FlushGifCodes(&writer);
+    AppendByte(out, 0);
+}
+
+// Pack a code LSB first into 255 byte data sub-blocks
+static void PutGifCode(GifWriter *writer, int code)
+{
+    writer->bits |= (uint32_t)code << writer->bitCount;
+    writer->bitCount += writer->codeSize;
+    while (writer->bitCount >= 8)
+    {
+        writer->block[1 + writer->blockSize++] = (unsigned char)(writer->bits & 0xFF);
+        writer->bits >>= 8;
+        writer->bitCount -= 8;
+        if (writer->blockSize == 255)
+        {
+            writer->block[0] = 255;
+            AppendBytes(writer->out, writer->block, 256);
+            writer->blockSize = 0;
+        }
+    }
+}
+
+// Write the pending sub-block, padding a partial last byte
+static void FlushGifCodes(GifWriter *writer)
+{
+    if (writer->bitCount > 0)
+    {
+        writer->block[1 + writer->blockSize++] = (unsigned char)(writer->bits & 0xFF);
+        writer->bits = 0;
+        writer->bitCount = 0;
+    }
+    if (writer->blockSize > 0)
+    {
+        writer->block[0] = (unsigned char)writer->blockSize;
+        AppendBytes(writer->out, writer->block, writer->blockSize + 1);
+        writer->blockSize = 0;
+    }
+}
+
+// One bit per pixel greyscale PNG, deflate stored blocks keep the encoder trivial
+static void EncodePngFrame(const LifeExport *exporter, const unsigned char *pixels, ExportBuffer *out)
+{
+    static const unsigned char signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    AppendBytes(out, signature, sizeof(signature));
+
+    AppendBig32(out, 13);
+    size_t chunk = out->size;
+    AppendBytes(out, "IHDR", 4);
+    AppendBig32(out, (uint32_t)exporter->width);
+    AppendBig32(out, (uint32_t)exporter->height);
+    const unsigned char header[] = { 1, 0, 0, 0, 0 };   // Bit depth 1, greyscale, no interlace
+    AppendBytes(out, header, sizeof(header));
+    if (!out->failed) AppendBig32(out, UpdateCrc(0, out->data + chunk, out->size - chunk));
+
+    // Filter byte 0 and packed bits for every row
+    size_t lineSize = 1 + ((size_t)exporter->width + 7)/8;
+    size_t rawSize = lineSize*exporter->height;
+    size_t blocks = (rawSize + PNG_STORED_BLOCK - 1)/PNG_STORED_BLOCK;
+    AppendBig32(out, (uint32_t)(2 + rawSize + 5*blocks + 4));
+    chunk = out->size;
+    AppendBytes(out, "IDAT", 4);
+    AppendByte(out, 0x78);
+    AppendByte(out, 0x01);
+
+    uint32_t adlerA = 1;
+    uint32_t adlerB = 0;
+    unsigned char *line = calloc(lineSize, 1);
+    if (line == NULL) out->failed = true;
+    size_t blockLeft = 0;
+    size_t remaining = rawSize;
+    for (int y = 0; (y < exporter->height) && !out->failed; y++)
+    {
+        memset(line, 0, lineSize);
+        const unsigned char *source = pixels + (size_t)y*exporter->width;
+        for (int x = 0; x < exporter->width; x++) line[1 + x/8] |= (unsigned char)(source[x] << (7 - x%8));
+
+        for (size_t i = 0; i < lineSize; i++)
+        {
+            if (blockLeft == 0)
+            {
+                blockLeft = (remaining < PNG_STORED_BLOCK)? remaining : PNG_STORED_BLOCK;
+                AppendByte(out, (remaining == blockLeft)? 1 : 0);
+                AppendByte(out, (unsigned char)(blockLeft & 0xFF));
+                AppendByte(out, (unsigned char)(blockLeft >> 8));
+                AppendByte(out, (unsigned char)(~blockLeft & 0xFF));
+                AppendByte(out, (unsigned char)((~blockLeft >> 8) & 0xFF));
+            }
+            AppendByte(out, line[i]);
+            adlerA = (adlerA + line[i])%65521;
+            adlerB = (adlerB + adlerA)%65521;
+            blockLeft--;
+            remaining--;
+        }
+    }
+    free(line);
+    AppendBig32(out, (adlerB << 16) | adlerA);
+    if (!out->failed) AppendBig32(out, UpdateCrc(0, out->data + chunk, out->size - chunk));
+
+    AppendBig32(out, 0);
+    chunk = out->size;
+    AppendBytes(out, "IEND", 4);
+    if (!out->failed) AppendBig32(out, UpdateCrc(0, out->data + chunk, out->size - chunk));
+}
+
+// Everything before the first frame
+static bool WriteFileHeader(LifeExport *exporter)
+{
+    ExportBuffer header = { 0 };
+
+    if (exporter->settings.format == EXPORT_GIF)
+    {
+        AppendBytes(&header, "GIF89a", 6);
+        AppendLittle16(&header, exporter->width);
+        AppendLittle16(&header, exporter->height);
+        const unsigned char screen[] = { 0xF0, 0, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF };  // Two colour global table
+        AppendBytes(&header, screen, sizeof(screen));
+        const unsigned char loop[] = { 0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0', 0x03, 0x01, 0x00, 0x00, 0x00 };
+        AppendBytes(&header, loop, sizeof(loop));
+    }
+    else
+    {
+        char text[128] = { 0 };
+        int length = snprintf(text, sizeof(text), "YUV4MPEG2 W%d H%d F100:%d Ip A1:1 Cmono\n", exporter->width, exporter->height, exporter->settings.frameDelay);
+        AppendBytes(&header, text, length);
+    }
+
+    bool written = !header.failed && (fwrite(header.data, 1, header.size, exporter->file) == header.size);
+    free(header.data);
+    return written;
+}
+
+static void AppendBytes(ExportBuffer *buffer, const void *data, size_t size)
+{
+    if (buffer->failed) return;
+    if (buffer->size + size > buffer->capacity)
+    {
+        size_t capacity = (buffer->capacity > 0)? buffer->capacity : 4096;
+        while (capacity < buffer->size + size) capacity *= 2;
+        unsigned char *grown = realloc(buffer->data, capacity);
+        if (grown == NULL)
+        {
+            buffer->failed = true;
+            return;
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+}
+
+static void AppendByte(ExportBuffer *buffer, unsigned char value)
+{
+    AppendBytes(buffer, &value, 1);
+}
+
+static void AppendBig32(ExportBuffer *buffer, uint32_t value)
+{
+    unsigned char bytes[4] = { (unsigned char)(value >> 24), (unsigned char)(value >> 16), (unsigned char)(value >> 8), (unsigned char)value };
+    AppendBytes(buffer, bytes, 4);
+}
+
+static void AppendLittle16(ExportBuffer *buffer, int value)
+{
+    unsigned char bytes[2] = { (unsigned char)(value & 0xFF), (unsigned char)((value >> 8) & 0xFF) };
+    AppendBytes(buffer, bytes, 2);
+}
+
+static void BuildCrcTable(void)
+{
+    for (uint32_t n = 0; n < 256; n++)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1)? 0xEDB88320U ^ (c >> 1) : c >> 1;
+        crcTable[n] = c;
+    }
+}
+
+static uint32_t UpdateCrc(uint32_t crc, const unsigned char *data, size_t size)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
@@ -0,0 +1,283 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Generations engine
+*
+*   Multi-state rules like Brian's Brain (B2/S/C3) or Star Wars (B2/S345/C4). State 0 is dead,
+*   state 1 is alive and states 2..C-1 are dying cells that age by one every generation and
+*   neither count as neighbours nor can be born into.
+*
+*   States are stored as 1 to 4 bit planes with the LifeGrid word layout, so the whole
+*   transition is evaluated 64 cells at a time with bitwise operations.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static uint64_t RuleMask(uint16_t rule, uint64_t n0, uint64_t n1, uint64_t n2, uint64_t n3);
+static void ClearPastLastColumn(uint64_t *row, int cols, int stride);
+static void ExtractAlivePlane(GenerationsLife *life);
+
+//----------------------------------------------------------------------------------
+// Generations Engine Functions Definition
+//----------------------------------------------------------------------------------
+
+// Parse a rule string in B/S/C form ("B2/S345/C4") or Golly S/B/C form ("345/2/4")
+bool ParseGenerationsRule(const char *text, GenerationsRule *rule)
+{
+    GenerationsRule parsed = { 0 };
+    int field = 0;
+    bool prefixed = (toupper((unsigned char)text[0]) == 'B');
+    int states = 0;
+
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        int letter = toupper((unsigned char)*c);
+        if (*c == '/') field++;
+        else if ((letter == 'B') || (letter == 'S') || (letter == 'C') || (letter == 'G'))
+        {
+            if (!prefixed) return false;
+            field = (letter == 'B')? 0 : (letter == 'S')? 1 : 2;
+        }
+        else if (isdigit((unsigned char)*c))
+        {
+            int digit = *c - '0';
+            // Golly numeric form lists survival first, then birth, then states
+            int target = prefixed? field : ((field == 0)? 1 : (field == 1)? 0 : 2);
+            if (target == 0) parsed.birth |= 1 << digit;
+            else if (target == 1) parsed.survive |= 1 << digit;
+            else if (target == 2)
+            {
+                // Stop before the count can overflow, anything past the limit is rejected anyway
+                states = states*10 + digit;
+                if (states > GENERATIONS_MAX_STATES) return false;
+            }
+            else return false;
+            if ((target != 2) && (digit > 8)) return false;
+        }
+        else return false;
+    }
+
+    parsed.states = (states == 0)? 2 : states;
+    if ((parsed.states < 2) || (parsed.states > GENERATIONS_MAX_STATES)) return false;
+
+    *rule = parsed;
+    return true;
+}
+
+// Load state 1 from the live cells of a grid, planes are NULL on failure
+GenerationsLife LoadGenerationsLife(LifeGrid grid, GenerationsRule rule)
+{
+    GenerationsLife life = { 0 };
+    life.rows = grid.rows;
+    life.cols = grid.cols;
+    life.stride = grid.stride;
+    life.rule = rule;
+    while ((1 << life.planeCount) < rule.states) life.planeCount++;
+
+    life.alive = LoadLifeGrid(grid.rows, grid.cols, grid.topology);
+    bool loaded = (life.alive.cells != NULL);
+    size_t words = (size_t)life.rows*life.stride;
+    for (int k = 0; k < life.planeCount; k++)
+    {
+        life.planes[k] = calloc(words, sizeof(uint64_t));
+        life.scratch[k] = calloc(words, sizeof(uint64_t));
+        if ((life.planes[k] == NULL) || (life.scratch[k] == NULL)) loaded = false;
+    }
+    if (!loaded)
+    {
+        UnloadGenerationsLife(life);
+        return (GenerationsLife){ 0 };
+    }
+
+    // Plane 0 holds the low state bit, so live cells copy straight across
+    for (int row = 0; row < life.rows; row++)
+    {
+        uint64_t *plane = life.planes[0] + (size_t)row*life.stride;
+        memcpy(plane, grid.cells + (size_t)(row + 1)*grid.stride, life.stride*sizeof(uint64_t));
+        plane[0] = 0;
+        ClearPastLastColumn(plane, life.cols, life.stride);
+    }
+    ExtractAlivePlane(&life);
+
+    return life;
+}
+
+void UnloadGenerationsLife(GenerationsLife life)
+{
+    UnloadLifeGrid(life.alive);
+    for (int k = 0; k < GENERATIONS_MAX_PLANES; k++)
+    {
+        free(life.planes[k]);
+        free(life.scratch[k]);
+    }
+}
+
+int GetGenerationsCell(GenerationsLife life, int row, int col)
+{
+    size_t word = (size_t)row*life.stride + 1 + col/64;
+    int state = 0;
+    for (int k = 0; k < life.planeCount; k++) state |= (int)((life.planes[k][word] >> (col%64)) & 1) << k;
+    return state;
+}
+
+void SetGenerationsCell(GenerationsLife *life, int row, int col, int state)
+{
+    size_t word = (size_t)row*life->stride + 1 + col/64;
+    uint64_t bit = 1ULL << (col%64);
+    for (int k = 0; k < life->planeCount; k++)
+    {
+        if (state & (1 << k)) life->planes[k][word] |= bit;
+        else life->planes[k][word] &= ~bit;
+    }
+    SetLifeCell(&life->alive, row, col, state == 1);
+}
+
+// Expand cell states into one byte per cell, row-major
+void GetGenerationsStates(GenerationsLife life, uint8_t *states)
+{
+    for (int row = 0; row < life.rows; row++)
+    {
+        for (int col = 0; col < life.cols; col++) states[(size_t)row*life.cols + col] = GetGenerationsCell(life, row, col);
+    }
+}
+
+// Write live cells (state 1) back into a grid of the same size
+void StoreGenerationsLife(GenerationsLife life, LifeGrid *grid)
+{
+    for (int row = 0; row < life.rows; row++)
+    {
+        memcpy(grid->cells + (size_t)(row + 1)*grid->stride, life.alive.cells + (size_t)(row + 1)*life.stride, life.stride*sizeof(uint64_t));
+    }
+}
+
+// Advance one generation
+void StepGenerationsLife(GenerationsLife *life)
+{
+    RefreshGhostCells(&life->alive);
+
+    int lastWord = 1 + (life->cols - 1)/64;
+    uint64_t lastMask = (life->cols%64 == 0)? ~0ULL : ((1ULL << (life->cols%64)) - 1);
+    int states = life->rule.states;
+
+    for (int row = 0; row < life->rows; row++)
+    {
+        const uint64_t *above = life->alive.cells + (size_t)row*life->stride;
+        const uint64_t *center = above + life->stride;
+        const uint64_t *below = center + life->stride;
+        size_t base = (size_t)row*life->stride;
+
+        for (int w = 1; w <= lastWord; w++)
+        {
+            // Same bit-sliced adder as the B3/S23 kernel, carried on to the full 0..8 count
+            uint64_t aW = (above[w] << 1) | (above[w - 1] >> 63);
+            uint64_t aE = (above[w] >> 1) | (above[w + 1] << 63);
+            uint64_t cW = (center[w] << 1) | (center[w - 1] >> 63);
+            uint64_t cE = (center[w] >> 1) | (center[w + 1] << 63);
+            uint64_t bW = (below[w] << 1) | (below[w - 1] >> 63);
+            uint64_t bE = (below[w] >> 1) | (below[w + 1] << 63);
+
+            uint64_t t = aW ^ above[w];
+            uint64_t a1 = t ^ aE;
+            uint64_t a2 = (aW & above[w]) | (t & aE);
+            t = bW ^ below[w];
+            uint64_t b1 = t ^ bE;
+            uint64_t b2 = (bW & below[w]) | (t & bE);
+            uint64_t c1 = cW ^ cE;
+            uint64_t c2 = cW & cE;
+
+            t = a1 ^ b1;
+            uint64_t n0 = t ^ c1;
+            uint64_t k1 = (a1 & b1) | (t & c1);
+            t = a2 ^ b2;
+            uint64_t t0 = t ^ c2;
+            uint64_t t1 = (a2 & b2) | (t & c2);
+            uint64_t n1 = t0 ^ k1;
+            uint64_t k2 = t0 & k1;
+            uint64_t n2 = t1 ^ k2;
+            uint64_t n3 = t1 & k2;
+
+            // Current state and the state one step older, wrapped back to dead at C
+            uint64_t dead = ~0ULL;
+            uint64_t older[GENERATIONS_MAX_PLANES] = { 0 };
+            uint64_t carry = ~0ULL;
+            uint64_t wrap = ~0ULL;
+            for (int k = 0; k < life->planeCount; k++)
+            {
+                uint64_t plane = life->planes[k][base + w];
+                dead &= ~plane;
+                older[k] = plane ^ carry;
+                carry &= plane;
+                wrap &= (states & (1 << k))? older[k] : ~older[k];
+            }
+
+            uint64_t born = dead & RuleMask(life->rule.birth, n0, n1, n2, n3);
+            uint64_t survive = center[w] & RuleMask(life->rule.survive, n0, n1, n2, n3);
+            uint64_t age = ~dead & ~survive & ~wrap;
+            uint64_t mask = (w == lastWord)? lastMask : ~0ULL;
+
+            life->scratch[0][base + w] = ((age & older[0]) | born | survive) & mask;
+            for (int k = 1; k < life->planeCount; k++) life->scratch[k][base + w] = age & older[k] & mask;
+        }
+    }
+
+    for (int k = 0; k < life->planeCount; k++)
+    {
+        uint64_t *swap = life->planes[k];
+        life->planes[k] = life->scratch[k];
+        life->scratch[k] = swap;
+    }
+    ExtractAlivePlane(life);
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+// Cells whose bit-sliced neighbour count (n3 n2 n1 n0) is one of the counts set in rule
+static uint64_t RuleMask(uint16_t rule, uint64_t n0, uint64_t n1, uint64_t n2, uint64_t n3)
+{
+    uint64_t mask = 0;
+    for (int n = 0; n <= 8; n++)
+    {
+        if (!(rule & (1 << n))) continue;
+        mask |= ((n & 1)? n0 : ~n0) & ((n & 2)? n1 : ~n1) & ((n & 4)? n2 : ~n2) & ((n & 8)? n3 : ~n3);
+    }
+    return mask;
+}
+
+// Drop ghost bits copied along with a grid row
+static void ClearPastLastColumn(uint64_t *row, int cols, int stride)
+{
+    int lastWord = 1 + (cols - 1)/64;
+    if (cols%64 != 0) row[lastWord] &= (1ULL << (cols%64)) - 1;
+    for (int w = lastWord + 1; w < stride; w++) row[w] = 0;
+}
+
+// State 1 is the only state that counts as a neighbour
+// NOTE: Written to the spare buffer of the alive grid and swapped in, ghost cells are refreshed before every step
+static void ExtractAlivePlane(GenerationsLife *life)
+{
+    for (int row = 0; row < life->rows; row++)
+    {
+        size_t base = (size_t)row*life->stride;
+        const uint64_t *alive = LIFE_ROW(life->alive, life->alive.cells, row);
+        uint64_t *extracted = LIFE_ROW(life->alive, life->alive.next, row);
+        for (int w = 1; w < life->stride; w++)
+        {
+            uint64_t bits = life->planes[0][base + w];
+            for (int k = 1; k < life->planeCount; k++) bits &= ~life->planes[k][base + w];
+            extracted[w] = bits;
+        }
+        MarkLifeRowChanges(&life->alive, row, alive, extracted);
+    }
+
+    uint64_t *swap = life->alive.cells;
+    life->alive.cells = life->alive.next;
+    life->alive.next = swap;
+}
@@ -0,0 +1,216 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Isotropic non-totalistic engine
+*
+*   Rules in Hensel notation, i.e. tlife "B3/S2-i34q". A rule compiles to a 512-entry table
+*   indexed by the whole 3x3 neighbourhood, bits in row-major order:
+*
+*       0 1 2       NW N  NE
+*       3 4 5       W  C  E
+*       6 7 8       SW S  SE
+*
+*   The stepper slides that index along each row, shifting one column out and three bits in
+*   per cell, instead of reading the eight neighbours separately.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <ctype.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define HENSEL_CENTER 16            // Index bit of the cell itself
+#define HENSEL_KEEP_COLUMNS 0xDB    // Index bits still in the window after shifting one column west
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct HenselJob {
+    const HenselRule *rule;
+    LifeGrid *grid;
+} HenselJob;
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+// Letters valid for every neighbour count, 5 to 8 use the letters of their complement
+static const char *henselLetters[9] = { "", "ce", "ceaikn", "ceaiknjqry", "ceaiknjqrytwz", "ceaiknjqry", "ceaikn", "ce", "" };
+
+// One neighbourhood per letter for counts 0 to 4, in the order of henselLetters
+static const uint16_t henselMasks[5][13] = {
+    { 0 },
+    { 0x001, 0x002 },
+    { 0x005, 0x00A, 0x003, 0x028, 0x021, 0x044 },
+    { 0x045, 0x02A, 0x00B, 0x007, 0x062, 0x00D, 0x00E, 0x046, 0x029, 0x061 },
+    { 0x145, 0x0AA, 0x00F, 0x02D, 0x063, 0x047, 0x06A, 0x066, 0x02B, 0x065, 0x069, 0x04E, 0x06C }
+};
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static uint16_t TransformMask(uint16_t mask, int symmetry);
+static bool ApplyHenselCount(uint16_t *letterMasks, int count, const char *letters, int letterCount, bool except);
+static void StepHenselRows(void *data, int begin, int end);
+
+//----------------------------------------------------------------------------------
+// Isotropic Engine Functions Definition
+//----------------------------------------------------------------------------------
+
+// Compile a Hensel rule ("B2-a/S12", "B3/S2-i34q") into a 3x3 lookup table
+bool ParseHenselRule(const char *text, HenselRule *rule)
+{
+    // Accepted neighbourhoods for birth [0] and survival [1], bit n of entry i for letter n of count i
+    uint16_t accepted[2][9] = { 0 };
+    int part = -1;
+    bool sections[2] = { false, false };
+    const char *c = text;
+
+    while (*c != '\0')
+    {
+        int letter = toupper((unsigned char)*c);
+        if (letter == 'B') { part = 0; sections[0] = true; c++; continue; }
+        if (letter == 'S') { part = 1; sections[1] = true; c++; continue; }
+        if (*c == '/') { c++; continue; }
+        if ((part < 0) || !isdigit((unsigned char)*c)) return false;
+
+        int count = *c++ - '0';
+        if (count > 8) return false;
+
+        bool except = false;
+        if (*c == '-') { except = true; c++; }
+
+        const char *letters = c;
+        while (islower((unsigned char)*c)) c++;
+        if (!ApplyHenselCount(&accepted[part][count], count, letters, (int)(c - letters), except)) return false;
+    }
+
+    // An empty string or one without both sections is not a rule, not an all dead one
+    if (!sections[0] || !sections[1]) return false;
+
+    // Build the table by classifying every neighbourhood once
+    memset(rule->table, 0, sizeof(rule->table));
+    for (int count = 0; count <= 8; count++)
+    {
+        int letterCount = (int)strlen(henselLetters[count]);
+        for (int letter = 0; letter < ((letterCount > 0)? letterCount : 1); letter++)
+        {
+            uint16_t base = (count <= 4)? henselMasks[count][letter] : (0x1EF ^ henselMasks[8 - count][letter]);
+            bool born = (accepted[0][count] >> letter) & 1;
+            bool survives = (accepted[1][count] >> letter) & 1;
+
+            for (int symmetry = 0; symmetry < 8; symmetry++)
+            {
+                uint16_t mask = TransformMask(base, symmetry);
+                rule->table[mask] = born;
+                rule->table[mask | HENSEL_CENTER] = survives;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Advance one generation
+void StepHenselLife(const HenselRule *rule, LifeGrid *grid)
+{
+    HenselJob job = { rule, grid };
+
+    RefreshGhostCells(grid);
+    ParallelFor(grid->rows, StepHenselRows, &job);
+
+    uint64_t *swap = grid->cells;
+    grid->cells = grid->next;
+    grid->next = swap;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+// Apply one of the 8 rotations/reflections to a 3x3 mask
+static uint16_t TransformMask(uint16_t mask, int symmetry)
+{
+    uint16_t result = 0;
+    for (int bit = 0; bit < 9; bit++)
+    {
+        if (!(mask & (1 << bit))) continue;
+
+        int x = bit%3 - 1;
+        int y = bit/3 - 1;
+        if (symmetry & 1) x = -x;
+        if (symmetry & 2) y = -y;
+        if (symmetry & 4) { int t = x; x = y; y = t; }
+        result |= 1 << ((y + 1)*3 + (x + 1));
+    }
+    return result;
+}
+
+// Mark the letters of one neighbour count, no letters means every configuration
+static bool ApplyHenselCount(uint16_t *letterMasks, int count, const char *letters, int letterCount, bool except)
+{
+    const char *valid = henselLetters[count];
+    int validCount = (int)strlen(valid);
+    uint16_t all = (validCount > 0)? (uint16_t)((1 << validCount) - 1) : 1;
+
+    if (letterCount == 0)
+    {
+        if (except) return false;
+        *letterMasks = all;
+        return true;
+    }
+
+    uint16_t listed = 0;
+    for (int i = 0; i < letterCount; i++)
+    {
+        const char *found = strchr(valid, letters[i]);
+        if (found == NULL) return false;
+        listed |= 1 << (found - valid);
+    }
+    *letterMasks |= except? (all & ~listed) : listed;
+    return true;
+}
+
+static void StepHenselRows(void *data, int begin, int end)
+{
+    HenselJob *job = (HenselJob *)data;
+    const uint8_t *table = job->rule->table;
+    LifeGrid *grid = job->grid;
+
+    for (int row = begin; row < end; row++)
+    {
+        const uint64_t *above = LIFE_ROW(*grid, grid->cells, row - 1);
+        const uint64_t *center = LIFE_ROW(*grid, grid->cells, row);
+        const uint64_t *below = LIFE_ROW(*grid, grid->cells, row + 1);
+        uint64_t *out = LIFE_ROW(*grid, grid->next, row);
+
+        // Ghost column and column 0 start in the centre and east slots, the first shift moves them west
+        unsigned int index = (unsigned int)(((above[0] >> 63) << 1) | ((center[0] >> 63) << 4) | ((below[0] >> 63) << 7));
+        index |= (unsigned int)(((above[1] & 1) << 2) | ((center[1] & 1) << 5) | ((below[1] & 1) << 8));
+
+        int col = 0;
+        for (int w = 1; col < grid->cols; w++)
+        {
+            // Column col + 1 enters the window, it starts at bit 1 of this word
+            uint64_t a = (above[w] >> 1) | (above[w + 1] << 63);
+            uint64_t c = (center[w] >> 1) | (center[w + 1] << 63);
+            uint64_t b = (below[w] >> 1) | (below[w + 1] << 63);
+            uint64_t result = 0;
+            int bits = (grid->cols - col < 64)? grid->cols - col : 64;
+
+            for (int bit = 0; bit < bits; bit++)
+            {
+                index = ((index >> 1) & HENSEL_KEEP_COLUMNS) | (unsigned int)(((a & 1) << 2) | ((c & 1) << 5) | ((b & 1) << 8));
+                result |= (uint64_t)table[index] << bit;
+                a >>= 1;
+                c >>= 1;
+                b >>= 1;
+            }
+
+            out[w] = result;
+            col += bits;
+        }
+        MarkLifeRowChanges(grid, row, center, out);
+    }
+}
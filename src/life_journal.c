@@ -0,0 +1,276 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Session journal
+*
+*   Every change made to a universe during a session, in order: steps, cell edits, region
+*   edits, engine and topology switches, plus the front end inputs that do not touch cells.
+*   Each event carries the front end frame and the universe generation it happened at, so a
+*   journal replays headlessly into the same cells and times the same work.
+*
+*   Events are kept encoded: a type byte, the frame and generation as deltas from the event
+*   before, then the fields as zigzag varints and the payload bytes, so a one generation step
+*   takes about 10 bytes. A saved journal is a header followed by the events as they are.
+*
+*   NOTE: Densities and clip words are stored in host byte order, journals move between
+*   little-endian hosts only.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define JOURNAL_VERSION 1
+#define JOURNAL_MIN_CAPACITY 4096
+#define JOURNAL_MAX_VARINT 10           // Bytes of a 64 bit varint
+
+static const char journalMagic[8] = { 'G', 'O', 'L', 'J', 'O', 'U', 'R', 'N' };
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+struct LifeJournal {
+    JournalInfo info;
+    unsigned char *data;            // Encoded events
+    size_t size;
+    size_t capacity;
+    int64_t frame;                  // Frame given to events appended from now on
+    int64_t lastFrame;              // Frame and generation of the last event, the base of the next deltas
+    int64_t lastGeneration;
+};
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static bool ReserveJournal(LifeJournal *journal, size_t bytes);
+static void WriteVarint(LifeJournal *journal, int64_t value);
+static bool ReadVarint(const LifeJournal *journal, size_t *offset, int64_t *value);
+
+//----------------------------------------------------------------------------------
+// Journal Functions Definition
+//----------------------------------------------------------------------------------
+
+// Empty journal for a universe of the given size, NULL on failure
+LifeJournal *LoadLifeJournal(int rows, int cols, GridTopology topology)
+{
+    LifeJournal *journal = calloc(1, sizeof(LifeJournal));
+    if (journal == NULL) return NULL;
+
+    journal->info.rows = rows;
+    journal->info.cols = cols;
+    journal->info.topology = topology;
+    if (!ReserveJournal(journal, JOURNAL_MIN_CAPACITY))
+    {
+        UnloadLifeJournal(journal);
+        return NULL;
+    }
+
+    return journal;
+}
+
+// Journal saved by SaveLifeJournal(), NULL when missing or not a journal
+LifeJournal *LoadLifeJournalFile(const char *fileName)
+{
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) return NULL;
+
+    char magic[8] = { 0 };
+    uint32_t header[4] = { 0 };
+    LifeJournal *journal = NULL;
+    if ((fread(magic, 1, sizeof(magic), file) == sizeof(magic)) && (memcmp(magic, journalMagic, sizeof(magic)) == 0) &&
+        (fread(header, sizeof(uint32_t), 4, file) == 4) && (header[0] == JOURNAL_VERSION))
+    {
+        journal = LoadLifeJournal((int)header[1], (int)header[2], (GridTopology)header[3]);
+    }
+
+    // Events are read in as they are and walked once to rebuild the info
+    bool loaded = (journal != NULL);
+    while (loaded && !feof(file))
+    {
+        loaded = ReserveJournal(journal, JOURNAL_MIN_CAPACITY);
+        if (loaded) journal->size += fread(journal->data + journal->size, 1, journal->capacity - journal->size, file);
+    }
+    loaded = loaded && !ferror(file);
+    fclose(file);
+
+    JournalEvent event = { 0 };
+    size_t offset = 0;
+    while (loaded && (offset < journal->size))
+    {
+        loaded = NextLifeJournalEvent(journal, &offset, &event);
+        if (!loaded) break;
+
+        journal->info.events++;
+        journal->lastFrame = journal->info.frames = event.frame;
+        journal->lastGeneration = journal->info.generations = event.generation;
+    }
+    if (!loaded)
+    {
+        UnloadLifeJournal(journal);
+        return NULL;
+    }
+
+    journal->frame = journal->lastFrame;
+    journal->info.bytes = journal->size;
+    return journal;
+}
+
+void UnloadLifeJournal(LifeJournal *journal)
+{
+    if (journal == NULL) return;
+
+    free(journal->data);
+    free(journal);
+}
+
+// Write the header and every event, false on I/O errors
+bool SaveLifeJournal(const LifeJournal *journal, const char *fileName)
+{
+    FILE *file = fopen(fileName, "wb");
+    if (file == NULL) return false;
+
+    uint32_t header[4] = { JOURNAL_VERSION, (uint32_t)journal->info.rows, (uint32_t)journal->info.cols, (uint32_t)journal->info.topology };
+    bool written = (fwrite(journalMagic, 1, sizeof(journalMagic), file) == sizeof(journalMagic)) &&
+        (fwrite(header, sizeof(uint32_t), 4, file) == 4) && (fwrite(journal->data, 1, journal->size, file) == journal->size);
+
+    return (fclose(file) == 0) && written;
+}
+
+// Frame stamped on the events appended from now on, frames only move forward
+void SetLifeJournalFrame(LifeJournal *journal, int64_t frame)
+{
+    if (frame > journal->frame) journal->frame = frame;
+}
+
+// Encode one event at the current frame, the payload is copied, false when out of memory
+bool AppendLifeJournal(LifeJournal *journal, JournalEvent event)
+{
+    int payloadSize = (event.payload != NULL)? event.payloadSize : 0;
+    if (!ReserveJournal(journal, 1 + 8*JOURNAL_MAX_VARINT + sizeof(double) + (size_t)payloadSize)) return false;
+
+    journal->data[journal->size++] = (unsigned char)event.type;
+    WriteVarint(journal, journal->frame - journal->lastFrame);
+    WriteVarint(journal, event.generation - journal->lastGeneration);
+    WriteVarint(journal, event.row);
+    WriteVarint(journal, event.col);
+    WriteVarint(journal, event.height);
+    WriteVarint(journal, event.width);
+    WriteVarint(journal, event.value);
+    if (event.type == JOURNAL_RANDOM)
+    {
+        memcpy(journal->data + journal->size, &event.density, sizeof(double));
+        journal->size += sizeof(double);
+    }
+    WriteVarint(journal, payloadSize);
+    if (payloadSize > 0) memcpy(journal->data + journal->size, event.payload, payloadSize);
+    journal->size += payloadSize;
+
+    journal->lastFrame = journal->frame;
+    journal->lastGeneration = event.generation;
+    journal->info.events++;
+    journal->info.frames = journal->frame;
+    journal->info.generations = event.generation;
+    journal->info.bytes = journal->size;
+    return true;
+}
+
+// Decode the event at offset and move offset past it, false at the end or on a malformed event
+// NOTE: Start from offset 0 and pass the event decoded last, the deltas are taken against it. The payload points
+// into the journal, frame and generation come out absolute
+bool NextLifeJournalEvent(const LifeJournal *journal, size_t *offset, JournalEvent *event)
+{
+    if (*offset >= journal->size) return false;
+
+    // Deltas are relative to the event before, which the caller decoded just before this one
+    int64_t frame = (*offset == 0)? 0 : event->frame;
+    int64_t generation = (*offset == 0)? 0 : event->generation;
+    int64_t fields[8] = { 0 };
+
+    size_t at = *offset;
+    int type = journal->data[at++];
+    for (int i = 0; i < 7; i++)
+    {
+        if (!ReadVarint(journal, &at, &fields[i])) return false;
+    }
+    double density = 0.0;
+    if (type == JOURNAL_RANDOM)
+    {
+        if (journal->size - at < sizeof(double)) return false;
+        memcpy(&density, journal->data + at, sizeof(double));
+        at += sizeof(double);
+    }
+    if (!ReadVarint(journal, &at, &fields[7]) || (fields[7] < 0) || ((uint64_t)fields[7] > journal->size - at)) return false;
+    if ((type < JOURNAL_STEP) || (type > JOURNAL_INPUT)) return false;
+
+    *event = (JournalEvent){ 0 };
+    event->type = (JournalEventType)type;
+    event->frame = frame + fields[0];
+    event->generation = generation + fields[1];
+    event->row = (int)fields[2];
+    event->col = (int)fields[3];
+    event->height = (int)fields[4];
+    event->width = (int)fields[5];
+    event->value = fields[6];
+    event->density = density;
+    event->payloadSize = (int)fields[7];
+    event->payload = (fields[7] > 0)? journal->data + at : NULL;
+    *offset = at + (size_t)fields[7];
+    return true;
+}
+
+JournalInfo GetLifeJournalInfo(const LifeJournal *journal)
+{
+    return journal->info;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Room for bytes more, growing by doubling
+static bool ReserveJournal(LifeJournal *journal, size_t bytes)
+{
+    if (journal->capacity - journal->size >= bytes) return true;
+
+    size_t capacity = (journal->capacity > 0)? journal->capacity : JOURNAL_MIN_CAPACITY;
+    while (capacity - journal->size < bytes) capacity *= 2;
+    unsigned char *data = realloc(journal->data, capacity);
+    if (data == NULL) return false;
+
+    journal->data = data;
+    journal->capacity = capacity;
+    return true;
+}
+
+// Zigzag varint, 7 bits per byte with the high bit set on all bytes but the last
+static void WriteVarint(LifeJournal *journal, int64_t value)
+{
+    uint64_t bits = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    while (bits >= 0x80)
+    {
+        journal->data[journal->size++] = (unsigned char)(bits | 0x80);
+        bits >>= 7;
+    }
+    journal->data[journal->size++] = (unsigned char)bits;
+}
+
+static bool ReadVarint(const LifeJournal *journal, size_t *offset, int64_t *value)
+{
+    uint64_t bits = 0;
+    for (int shift = 0; (shift < 7*JOURNAL_MAX_VARINT) && (*offset < journal->size); shift += 7)
+    {
+        unsigned char byte = journal->data[(*offset)++];
+        bits |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            *value = (int64_t)(bits >> 1) ^ -(int64_t)(bits & 1);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,370 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Larger than Life engine
+*
+*   Radius-R totalistic rules in Golly notation, i.e. "R5,C0,M1,S34..58,B34..45,NM".
+*   Neighbour counts never loop over the neighbourhood:
+*     - Moore (square) counts come from a summed-area table, four reads per cell.
+*     - von Neumann (diamond) counts slide along the row, adding the right edge of the diamond
+*       and dropping the left edge, each edge read from two diagonal prefix-sum tables.
+*
+*   Tables are built with a banded parallel scan, every inner loop runs over contiguous rows.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ScanJob {
+    uint32_t *table;
+    int height;
+    int width;
+    int shift;      // Column offset of the row above each entry adds, -1, 0 or 1
+    int bands;
+} ScanJob;
+
+typedef struct StepJob {
+    LargerLife *life;
+    LifeGrid *grid;
+} StepJob;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static int WrapIndex(GridTopology topology, int value, int size);
+static void FillPaddedRows(void *data, int begin, int end);
+static void PrefixRows(void *data, int begin, int end);
+static void ScanBands(void *data, int begin, int end);
+static void FixBands(void *data, int begin, int end);
+static void ScanColumns(uint32_t *table, int height, int width, int shift);
+static void StepMooreRows(void *data, int begin, int end);
+static void StepDiamondRows(void *data, int begin, int end);
+
+//----------------------------------------------------------------------------------
+// Larger than Life Functions Definition
+//----------------------------------------------------------------------------------
+
+// Parse a Golly LtL rule, missing fields default to R1,C0,M0,NM
+bool ParseLargerRule(const char *text, LargerRule *rule)
+{
+    LargerRule parsed = { 1, false, false, 0, -1, 0, -1 };
+    const char *c = text;
+
+    while (*c != '\0')
+    {
+        int field = toupper((unsigned char)*c++);
+        if (!isdigit((unsigned char)*c) && (field != 'N')) return false;
+
+        if (field == 'N')
+        {
+            int shape = toupper((unsigned char)*c++);
+            if (shape == 'M') parsed.vonNeumann = false;
+            else if (shape == 'N') parsed.vonNeumann = true;
+            else return false;
+        }
+        else
+        {
+            int low = (int)strtol(c, (char **)&c, 10);
+            int high = low;
+            if ((c[0] == '.') && (c[1] == '.')) high = (int)strtol(c + 2, (char **)&c, 10);
+
+            switch (field)
+            {
+                case 'R': parsed.radius = low; break;
+                case 'C': if (low > 2) return false; break;   // Only two-state LtL rules
+                case 'M': parsed.middle = (low != 0); break;
+                case 'S': parsed.surviveMin = low; parsed.surviveMax = high; break;
+                case 'B': parsed.birthMin = low; parsed.birthMax = high; break;
+                default: return false;
+            }
+        }
+
+        if (*c == ',') c++;
+        else if (*c != '\0') return false;
+    }
+
+    if ((parsed.radius < 1) || (parsed.radius > LARGER_MAX_RADIUS)) return false;
+
+    *rule = parsed;
+    return true;
+}
+
+// Allocate padded tables for a grid, padded is NULL on failure
+LargerLife LoadLargerLife(LifeGrid grid, LargerRule rule)
+{
+    LargerLife life = { 0 };
+    life.rule = rule;
+    life.halo = rule.radius + 1;
+    life.width = grid.cols + 2*life.halo;
+    life.height = grid.rows + 2*life.halo;
+
+    size_t entries = (size_t)life.width*life.height;
+    life.padded = malloc(entries);
+    life.tableA = malloc(entries*sizeof(uint32_t));
+    if (rule.vonNeumann) life.tableB = malloc(entries*sizeof(uint32_t));
+
+    if ((life.padded == NULL) || (life.tableA == NULL) || (rule.vonNeumann && (life.tableB == NULL)))
+    {
+        UnloadLargerLife(life);
+        return (LargerLife){ 0 };
+    }
+    return life;
+}
+
+void UnloadLargerLife(LargerLife life)
+{
+    free(life.padded);
+    free(life.tableA);
+    free(life.tableB);
+}
+
+// Advance one generation
+void StepLargerLife(LargerLife *life, LifeGrid *grid)
+{
+    StepJob job = { life, grid };
+
+    // Cells plus a radius-wide halo filled for the grid topology
+    ParallelFor(life->height, FillPaddedRows, &job);
+
+    if (life->rule.vonNeumann)
+    {
+        memcpy(life->tableB, life->tableA, (size_t)life->width*life->height*sizeof(uint32_t));
+        ScanColumns(life->tableA, life->height, life->width, -1);
+        ScanColumns(life->tableB, life->height, life->width, 1);
+        ParallelFor(grid->rows, StepDiamondRows, &job);
+    }
+    else
+    {
+        ParallelFor(life->height, PrefixRows, life);
+        ScanColumns(life->tableA, life->height, life->width, 0);
+        ParallelFor(grid->rows, StepMooreRows, &job);
+    }
+
+    uint64_t *swap = grid->cells;
+    grid->cells = grid->next;
+    grid->next = swap;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+// Map a halo position back onto the grid the same way the ghost border does, -1 if dead
+static int WrapIndex(GridTopology topology, int value, int size)
+{
+    if ((value >= 0) && (value < size)) return value;
+
+    switch (topology)
+    {
+        case TOPOLOGY_TORUS: return ((value%size) + size)%size;
+        case TOPOLOGY_MIRROR:
+        {
+            int period = ((value%(2*size)) + 2*size)%(2*size);
+            return (period < size)? period : 2*size - 1 - period;
+        }
+        default: return -1;
+    }
+}
+
+// Expand cells to one byte each plus the halo, and seed the first table with the same values
+static void FillPaddedRows(void *data, int begin, int end)
+{
+    StepJob *job = (StepJob *)data;
+    LargerLife *life = job->life;
+    LifeGrid *grid = job->grid;
+
+    for (int i = begin; i < end; i++)
+    {
+        uint8_t *out = life->padded + (size_t)i*life->width;
+        uint32_t *table = life->tableA + (size_t)i*life->width;
+        int row = WrapIndex(grid->topology, i - life->halo, grid->rows);
+        if (row < 0)
+        {
+            memset(out, 0, life->width);
+            memset(table, 0, life->width*sizeof(uint32_t));
+            continue;
+        }
+
+        const uint64_t *cells = LIFE_ROW(*grid, grid->cells, row);
+        uint8_t *interior = out + life->halo;
+        for (int col = 0; col < grid->cols; col++) interior[col] = (cells[1 + col/64] >> (col%64)) & 1;
+
+        // Only the halo columns need the topology lookup
+        for (int j = 0; j < life->halo; j++)
+        {
+            int left = WrapIndex(grid->topology, j - life->halo, grid->cols);
+            int right = WrapIndex(grid->topology, grid->cols + j, grid->cols);
+            out[j] = (left < 0)? 0 : interior[left];
+            interior[grid->cols + j] = (right < 0)? 0 : interior[right];
+        }
+
+        for (int j = 0; j < life->width; j++) table[j] = out[j];
+    }
+}
+
+// Horizontal inclusive prefix sums, first half of the summed-area table
+static void PrefixRows(void *data, int begin, int end)
+{
+    LargerLife *life = (LargerLife *)data;
+    for (int i = begin; i < end; i++)
+    {
+        uint32_t *row = life->tableA + (size_t)i*life->width;
+        for (int j = 1; j < life->width; j++) row[j] += row[j - 1];
+    }
+}
+
+// Scan every band as if the rows above it were zero
+static void ScanBands(void *data, int begin, int end)
+{
+    ScanJob *job = (ScanJob *)data;
+    int from = (job->shift < 0)? 1 : 0;
+    int to = (job->shift > 0)? job->width - 1 : job->width;
+
+    for (int band = begin; band < end; band++)
+    {
+        int first = (int)((int64_t)job->height*band/job->bands);
+        int last = (int)((int64_t)job->height*(band + 1)/job->bands);
+        for (int i = first + 1; i < last; i++)
+        {
+            uint32_t *row = job->table + (size_t)i*job->width;
+            const uint32_t *above = row - job->width + job->shift;
+            for (int j = from; j < to; j++) row[j] += above[j];
+        }
+    }
+}
+
+// Add the final last row of the previous band, shifted once per row below it
+static void FixBands(void *data, int begin, int end)
+{
+    ScanJob *job = (ScanJob *)data;
+
+    for (int band = (begin < 1)? 1 : begin; band < end; band++)
+    {
+        int first = (int)((int64_t)job->height*band/job->bands);
+        int last = (int)((int64_t)job->height*(band + 1)/job->bands);
+        const uint32_t *carry = job->table + (size_t)(first - 1)*job->width;
+
+        // The last row of the band was already fixed up in order by ScanColumns()
+        for (int i = first; i < last - 1; i++)
+        {
+            uint32_t *row = job->table + (size_t)i*job->width;
+            int offset = job->shift*(i - first + 1);
+            int from = (offset < 0)? -offset : 0;
+            int to = (offset > 0)? job->width - offset : job->width;
+            for (int j = from; j < to; j++) row[j] += carry[j + offset];
+        }
+    }
+}
+
+// table[i][j] += table[i - 1][j + shift] for every row, top to bottom
+static void ScanColumns(uint32_t *table, int height, int width, int shift)
+{
+    ScanJob job = { table, height, width, shift, GetParallelWorkers()*2 };
+    if (job.bands > height) job.bands = height;
+
+    ParallelFor(job.bands, ScanBands, &job);
+
+    // Carry the true last row of every band into the next one, only bands*width work
+    for (int band = 1; band < job.bands; band++)
+    {
+        int first = (int)((int64_t)height*band/job.bands);
+        int last = (int)((int64_t)height*(band + 1)/job.bands);
+        const uint32_t *carry = table + (size_t)(first - 1)*width;
+        uint32_t *row = table + (size_t)(last - 1)*width;
+        int offset = shift*(last - first);
+        int from = (offset < 0)? -offset : 0;
+        int to = (offset > 0)? width - offset : width;
+        if (from > width) from = width;
+        for (int j = from; j < to; j++) row[j] += carry[j + offset];
+    }
+
+    ParallelFor(job.bands, FixBands, &job);
+}
+
+static void StepMooreRows(void *data, int begin, int end)
+{
+    StepJob *job = (StepJob *)data;
+    LargerLife *life = job->life;
+    LifeGrid *grid = job->grid;
+    LargerRule rule = life->rule;
+    int radius = rule.radius;
+    int width = life->width;
+
+    for (int row = begin; row < end; row++)
+    {
+        int i = row + life->halo;
+        const uint32_t *top = life->tableA + (size_t)(i - radius - 1)*width;
+        const uint32_t *bottom = life->tableA + (size_t)(i + radius)*width;
+        const uint64_t *cells = LIFE_ROW(*grid, grid->cells, row);
+        uint64_t *out = LIFE_ROW(*grid, grid->next, row);
+
+        for (int w = 1; w <= 1 + (grid->cols - 1)/64; w++) out[w] = 0;
+        for (int col = 0; col < grid->cols; col++)
+        {
+            int j = col + life->halo;
+            int count = (int)(bottom[j + radius] - top[j + radius] - bottom[j - radius - 1] + top[j - radius - 1]);
+            int alive = (cells[1 + col/64] >> (col%64)) & 1;
+            if (!rule.middle) count -= alive;
+
+            bool next = alive? ((count >= rule.surviveMin) && (count <= rule.surviveMax)) : ((count >= rule.birthMin) && (count <= rule.birthMax));
+            out[1 + col/64] |= (uint64_t)next << (col%64);
+        }
+        MarkLifeRowChanges(grid, row, cells, out);
+    }
+}
+
+static void StepDiamondRows(void *data, int begin, int end)
+{
+    StepJob *job = (StepJob *)data;
+    LargerLife *life = job->life;
+    LifeGrid *grid = job->grid;
+    LargerRule rule = life->rule;
+    int radius = rule.radius;
+    int width = life->width;
+    const uint32_t *down = life->tableA;    // "\" diagonals, each entry adds the one up-left
+    const uint32_t *up = life->tableB;      // "/" diagonals, each entry adds the one up-right
+
+    for (int row = begin; row < end; row++)
+    {
+        int i = row + life->halo;
+        const uint64_t *cells = LIFE_ROW(*grid, grid->cells, row);
+        uint64_t *out = LIFE_ROW(*grid, grid->next, row);
+
+        // Full diamond for the first column, then slide it one column at a time
+        int count = 0;
+        for (int dr = -radius; dr <= radius; dr++)
+        {
+            int span = radius - abs(dr);
+            const uint8_t *padded = life->padded + (size_t)(i + dr)*width + life->halo;
+            for (int dc = -span; dc <= span; dc++) count += padded[dc];
+        }
+
+        for (int w = 1; w <= 1 + (grid->cols - 1)/64; w++) out[w] = 0;
+        for (int col = 0; col < grid->cols; col++)
+        {
+            int j = col + life->halo;
+            if (col > 0)
+            {
+                // Diamond centred on j - 1 moves to j: add its right edge, drop its left edge
+                int c = j - 1;
+                int rightUpper = (int)(down[(size_t)i*width + c + 1 + radius] - down[(size_t)(i - radius - 1)*width + c]);
+                int rightLower = (int)(up[(size_t)(i + radius)*width + c + 1] - up[(size_t)i*width + c + radius + 1]);
+                int leftUpper = (int)(up[(size_t)i*width + c - radius] - up[(size_t)(i - radius - 1)*width + c + 1]);
+                int leftLower = (int)(down[(size_t)(i + radius)*width + c] - down[(size_t)i*width + c - radius]);
+                count += rightUpper + rightLower - leftUpper - leftLower;
+            }
+
+            int alive = (cells[1 + col/64] >> (col%64)) & 1;
+            int neighbours = rule.middle? count : count - alive;
+
+            bool next = alive? ((neighbours >= rule.surviveMin) && (neighbours <= rule.surviveMax)) : ((neighbours >= rule.birthMin) && (neighbours <= rule.birthMax));
+            out[1 + col/64] |= (uint64_t)next << (col%64);
+        }
+        MarkLifeRowChanges(grid, row, cells, out);
+    }
+}
@@ -0,0 +1,465 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Mapped board
+*
+*   Keeps a bit-packed board in a memory-mapped file, so boards larger than RAM can be
+*   stepped at the speed the disk streams them.
+*
+*   The board is cut into square tiles of tileSize cells, and each tile is stored as one
+*   contiguous block of rows of tileSize/64 words. Tiles are laid out in row-major tile order
+*   in two buffers, one holding the current generation and one receiving the next.
+*
+*   A generation is stepped tile by tile in file order. Each tile is copied into a small
+*   grid, with its ghost cells taken from the neighbouring tiles, stepped there, and written
+*   to the other buffer with pwrite() so output pages are never read in first. The tiles
+*   ahead are prefetched with madvise() as far as the RAM budget allows. When both buffers do
+*   not fit the budget, tiles are dropped from the mapping and the page cache as soon as the
+*   walk is past them.
+*
+*   File layout, integers in host byte order:
+*
+*       0       "GOLTILES"
+*       8       uint32 version, rows, cols, topology, tile size, buffer holding the current generation
+*       32      int64 generation
+*       65536   buffer 0 tiles, then buffer 1 tiles
+*
+*   NOTE: Boards step plain B3/S23. A new file is sparse, dead tiles take no disk space
+*   until first written. Windows builds can not open boards.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#if !defined(_WIN32)
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define MAPPED_VERSION 1
+#define MAPPED_HEADER_BYTES 65536   // Keeps tiles page aligned for every page size in use
+#define MAPPED_MIN_TILE 256         // 8 KiB tiles, the smallest that stay page aligned
+#define MAPPED_MAX_TILE 16384       // 32 MiB tiles
+#define MAPPED_FIXED_TILES 6        // Tile, left neighbour, work grid (2), staging and one in writeback
+
+static const char mappedMagic[8] = { 'G', 'O', 'L', 'T', 'I', 'L', 'E', 'S' };
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct MappedHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t topology;
+    uint32_t tileSize;
+    uint32_t current;       // Buffer holding the current generation
+    int64_t generation;
+} MappedHeader;
+
+struct LifeMapped {
+    int fd;
+    unsigned char *base;    // Whole file mapped
+    size_t size;
+    MappedHeader *header;
+    MappedInfo info;
+    int tileWords;          // Words per tile row
+    size_t tileBytes;
+    size_t bufferBytes;
+    size_t pageSize;
+    bool release;           // Both buffers exceed the budget, drop tiles behind the walk
+    LifeGrid work;          // One tile with its ghost cells
+    uint64_t *staging;      // Next generation of one tile in file layout
+};
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static LifeMapped *MapBoard(int fd, int64_t budget);
+static uint64_t *GetTile(const LifeMapped *board, int buffer, int64_t tile);
+static bool GetBoardCell(const LifeMapped *board, int buffer, int row, int col);
+static void LoadTile(LifeMapped *board, int tileRow, int tileCol);
+static bool StoreTile(LifeMapped *board, int64_t tile);
+static void AdviseTiles(LifeMapped *board, int buffer, int64_t first, int64_t count, int advice);
+static void ReleaseTile(LifeMapped *board, int buffer, int64_t tile);
+
+//----------------------------------------------------------------------------------
+// Mapped Board Functions Definition
+//----------------------------------------------------------------------------------
+
+// Create (or replace) the board file at path, tile size is picked to fit budget bytes of RAM
+LifeMapped *CreateLifeMapped(const char *path, int rows, int cols, GridTopology topology, int64_t budget)
+{
+    if ((rows <= 0) || (cols <= 0)) return NULL;
+
+    // Largest tile leaving at least half the budget to prefetch, no larger than the board needs
+    int tileSize = MAPPED_MIN_TILE;
+    while ((tileSize < MAPPED_MAX_TILE) && ((tileSize < rows) || (tileSize < cols)) &&
+           ((int64_t)MAPPED_FIXED_TILES*(2*tileSize)*(2*tileSize)/8 <= budget/2)) tileSize *= 2;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return NULL;
+
+    MappedHeader header = { 0 };
+    memcpy(header.magic, mappedMagic, sizeof(mappedMagic));
+    header.version = MAPPED_VERSION;
+    header.rows = (uint32_t)rows;
+    header.cols = (uint32_t)cols;
+    header.topology = (uint32_t)topology;
+    header.tileSize = (uint32_t)tileSize;
+
+    // Two buffers of whole tiles, left sparse so the board starts dead without writing it
+    int64_t tiles = (int64_t)((rows + tileSize - 1)/tileSize)*((cols + tileSize - 1)/tileSize);
+    int64_t fileBytes = MAPPED_HEADER_BYTES + 2*tiles*((int64_t)tileSize*tileSize/8);
+    if ((fileBytes != (int64_t)(off_t)fileBytes) || (ftruncate(fd, (off_t)fileBytes) != 0) ||
+        (pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)))
+    {
+        close(fd);
+        unlink(path);
+        return NULL;
+    }
+
+    LifeMapped *board = MapBoard(fd, budget);
+    if (board == NULL) unlink(path);
+    return board;
+}
+
+// Open a board file written by CreateLifeMapped(), it resumes at the generation it was closed at
+LifeMapped *OpenLifeMapped(const char *path, int64_t budget)
+{
+    int fd = open(path, O_RDWR);
+    if (fd < 0) return NULL;
+
+    return MapBoard(fd, budget);
+}
+
+void CloseLifeMapped(LifeMapped *board)
+{
+    if (board == NULL) return;
+
+    msync(board->base, board->size, MS_SYNC);
+    munmap(board->base, board->size);
+    close(board->fd);
+
+    // Edge tiles shrink the work grid, its buffers were allocated for a whole tile
+    board->work.rows = board->info.tileSize;
+    board->work.cols = board->info.tileSize;
+    UnloadLifeGrid(board->work);
+    free(board->staging);
+    free(board);
+}
+
+MappedInfo GetLifeMappedInfo(const LifeMapped *board)
+{
+    MappedInfo info = board->info;
+    info.generation = board->header->generation;
+    return info;
+}
+
+bool GetMappedCell(const LifeMapped *board, int row, int col)
+{
+    if ((row < 0) || (col < 0) || (row >= board->info.rows) || (col >= board->info.cols)) return false;
+
+    return GetBoardCell(board, board->header->current, row, col);
+}
+
+void SetMappedCell(LifeMapped *board, int row, int col, bool alive)
+{
+    if ((row < 0) || (col < 0) || (row >= board->info.rows) || (col >= board->info.cols)) return;
+
+    int tileSize = board->info.tileSize;
+    uint64_t *tile = GetTile(board, board->header->current, (int64_t)(row/tileSize)*board->info.tilesAcross + col/tileSize);
+    uint64_t *word = tile + (size_t)(row%tileSize)*board->tileWords + (col%tileSize)/64;
+    uint64_t bit = 1ULL << (col%64);
+    if (alive) *word |= bit;
+    else *word &= ~bit;
+}
+
+// Advance generations, tiles are visited in file order so reads and writes stream
+bool StepLifeMapped(LifeMapped *board, int generations)
+{
+    double start = GetLifeSeconds();
+    int64_t tiles = (int64_t)board->info.tilesDown*board->info.tilesAcross;
+    int across = board->info.tilesAcross;
+    bool torus = (board->info.topology == TOPOLOGY_TORUS);
+
+    for (int i = 0; i < generations; i++)
+    {
+        int current = board->header->current;
+        for (int64_t tile = 0; tile < tiles; tile++)
+        {
+            // Prefetch window slides one tile at a time, it is only a hint the kernel may trim
+            int prefetch = board->info.prefetchTiles;
+            if ((prefetch > 0) && (tile == 0)) AdviseTiles(board, current, 1, prefetch, MADV_WILLNEED);
+            else if (prefetch > 0) AdviseTiles(board, current, tile + prefetch, 1, MADV_WILLNEED);
+
+            LoadTile(board, (int)(tile/across), (int)(tile%across));
+            StepLifeRows(&board->work, 0, board->work.rows);
+            if (!StoreTile(board, tile))
+            {
+                board->info.stepSeconds = GetLifeSeconds() - start;
+                return false;
+            }
+
+            // Left neighbour is done, on a torus the first tile of the row waits for the last one
+            int col = (int)(tile%across);
+            if (board->release && (col > 0) && !(torus && (col == 1))) ReleaseTile(board, current, tile - 1);
+            if (board->release && torus && (col == across - 1) && (across > 1)) ReleaseTile(board, current, tile - col);
+            if (board->release && (col == across - 1)) ReleaseTile(board, current, tile);
+        }
+
+        board->header->current = (uint32_t)(current ^ 1);
+        board->header->generation++;
+    }
+
+    board->info.stepSeconds = GetLifeSeconds() - start;
+    return true;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Check the header, map the file and allocate the tile buffers, closes fd on failure
+static LifeMapped *MapBoard(int fd, int64_t budget)
+{
+    struct stat status;
+    MappedHeader header;
+    if ((fstat(fd, &status) != 0) || (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) ||
+        (memcmp(header.magic, mappedMagic, sizeof(mappedMagic)) != 0) || (header.version != MAPPED_VERSION) ||
+        (header.rows == 0) || (header.cols == 0) || (header.rows > INT32_MAX) || (header.cols > INT32_MAX) ||
+        (header.tileSize < MAPPED_MIN_TILE) || (header.tileSize > MAPPED_MAX_TILE) || (header.tileSize%64 != 0) ||
+        (header.topology > TOPOLOGY_MIRROR) || (header.current > 1))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    LifeMapped *board = calloc(1, sizeof(LifeMapped));
+    if (board == NULL)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    int tileSize = (int)header.tileSize;
+    board->fd = fd;
+    board->info.rows = (int)header.rows;
+    board->info.cols = (int)header.cols;
+    board->info.topology = (GridTopology)header.topology;
+    board->info.tileSize = tileSize;
+    board->info.tilesDown = (board->info.rows + tileSize - 1)/tileSize;
+    board->info.tilesAcross = (board->info.cols + tileSize - 1)/tileSize;
+    board->tileWords = tileSize/64;
+    board->tileBytes = (size_t)tileSize*tileSize/8;
+    board->bufferBytes = (size_t)board->info.tilesDown*board->info.tilesAcross*board->tileBytes;
+    board->size = MAPPED_HEADER_BYTES + 2*board->bufferBytes;
+    board->info.fileBytes = (int64_t)board->size;
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    board->pageSize = (pageSize > 0)? (size_t)pageSize : 4096;
+
+    // Whatever the budget leaves after the tiles being worked on goes to read ahead
+    int64_t tiles = (int64_t)board->info.tilesDown*board->info.tilesAcross;
+    int64_t spare = budget/(int64_t)board->tileBytes - MAPPED_FIXED_TILES;
+    board->info.prefetchTiles = (int)((spare < 0)? 0 : (spare > tiles)? tiles : spare);
+    board->release = ((int64_t)(2*board->bufferBytes) > budget);
+
+    void *base = MAP_FAILED;
+    if ((size_t)status.st_size == board->size) base = mmap(NULL, board->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    board->work = LoadLifeGrid(tileSize, tileSize, TOPOLOGY_DEAD_EDGE);
+    board->staging = malloc(board->tileBytes);
+    if ((base == MAP_FAILED) || (board->work.cells == NULL) || (board->staging == NULL))
+    {
+        if (base != MAP_FAILED) munmap(base, board->size);
+        UnloadLifeGrid(board->work);
+        free(board->staging);
+        free(board);
+        close(fd);
+        return NULL;
+    }
+
+    board->base = (unsigned char *)base;
+    board->header = (MappedHeader *)base;
+    if (board->info.prefetchTiles == 0) madvise(board->base + MAPPED_HEADER_BYTES, 2*board->bufferBytes, MADV_SEQUENTIAL);
+
+    return board;
+}
+
+static uint64_t *GetTile(const LifeMapped *board, int buffer, int64_t tile)
+{
+    return (uint64_t *)(board->base + MAPPED_HEADER_BYTES + (size_t)buffer*board->bufferBytes + (size_t)tile*board->tileBytes);
+}
+
+// Cell of the board at (row, col), positions past the edge follow the topology
+static bool GetBoardCell(const LifeMapped *board, int buffer, int row, int col)
+{
+    int rows = board->info.rows;
+    int cols = board->info.cols;
+    if ((row < 0) || (row >= rows) || (col < 0) || (col >= cols))
+    {
+        switch (board->info.topology)
+        {
+            case TOPOLOGY_TORUS:
+                row = (row + rows)%rows;
+                col = (col + cols)%cols;
+                break;
+            case TOPOLOGY_MIRROR:
+                row = (row < 0)? -1 - row : (row >= rows)? 2*rows - 1 - row : row;
+                col = (col < 0)? -1 - col : (col >= cols)? 2*cols - 1 - col : col;
+                break;
+            case TOPOLOGY_DEAD_EDGE:
+            default: return false;
+        }
+    }
+
+    int tileSize = board->info.tileSize;
+    const uint64_t *tile = GetTile(board, buffer, (int64_t)(row/tileSize)*board->info.tilesAcross + col/tileSize);
+    return (tile[(size_t)(row%tileSize)*board->tileWords + (col%tileSize)/64] >> (col%64)) & 1;
+}
+
+// Copy one tile of the current generation into the work grid and fill its ghost cells
+static void LoadTile(LifeMapped *board, int tileRow, int tileCol)
+{
+    LifeGrid *work = &board->work;
+    int tileSize = board->info.tileSize;
+    int firstRow = tileRow*tileSize;
+    int firstCol = tileCol*tileSize;
+    int current = board->header->current;
+    const uint64_t *tile = GetTile(board, current, (int64_t)tileRow*board->info.tilesAcross + tileCol);
+
+    // Edge tiles are stepped at their real size so ghosts sit right after the last cell
+    work->rows = (board->info.rows - firstRow < tileSize)? board->info.rows - firstRow : tileSize;
+    work->cols = (board->info.cols - firstCol < tileSize)? board->info.cols - firstCol : tileSize;
+
+    for (int row = 0; row < work->rows; row++)
+    {
+        uint64_t *cells = LIFE_ROW(*work, work->cells, row);
+        memcpy(cells + 1, tile + (size_t)row*board->tileWords, board->tileWords*sizeof(uint64_t));
+        cells[0] = 0;
+        cells[board->tileWords + 1] = 0;
+        cells[board->tileWords + 2] = 0;
+        SetLifeCell(work, row, -1, GetBoardCell(board, current, firstRow + row, firstCol - 1));
+        SetLifeCell(work, row, work->cols, GetBoardCell(board, current, firstRow + row, firstCol + work->cols));
+    }
+
+    int ghostRows[2] = { -1, work->rows };
+    for (int i = 0; i < 2; i++)
+    {
+        memset(LIFE_ROW(*work, work->cells, ghostRows[i]), 0, work->stride*sizeof(uint64_t));
+        for (int col = -1; col <= work->cols; col++)
+        {
+            if (GetBoardCell(board, current, firstRow + ghostRows[i], firstCol + col)) SetLifeCell(work, ghostRows[i], col, true);
+        }
+    }
+}
+
+// Write the stepped work grid to the tile of the next generation buffer
+static bool StoreTile(LifeMapped *board, int64_t tile)
+{
+    LifeGrid *work = &board->work;
+    int words = (work->cols + 63)/64;
+
+    for (int row = 0; row < work->rows; row++)
+    {
+        uint64_t *out = board->staging + (size_t)row*board->tileWords;
+        memcpy(out, LIFE_ROW(*work, work->next, row) + 1, words*sizeof(uint64_t));
+        memset(out + words, 0, (board->tileWords - words)*sizeof(uint64_t));
+    }
+    memset(board->staging + (size_t)work->rows*board->tileWords, 0, (size_t)(board->info.tileSize - work->rows)*board->tileWords*sizeof(uint64_t));
+
+    int next = board->header->current ^ 1;
+    off_t offset = (off_t)((unsigned char *)GetTile(board, next, tile) - board->base);
+    const unsigned char *bytes = (const unsigned char *)board->staging;
+    for (size_t written = 0; written < board->tileBytes;)
+    {
+        ssize_t result = pwrite(board->fd, bytes + written, board->tileBytes - written, offset + (off_t)written);
+        if (result <= 0) return false;
+        written += (size_t)result;
+    }
+
+#if defined(POSIX_FADV_DONTNEED)
+    // Starts writeback now instead of when the dirty limit is hit
+    if (board->release) posix_fadvise(board->fd, offset, (off_t)board->tileBytes, POSIX_FADV_DONTNEED);
+#endif
+    return true;
+}
+
+// Give advice on whole tiles of one buffer, count is clipped to the buffer
+static void AdviseTiles(LifeMapped *board, int buffer, int64_t first, int64_t count, int advice)
+{
+    int64_t tiles = (int64_t)board->info.tilesDown*board->info.tilesAcross;
+    if (first >= tiles) return;
+    if (first + count > tiles) count = tiles - first;
+
+    // Dropping pages must stay inside the tiles, reading ahead may spill over
+    uintptr_t start = (uintptr_t)GetTile(board, buffer, first);
+    uintptr_t end = start + (size_t)count*board->tileBytes;
+    if (advice == MADV_DONTNEED)
+    {
+        start = (start + board->pageSize - 1)/board->pageSize*board->pageSize;
+        end = end/board->pageSize*board->pageSize;
+    }
+    else start = start/board->pageSize*board->pageSize;
+
+    if (end > start) madvise((void *)start, end - start, advice);
+}
+
+// Drop a tile the walk is done with from the mapping and the page cache
+static void ReleaseTile(LifeMapped *board, int buffer, int64_t tile)
+{
+    AdviseTiles(board, buffer, tile, 1, MADV_DONTNEED);
+#if defined(POSIX_FADV_DONTNEED)
+    off_t offset = (off_t)((unsigned char *)GetTile(board, buffer, tile) - board->base);
+    posix_fadvise(board->fd, offset, (off_t)board->tileBytes, POSIX_FADV_DONTNEED);
+#endif
+}
+
+#else
+
+//----------------------------------------------------------------------------------
+// Mapped Board Functions Definition (Windows)
+//----------------------------------------------------------------------------------
+
+// Windows has no mmap() or pwrite(), boards never open and the other calls never get a board
+LifeMapped *CreateLifeMapped(const char *path, int rows, int cols, GridTopology topology, int64_t budget)
+{
+    return NULL;
+}
+
+LifeMapped *OpenLifeMapped(const char *path, int64_t budget)
+{
+    return NULL;
+}
+
+void CloseLifeMapped(LifeMapped *board)
+{
+}
+
+MappedInfo GetLifeMappedInfo(const LifeMapped *board)
+{
+    return (MappedInfo){ 0 };
+}
+
+bool GetMappedCell(const LifeMapped *board, int row, int col)
+{
+    return false;
+}
+
+void SetMappedCell(LifeMapped *board, int row, int col, bool alive)
+{
+}
+
+bool StepLifeMapped(LifeMapped *board, int generations)
+{
+    return false;
+}
+
+#endif
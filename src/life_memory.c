@@ -0,0 +1,196 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Grid memory
+*
+*   Allocates the cell buffers of large grids on huge pages, placed next to the threads
+*   that step them.
+*
+*   Grids of a huge page and more get their own anonymous mapping instead of heap
+*   memory: explicit huge pages from the hugetlb pool when asked for, otherwise a huge page
+*   aligned mapping marked for transparent huge pages. Either way the mapping is not touched
+*   when created. Each ParallelFor() thread then zeroes the same row band it gets when the
+*   grid is stepped, so on NUMA systems the kernel places every band on the node of the thread
+*   that works on it (first touch).
+*
+*   NOTE: Placement follows threads, not cores: pool threads are not pinned, so bands only stay
+*   local while the scheduler keeps threads on their node. Windows builds have no anonymous
+*   mappings here and keep every grid on the heap.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define MEMORY_HUGE_PAGE_BYTES (2*1024*1024)    // x86-64 and arm64 (4 KiB granule) huge page
+#define MEMORY_MAPPED_BYTES MEMORY_HUGE_PAGE_BYTES        // Smaller grids stay on the heap
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TouchJob {
+    uint64_t *buffers;
+    int rows;
+    int stride;
+} TouchJob;
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static GridMemory preferredMemory = MEMORY_HUGE_PAGES;
+static const char *memoryNames[] = { "heap", "pages", "transparent huge pages", "explicit huge pages" };
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static size_t GetMappedBytes(int rows, int stride);
+static void TouchRows(void *data, int begin, int end);
+
+//----------------------------------------------------------------------------------
+// Grid Memory Functions Definition
+//----------------------------------------------------------------------------------
+
+// Memory used by grids loaded from now on, unavailable kinds fall back to smaller pages
+void SetLifeGridMemory(GridMemory preferred)
+{
+    preferredMemory = preferred;
+}
+
+GridMemory GetLifeGridMemory(void)
+{
+    return preferredMemory;
+}
+
+GridMemoryInfo GetLifeGridMemoryInfo(LifeGrid grid)
+{
+    GridMemoryInfo info = { 0 };
+    info.memory = grid.memory;
+    info.threads = (grid.memory == MEMORY_HEAP)? 1 : GetParallelWorkers();
+    info.numaNodes = 1;
+
+#if defined(_WIN32)
+    long pageSize = 4096;
+#else
+    long pageSize = sysconf(_SC_PAGESIZE);
+#endif
+    info.pageBytes = (grid.memory >= MEMORY_HUGE_PAGES)? MEMORY_HUGE_PAGE_BYTES : (pageSize > 0)? (size_t)pageSize : 4096;
+
+#if defined(__linux__)
+    // Transparent huge pages are as large as the kernel makes them, not always 2 MiB
+    if (grid.memory == MEMORY_HUGE_PAGES)
+    {
+        FILE *file = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+        if (file != NULL)
+        {
+            unsigned long long hugeBytes = 0;
+            if ((fscanf(file, "%llu", &hugeBytes) == 1) && (hugeBytes > 0)) info.pageBytes = (size_t)hugeBytes;
+            fclose(file);
+        }
+    }
+
+    // Memory nodes are numbered from 0 without gaps on every system seen so far
+    for (int node = 1; node < 1024; node++)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", node);
+        if (access(path, F_OK) != 0) break;
+        info.numaNodes = node + 1;
+    }
+#endif
+
+    return info;
+}
+
+const char *GetGridMemoryName(GridMemory memory)
+{
+    if ((memory < MEMORY_HEAP) || (memory > MEMORY_HUGE_TLB)) return "unknown";
+    return memoryNames[memory];
+}
+
+// Both cell buffers of a grid in one zeroed block, 2*(rows + 2)*stride words
+uint64_t *LoadGridBuffers(int rows, int stride, GridMemory *memory)
+{
+    size_t bytes = 2*(size_t)(rows + 2)*stride*sizeof(uint64_t);
+    *memory = MEMORY_HEAP;
+    if ((preferredMemory == MEMORY_HEAP) || (bytes < MEMORY_MAPPED_BYTES)) return calloc(bytes, 1);
+
+#if defined(_WIN32)
+    return calloc(bytes, 1);
+#else
+    size_t mappedBytes = GetMappedBytes(rows, stride);
+    unsigned char *base = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    if (preferredMemory == MEMORY_HUGE_TLB)
+    {
+        base = mmap(NULL, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) *memory = MEMORY_HUGE_TLB;
+    }
+#endif
+
+    if (base == MAP_FAILED)
+    {
+        // Map one huge page more and trim it so the buffers start on a huge page boundary
+        unsigned char *mapped = mmap(NULL, mappedBytes + MEMORY_HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) return calloc(bytes, 1);
+
+        size_t head = (MEMORY_HUGE_PAGE_BYTES - (uintptr_t)mapped%MEMORY_HUGE_PAGE_BYTES)%MEMORY_HUGE_PAGE_BYTES;
+        if (head > 0) munmap(mapped, head);
+        munmap(mapped + head + mappedBytes, MEMORY_HUGE_PAGE_BYTES - head);
+        base = mapped + head;
+
+        *memory = MEMORY_PAGES;
+#if defined(MADV_HUGEPAGE)
+        if ((preferredMemory >= MEMORY_HUGE_PAGES) && (madvise(base, mappedBytes, MADV_HUGEPAGE) == 0)) *memory = MEMORY_HUGE_PAGES;
+#endif
+    }
+
+    // Pages are still untouched, let every thread fault in the band it will step
+    TouchJob job = { (uint64_t *)base, rows, stride };
+    ParallelFor(rows, TouchRows, &job);
+
+    return (uint64_t *)base;
+#endif
+}
+
+void UnloadGridBuffers(uint64_t *buffers, int rows, int stride, GridMemory memory)
+{
+    if (memory == MEMORY_HEAP) free(buffers);
+#if !defined(_WIN32)
+    else if (buffers != NULL) munmap(buffers, GetMappedBytes(rows, stride));
+#endif
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Whole huge pages, explicit huge page mappings can only be that long
+static size_t GetMappedBytes(int rows, int stride)
+{
+    size_t bytes = 2*(size_t)(rows + 2)*stride*sizeof(uint64_t);
+    return (bytes + MEMORY_HUGE_PAGE_BYTES - 1)/MEMORY_HUGE_PAGE_BYTES*MEMORY_HUGE_PAGE_BYTES;
+}
+
+// Zero rows [begin, end) of both buffers, the first and last band take the ghost rows
+static void TouchRows(void *data, int begin, int end)
+{
+    TouchJob *job = (TouchJob *)data;
+    size_t words = (size_t)(job->rows + 2)*job->stride;
+    int first = (begin == 0)? 0 : begin + 1;
+    int last = (end == job->rows)? end + 2 : end + 1;
+
+    for (int i = 0; i < 2; i++)
+    {
+        memset(job->buffers + i*words + (size_t)first*job->stride, 0, (size_t)(last - first)*job->stride*sizeof(uint64_t));
+    }
+}
@@ -0,0 +1,587 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Object labelling
+*
+*   Splits the live cells of a grid into objects, groups of cells connected through their
+*   orthogonal or all eight neighbours, with bounding boxes and a hash of their shape that
+*   does not change with rotation or reflection.
+*
+*   Labelling works on runs of live cells, not cells: every ParallelFor() thread turns the
+*   packed words of its row band into runs and joins runs touching the run above in a
+*   union-find, a link always pointing to the lower run. Band seams and torus edges are
+*   joined afterwards, then one pass in run order numbers the objects top to bottom.
+*   Boxes, populations and shape hashes are worked out per object on every thread again.
+*
+*   Shapes up to OBJECTS_MAX_SHAPE cells across are hashed in every orientation and the
+*   lowest hash is kept, then looked up among every phase of common still lifes,
+*   oscillators and spaceships. Phases are labelled with the same adjacency as the board
+*   and only phases that form a single object are known: the pulsar, one beacon phase and
+*   the spaceship phases throwing off a spark split up and go unnamed, as do the glider and
+*   several still lifes with orthogonal adjacency.
+*
+*   NOTE: Objects touching across a torus edge are one object. Their box is given in board
+*   cells and covers both sides, and their shape is not hashed.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define OBJECTS_MAX_SHAPE 64        // Wider or taller objects are not hashed
+#define OBJECTS_KNOWN_MARGIN 8      // Room around known patterns while they are stepped through their phases
+#define OBJECTS_MAX_KNOWN 256       // Phases and orientations of every known pattern, with room to spare
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ObjectRun {
+    int row;
+    int begin;
+    int end;                // One past the last live cell
+} ObjectRun;
+
+typedef struct KnownShape {
+    uint64_t hash;
+    const char *name;
+} KnownShape;
+
+typedef struct KnownPattern {
+    const char *name;
+    const char *cells;      // Rows split by '/', 'o' for live cells
+    int period;
+} KnownPattern;
+
+struct LifeObjects {
+    ObjectAdjacency adjacency;
+    LifeGrid grid;              // Grid being labelled, only valid during LabelLifeObjects()
+    int *rowRuns;               // First run of every row, rows + 1 entries
+    uint8_t *seams;             // Rows starting a ParallelFor() band, joined to the row above afterwards
+    int rowCapacity;
+    ObjectRun *runs;
+    int *parent;                // Union-find links, then the object of every run
+    int *objectRuns;            // Runs sorted by object
+    int runCapacity;
+    LifeObject *objects;
+    int *firstRun;              // First entry of every object in objectRuns, objects + 1 entries
+    int objectCapacity;
+    int *wrapRuns;              // Runs joined across a torus edge
+    int wrapCount;
+    int wrapCapacity;
+    KnownShape known[OBJECTS_MAX_KNOWN];
+    int knownCount;
+    ObjectsInfo info;
+};
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static const KnownPattern knownPatterns[] = {
+    { "block", "oo/oo", 1 },
+    { "beehive", ".oo./o..o/.oo.", 1 },
+    { "loaf", ".oo./o..o/.o.o/..o.", 1 },
+    { "boat", "oo./o.o/.o.", 1 },
+    { "ship", "oo./o.o/.oo", 1 },
+    { "tub", ".o./o.o/.o.", 1 },
+    { "pond", ".oo./o..o/o..o/.oo.", 1 },
+    { "long boat", "oo../o.o./.o.o/..o.", 1 },
+    { "barge", ".o../o.o./.o.o/..o.", 1 },
+    { "snake", "oo.o/o.oo", 1 },
+    { "carrier", "oo../o..o/..oo", 1 },
+    { "eater", "oo../o.o./..o./..oo", 1 },
+    { "blinker", "ooo", 2 },
+    { "toad", ".ooo/ooo.", 2 },
+    { "beacon", "oo../o.../...o/..oo", 2 },
+    { "pulsar", "..ooo...ooo../............./o....o.o....o/o....o.o....o/o....o.o....o/..ooo...ooo../"
+        "............./..ooo...ooo../o....o.o....o/o....o.o....o/o....o.o....o/............./..ooo...ooo..", 3 },
+    { "pentadecathlon", "..o....o../oo.oooo.oo/..o....o..", 15 },
+    { "glider", ".o./..o/ooo", 4 },
+    { "lwss", ".o..o/o..../o...o/oooo.", 4 },
+    { "mwss", "...o../.o...o/o...../o....o/ooooo.", 4 },
+    { "hwss", "...oo../.o....o/o....../o.....o/oooooo.", 4 },
+};
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static bool ReserveObjectRows(LifeObjects *objects, int rows);
+static bool ReserveObjectRuns(LifeObjects *objects, int64_t runs);
+static bool ReserveObjects(LifeObjects *objects, int count);
+static void CountRowRuns(void *data, int begin, int end);
+static void LabelRowRuns(void *data, int begin, int end);
+static void MeasureObjects(void *data, int begin, int end);
+static int FindRowRuns(LifeGrid grid, int row, ObjectRun *runs);
+static void JoinRows(LifeObjects *objects, int upper, int lower, bool wrapped);
+static void JoinWrappedColumns(LifeObjects *objects, int row, int other);
+static void MarkWrappedRun(LifeObjects *objects, int run);
+static void JoinRuns(int *parent, int a, int b);
+static int FindRoot(int *parent, int run);
+static uint64_t HashShape(const uint64_t *shape, int height, int width);
+static void LoadKnownShapes(LifeObjects *objects);
+static const char *FindKnownShape(const LifeObjects *objects, uint64_t hash);
+static int CompareKnownShapes(const void *a, const void *b);
+static inline int TrailingZeros(uint64_t bits);
+
+//----------------------------------------------------------------------------------
+// Object Functions Definition
+//----------------------------------------------------------------------------------
+
+// Empty labelling with the known shapes hashed, NULL on failure
+LifeObjects *LoadLifeObjects(ObjectAdjacency adjacency)
+{
+    LifeObjects *objects = calloc(1, sizeof(LifeObjects));
+    if (objects == NULL) return NULL;
+
+    objects->adjacency = adjacency;
+    LoadKnownShapes(objects);
+    return objects;
+}
+
+void UnloadLifeObjects(LifeObjects *objects)
+{
+    if (objects == NULL) return;
+
+    free(objects->rowRuns);
+    free(objects->seams);
+    free(objects->runs);
+    free(objects->parent);
+    free(objects->objectRuns);
+    free(objects->objects);
+    free(objects->firstRun);
+    free(objects->wrapRuns);
+    free(objects);
+}
+
+// Label the live cells of grid, returns the number of objects or -1 when out of memory
+int LabelLifeObjects(LifeObjects *objects, LifeGrid grid)
+{
+    double start = GetLifeSeconds();
+    objects->info = (ObjectsInfo){ 0 };
+    objects->wrapCount = 0;
+    if (grid.rows <= 0) return 0;
+    if (!ReserveObjectRows(objects, grid.rows)) return -1;
+
+    objects->grid = grid;
+    ParallelFor(grid.rows, CountRowRuns, objects);
+
+    int64_t runs = 0;
+    for (int row = 0; row < grid.rows; row++)
+    {
+        int count = objects->rowRuns[row];
+        objects->rowRuns[row] = (int)runs;
+        runs += count;
+    }
+    if (!ReserveObjectRuns(objects, runs)) return -1;
+    objects->rowRuns[grid.rows] = (int)runs;
+
+    memset(objects->seams, 0, grid.rows);
+    ParallelFor(grid.rows, LabelRowRuns, objects);
+
+    for (int row = 1; row < grid.rows; row++)
+    {
+        if (objects->seams[row]) JoinRows(objects, row - 1, row, false);
+    }
+    if (grid.topology == TOPOLOGY_TORUS)
+    {
+        if (grid.rows > 1) JoinRows(objects, grid.rows - 1, 0, true);
+        for (int row = 0; row < grid.rows; row++)
+        {
+            JoinWrappedColumns(objects, row, row);
+            if (objects->adjacency == ADJACENCY_MOORE) JoinWrappedColumns(objects, row, (row + 1)%grid.rows);
+            if (objects->adjacency == ADJACENCY_MOORE) JoinWrappedColumns(objects, (row + 1)%grid.rows, row);
+        }
+    }
+
+    // Links point to lower runs, so one pass in run order turns them into object numbers
+    int *parent = objects->parent;
+    int count = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        int link = parent[run];
+        parent[run] = (link == run)? count++ : parent[link];
+    }
+    if (!ReserveObjects(objects, count)) return -1;
+
+    // Runs of every object next to each other, objects in order of their first run
+    memset(objects->firstRun, 0, (count + 1)*sizeof(int));
+    for (int run = 0; run < runs; run++) objects->firstRun[parent[run] + 1]++;
+    for (int object = 0; object < count; object++) objects->firstRun[object + 1] += objects->firstRun[object];
+    for (int run = 0; run < runs; run++) objects->objectRuns[objects->firstRun[parent[run]]++] = run;
+    for (int object = count; object > 0; object--) objects->firstRun[object] = objects->firstRun[object - 1];
+    objects->firstRun[0] = 0;
+
+    memset(objects->objects, 0, count*sizeof(LifeObject));
+    for (int i = 0; i < objects->wrapCount; i++) objects->objects[parent[objects->wrapRuns[i]]].wraps = true;
+    ParallelFor(count, MeasureObjects, objects);
+
+    objects->info.objects = count;
+    objects->info.runs = runs;
+    objects->info.threads = GetParallelWorkers();
+    for (int object = 0; object < count; object++)
+    {
+        objects->info.cells += objects->objects[object].population;
+        objects->info.known += (objects->objects[object].name != NULL);
+    }
+    objects->info.seconds = GetLifeSeconds() - start;
+    objects->grid = (LifeGrid){ 0 };
+
+    return count;
+}
+
+// Copy up to count objects of the last labelling, top to bottom by their first cell
+int GetLifeObjects(const LifeObjects *objects, LifeObject *list, int count)
+{
+    if (count > objects->info.objects) count = objects->info.objects;
+    if (count <= 0) return 0;
+
+    memcpy(list, objects->objects, count*sizeof(LifeObject));
+    return count;
+}
+
+ObjectsInfo GetLifeObjectsInfo(const LifeObjects *objects)
+{
+    return objects->info;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+static bool ReserveObjectRows(LifeObjects *objects, int rows)
+{
+    if (rows + 1 <= objects->rowCapacity) return true;
+
+    int *rowRuns = realloc(objects->rowRuns, (rows + 1)*sizeof(int));
+    if (rowRuns != NULL) objects->rowRuns = rowRuns;
+    uint8_t *seams = realloc(objects->seams, rows + 1);
+    if (seams != NULL) objects->seams = seams;
+    if ((rowRuns == NULL) || (seams == NULL)) return false;
+
+    objects->rowCapacity = rows + 1;
+    return true;
+}
+
+static bool ReserveObjectRuns(LifeObjects *objects, int64_t runs)
+{
+    if (runs >= INT_MAX) return false;
+    if (runs <= objects->runCapacity) return true;
+
+    // Grow by half again so a growing board does not reallocate every generation
+    int64_t capacity = runs + runs/2;
+    if (capacity >= INT_MAX) capacity = INT_MAX - 1;
+
+    ObjectRun *list = realloc(objects->runs, capacity*sizeof(ObjectRun));
+    if (list != NULL) objects->runs = list;
+    int *parent = realloc(objects->parent, capacity*sizeof(int));
+    if (parent != NULL) objects->parent = parent;
+    int *objectRuns = realloc(objects->objectRuns, capacity*sizeof(int));
+    if (objectRuns != NULL) objects->objectRuns = objectRuns;
+    if ((list == NULL) || (parent == NULL) || (objectRuns == NULL)) return false;
+
+    objects->runCapacity = (int)capacity;
+    return true;
+}
+
+static bool ReserveObjects(LifeObjects *objects, int count)
+{
+    if (count + 1 <= objects->objectCapacity) return true;
+
+    int capacity = count + 1 + count/2;
+    LifeObject *list = realloc(objects->objects, capacity*sizeof(LifeObject));
+    if (list != NULL) objects->objects = list;
+    int *firstRun = realloc(objects->firstRun, capacity*sizeof(int));
+    if (firstRun != NULL) objects->firstRun = firstRun;
+    if ((list == NULL) || (firstRun == NULL)) return false;
+
+    objects->objectCapacity = capacity;
+    return true;
+}
+
+// Runs of every row in [begin, end), a run starts on each live cell with a dead cell left of it
+static void CountRowRuns(void *data, int begin, int end)
+{
+    LifeObjects *objects = (LifeObjects *)data;
+    LifeGrid grid = objects->grid;
+    int words = (grid.cols + 63)/64;
+    uint64_t lastMask = (grid.cols%64 == 0)? ~0ULL : ((1ULL << (grid.cols%64)) - 1);
+
+    for (int row = begin; row < end; row++)
+    {
+        const uint64_t *cells = LIFE_ROW(grid, grid.cells, row) + 1;
+        uint64_t carry = 0;
+        int count = 0;
+        for (int w = 0; w < words; w++)
+        {
+            uint64_t bits = (w == words - 1)? (cells[w] & lastMask) : cells[w];
+            count += CountLifeBits(bits & ~((bits << 1) | carry));
+            carry = bits >> 63;
+        }
+        objects->rowRuns[row] = count;
+    }
+}
+
+// Runs of the band, joined to the runs above them inside the band
+static void LabelRowRuns(void *data, int begin, int end)
+{
+    LifeObjects *objects = (LifeObjects *)data;
+    if (begin > 0) objects->seams[begin] = 1;
+
+    for (int row = begin; row < end; row++)
+    {
+        int first = objects->rowRuns[row];
+        int count = FindRowRuns(objects->grid, row, objects->runs + first);
+        for (int run = first; run < first + count; run++) objects->parent[run] = run;
+        if (row > begin) JoinRows(objects, row - 1, row, false);
+    }
+}
+
+// Box, population and shape of the objects in [begin, end)
+static void MeasureObjects(void *data, int begin, int end)
+{
+    LifeObjects *objects = (LifeObjects *)data;
+    uint64_t shape[OBJECTS_MAX_SHAPE];
+
+    for (int index = begin; index < end; index++)
+    {
+        LifeObject *object = &objects->objects[index];
+        int top = INT_MAX, left = INT_MAX, bottom = 0, right = 0;
+        for (int i = objects->firstRun[index]; i < objects->firstRun[index + 1]; i++)
+        {
+            const ObjectRun *run = &objects->runs[objects->objectRuns[i]];
+            if (run->row < top) top = run->row;
+            if (run->row + 1 > bottom) bottom = run->row + 1;
+            if (run->begin < left) left = run->begin;
+            if (run->end > right) right = run->end;
+            object->population += run->end - run->begin;
+        }
+        object->top = top;
+        object->left = left;
+        object->rows = bottom - top;
+        object->cols = right - left;
+
+        if (object->wraps || (object->rows > OBJECTS_MAX_SHAPE) || (object->cols > OBJECTS_MAX_SHAPE)) continue;
+
+        memset(shape, 0, object->rows*sizeof(uint64_t));
+        for (int i = objects->firstRun[index]; i < objects->firstRun[index + 1]; i++)
+        {
+            const ObjectRun *run = &objects->runs[objects->objectRuns[i]];
+            int length = run->end - run->begin;
+            uint64_t bits = (length == 64)? ~0ULL : ((1ULL << length) - 1);
+            shape[run->row - top] |= bits << (run->begin - left);
+        }
+        object->hash = HashShape(shape, object->rows, object->cols);
+        object->name = FindKnownShape(objects, object->hash);
+    }
+}
+
+// Runs of live cells of one row, left to right
+static int FindRowRuns(LifeGrid grid, int row, ObjectRun *runs)
+{
+    const uint64_t *cells = LIFE_ROW(grid, grid.cells, row) + 1;
+    int words = (grid.cols + 63)/64;
+    uint64_t lastMask = (grid.cols%64 == 0)? ~0ULL : ((1ULL << (grid.cols%64)) - 1);
+    int begins = 0, ends = 0;
+    uint64_t carry = 0;
+
+    // Run k starts at the k-th live cell with a dead left neighbour and ends at the k-th with a dead right one
+    for (int w = 0; w < words; w++)
+    {
+        uint64_t bits = (w == words - 1)? (cells[w] & lastMask) : cells[w];
+        uint64_t next = (w + 1 == words)? 0 : (w + 1 == words - 1)? (cells[w + 1] & lastMask) : cells[w + 1];
+        uint64_t starts = bits & ~((bits << 1) | carry);
+        uint64_t stops = bits & ~((bits >> 1) | (next << 63));
+        carry = bits >> 63;
+
+        for (; starts != 0; starts &= starts - 1)
+        {
+            runs[begins].row = row;
+            runs[begins++].begin = w*64 + TrailingZeros(starts);
+        }
+        for (; stops != 0; stops &= stops - 1) runs[ends++].end = w*64 + TrailingZeros(stops) + 1;
+    }
+
+    return begins;
+}
+
+// Join runs of upper touching runs of lower, both lists are sorted left to right
+static void JoinRows(LifeObjects *objects, int upper, int lower, bool wrapped)
+{
+    const ObjectRun *runs = objects->runs;
+    int a = objects->rowRuns[upper], aEnd = objects->rowRuns[upper + 1];
+    int b = objects->rowRuns[lower], bEnd = objects->rowRuns[lower + 1];
+    int reach = (objects->adjacency == ADJACENCY_MOORE)? 1 : 0;   // Diagonal neighbours touch one column past the run
+
+    while ((a < aEnd) && (b < bEnd))
+    {
+        if ((runs[b].begin < runs[a].end + reach) && (runs[a].begin < runs[b].end + reach))
+        {
+            if (wrapped) MarkWrappedRun(objects, a);
+            JoinRuns(objects->parent, a, b);
+        }
+
+        if (runs[a].end < runs[b].end) a++;
+        else b++;
+    }
+}
+
+// Join a run reaching the right edge of row to a run starting at the left edge of other
+static void JoinWrappedColumns(LifeObjects *objects, int row, int other)
+{
+    int cols = objects->grid.cols;
+    int last = objects->rowRuns[row + 1] - 1;
+    int first = objects->rowRuns[other];
+    if ((last < objects->rowRuns[row]) || (first == objects->rowRuns[other + 1])) return;
+    if ((objects->runs[last].end != cols) || (objects->runs[first].begin != 0)) return;
+
+    MarkWrappedRun(objects, last);
+    JoinRuns(objects->parent, last, first);
+}
+
+// Only called from the serial joins after labelling, a failed allocation forgets the mark
+static void MarkWrappedRun(LifeObjects *objects, int run)
+{
+    if (objects->wrapCount == objects->wrapCapacity)
+    {
+        int capacity = (objects->wrapCapacity > 0)? 2*objects->wrapCapacity : 64;
+        int *wrapRuns = realloc(objects->wrapRuns, capacity*sizeof(int));
+        if (wrapRuns == NULL) return;
+
+        objects->wrapRuns = wrapRuns;
+        objects->wrapCapacity = capacity;
+    }
+    objects->wrapRuns[objects->wrapCount++] = run;
+}
+
+// Link the higher root under the lower one, so every link points to a lower run
+static void JoinRuns(int *parent, int a, int b)
+{
+    a = FindRoot(parent, a);
+    b = FindRoot(parent, b);
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+static int FindRoot(int *parent, int run)
+{
+    // Path halving keeps later finds short
+    while (parent[run] != run)
+    {
+        parent[run] = parent[parent[run]];
+        run = parent[run];
+    }
+    return run;
+}
+
+// Lowest FNV-1a hash of the shape over its 8 rotations and reflections, shape rows hold bit c for column c
+static uint64_t HashShape(const uint64_t *shape, int height, int width)
+{
+    uint64_t transformed[OBJECTS_MAX_SHAPE];
+    uint64_t best = UINT64_MAX;
+
+    for (int symmetry = 0; symmetry < 8; symmetry++)
+    {
+        bool transpose = (symmetry & 4) != 0;
+        int outHeight = transpose? width : height;
+        int outWidth = transpose? height : width;
+        memset(transformed, 0, outHeight*sizeof(uint64_t));
+        for (int r = 0; r < height; r++)
+        {
+            for (uint64_t bits = shape[r]; bits != 0; bits &= bits - 1)
+            {
+                int c = TrailingZeros(bits);
+                int sr = (symmetry & 1)? height - 1 - r : r;
+                int sc = (symmetry & 2)? width - 1 - c : c;
+                if (transpose) transformed[sc] |= 1ULL << sr;
+                else transformed[sr] |= 1ULL << sc;
+            }
+        }
+
+        uint64_t hash = 14695981039346656037ULL;
+        hash = (hash ^ (uint64_t)outHeight)*1099511628211ULL;
+        hash = (hash ^ (uint64_t)outWidth)*1099511628211ULL;
+        for (int r = 0; r < outHeight; r++) hash = (hash ^ transformed[r])*1099511628211ULL;
+        if (hash < best) best = hash;
+    }
+
+    // 0 stands for shapes that were not hashed
+    return (best == 0)? 1 : best;
+}
+
+// Hash every phase of the known patterns, stepped on a dead edge grid and labelled like the board
+static void LoadKnownShapes(LifeObjects *objects)
+{
+    // Phases that come apart into several objects would never match one, they are left out
+    LifeObjects *labeller = calloc(1, sizeof(LifeObjects));
+    if (labeller == NULL) return;
+    labeller->adjacency = objects->adjacency;
+
+    int patterns = (int)(sizeof(knownPatterns)/sizeof(knownPatterns[0]));
+    for (int p = 0; p < patterns; p++)
+    {
+        const KnownPattern *pattern = &knownPatterns[p];
+        int height = 1, width = 0, col = 0;
+        for (const char *c = pattern->cells; *c != '\0'; c++)
+        {
+            if (*c == '/') { height++; col = 0; }
+            else if (++col > width) width = col;
+        }
+
+        LifeGrid grid = LoadLifeGrid(height + 2*OBJECTS_KNOWN_MARGIN, width + 2*OBJECTS_KNOWN_MARGIN, TOPOLOGY_DEAD_EDGE);
+        if (grid.cells == NULL) continue;
+
+        int row = 0;
+        col = 0;
+        for (const char *c = pattern->cells; *c != '\0'; c++)
+        {
+            if (*c == '/') { row++; col = 0; continue; }
+            if (*c == 'o') SetLifeCell(&grid, OBJECTS_KNOWN_MARGIN + row, OBJECTS_KNOWN_MARGIN + col, true);
+            col++;
+        }
+
+        for (int phase = 0; phase < pattern->period; phase++)
+        {
+            if (LabelLifeObjects(labeller, grid) == 1)
+            {
+                uint64_t hash = labeller->objects[0].hash;
+                bool seen = false;
+                for (int i = 0; i < objects->knownCount; i++) seen |= (objects->known[i].hash == hash);
+                if (!seen && (objects->knownCount < OBJECTS_MAX_KNOWN)) objects->known[objects->knownCount++] = (KnownShape){ hash, pattern->name };
+            }
+
+            StepLifeGrid(&grid);
+        }
+        UnloadLifeGrid(grid);
+    }
+    UnloadLifeObjects(labeller);
+
+    qsort(objects->known, objects->knownCount, sizeof(KnownShape), CompareKnownShapes);
+}
+
+static const char *FindKnownShape(const LifeObjects *objects, uint64_t hash)
+{
+    KnownShape key = { hash, NULL };
+    const KnownShape *found = bsearch(&key, objects->known, objects->knownCount, sizeof(KnownShape), CompareKnownShapes);
+    return (found != NULL)? found->name : NULL;
+}
+
+static int CompareKnownShapes(const void *a, const void *b)
+{
+    uint64_t hashA = ((const KnownShape *)a)->hash;
+    uint64_t hashB = ((const KnownShape *)b)->hash;
+    return (hashA > hashB) - (hashA < hashB);
+}
+
+// Index of the lowest set bit, bits must not be 0
+static inline int TrailingZeros(uint64_t bits)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    return CountLifeBits((bits & (~bits + 1)) - 1);
+#endif
+}
+
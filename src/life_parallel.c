@@ -0,0 +1,198 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Parallel for
+*
+*   Small persistent worker pool used by the engines to split row ranges across cores.
+*   Workers are started on first use and sleep on a condition variable between jobs.
+*
+*   NOTE: ParallelFor() is serialized between callers and must not be called from inside a job.
+*   A forked child starts without workers, the pool restarts in the child on first use.
+*
+**********************************************************************************************/
+
+#include "life.h"
+#include "life_thread.h"
+
+//----------------------------------------------------------------------------------
+// Module Variables Definition (local)
+//----------------------------------------------------------------------------------
+static pthread_t workers[PARALLEL_MAX_WORKERS];
+static int workerCount = -1;          // Threads besides the caller, -1 until started
+static int requestedWorkers = 0;      // 0 picks one thread per online core
+
+static pthread_mutex_t dispatchLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t jobLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobReady = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t jobDone = PTHREAD_COND_INITIALIZER;
+
+static ParallelJob currentJob = NULL;
+static void *currentData = NULL;
+static int currentCount = 0;
+static int jobSerial = 0;
+static int startSerial = 0;           // jobSerial when the workers were created
+static int jobsPending = 0;
+static bool shuttingDown = false;
+static pthread_once_t forkHandlerOnce = PTHREAD_ONCE_INIT;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static void *WorkerMain(void *arg);
+static void RunChunk(ParallelJob job, void *data, int count, int chunk, int chunks);
+static void StartWorkers(void);
+static void RegisterForkHandler(void);
+static void ResetAfterFork(void);
+
+//----------------------------------------------------------------------------------
+// Parallel Functions Definition
+//----------------------------------------------------------------------------------
+
+// Threads used by ParallelFor(), caller included
+int GetParallelWorkers(void)
+{
+    pthread_mutex_lock(&dispatchLock);
+    if (workerCount < 0) StartWorkers();
+    int count = workerCount + 1;
+    pthread_mutex_unlock(&dispatchLock);
+    return count;
+}
+
+// Takes effect the next time the pool starts, 0 uses every online core
+void SetParallelWorkers(int count)
+{
+    requestedWorkers = count;
+}
+
+// Split [0, count) into contiguous chunks, one per thread, and wait for all of them
+// NOTE: Chunk boundaries only depend on count and thread count, never on timing
+void ParallelFor(int count, ParallelJob job, void *data)
+{
+    if (count <= 0) return;
+
+    pthread_mutex_lock(&dispatchLock);
+    if (workerCount < 0) StartWorkers();
+
+    int chunks = workerCount + 1;
+    if ((workerCount == 0) || (count == 1))
+    {
+        job(data, 0, count);
+        pthread_mutex_unlock(&dispatchLock);
+        return;
+    }
+
+    pthread_mutex_lock(&jobLock);
+    currentJob = job;
+    currentData = data;
+    currentCount = count;
+    jobsPending = workerCount;
+    jobSerial++;
+    pthread_cond_broadcast(&jobReady);
+    pthread_mutex_unlock(&jobLock);
+
+    RunChunk(job, data, count, 0, chunks);
+
+    pthread_mutex_lock(&jobLock);
+    while (jobsPending > 0) pthread_cond_wait(&jobDone, &jobLock);
+    pthread_mutex_unlock(&jobLock);
+
+    pthread_mutex_unlock(&dispatchLock);
+}
+
+// Join the worker threads, the pool restarts on next use
+void CloseParallelWorkers(void)
+{
+    pthread_mutex_lock(&dispatchLock);
+    if (workerCount > 0)
+    {
+        pthread_mutex_lock(&jobLock);
+        shuttingDown = true;
+        pthread_cond_broadcast(&jobReady);
+        pthread_mutex_unlock(&jobLock);
+
+        for (int i = 0; i < workerCount; i++) pthread_join(workers[i], NULL);
+        shuttingDown = false;
+    }
+    workerCount = -1;
+    pthread_mutex_unlock(&dispatchLock);
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+static void *WorkerMain(void *arg)
+{
+    int index = (int)(intptr_t)arg;
+    int seenSerial = startSerial;
+
+    pthread_mutex_lock(&jobLock);
+    for (;;)
+    {
+        while (!shuttingDown && (jobSerial == seenSerial)) pthread_cond_wait(&jobReady, &jobLock);
+        if (shuttingDown) break;
+
+        seenSerial = jobSerial;
+        ParallelJob job = currentJob;
+        void *data = currentData;
+        int count = currentCount;
+        int chunks = workerCount + 1;
+        pthread_mutex_unlock(&jobLock);
+
+        RunChunk(job, data, count, index + 1, chunks);
+
+        pthread_mutex_lock(&jobLock);
+        if (--jobsPending == 0) pthread_cond_signal(&jobDone);
+    }
+    pthread_mutex_unlock(&jobLock);
+
+    return NULL;
+}
+
+static void RunChunk(ParallelJob job, void *data, int count, int chunk, int chunks)
+{
+    int begin = (int)((int64_t)count*chunk/chunks);
+    int end = (int)((int64_t)count*(chunk + 1)/chunks);
+    if (begin < end) job(data, begin, end);
+}
+
+// NOTE: Called with dispatchLock held
+static void StartWorkers(void)
+{
+    int threads = requestedWorkers;
+    if (threads <= 0)
+    {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cores > 0)? (int)cores : 1;
+    }
+    if (threads > PARALLEL_MAX_WORKERS + 1) threads = PARALLEL_MAX_WORKERS + 1;
+    pthread_once(&forkHandlerOnce, RegisterForkHandler);
+
+    workerCount = 0;
+    startSerial = jobSerial;
+    for (int i = 0; i < threads - 1; i++)
+    {
+        if (pthread_create(&workers[i], NULL, WorkerMain, (void *)(intptr_t)i) != 0) break;
+        workerCount++;
+    }
+}
+
+// Windows has no fork(), there is nothing to reset
+static void RegisterForkHandler(void)
+{
+#if !defined(_WIN32)
+    pthread_atfork(NULL, NULL, ResetAfterFork);
+#endif
+}
+
+// Only the forking thread survives in the child, forget the workers and any lock they held
+static void ResetAfterFork(void)
+{
+    pthread_mutex_init(&dispatchLock, NULL);
+    pthread_mutex_init(&jobLock, NULL);
+    pthread_cond_init(&jobReady, NULL);
+    pthread_cond_init(&jobDone, NULL);
+
+    workerCount = -1;
+    jobsPending = 0;
+    currentJob = NULL;
+    shuttingDown = false;
+}
@@ -0,0 +1,249 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Population pyramid
+*
+*   Live cell counts per 2x2, 4x4, 8x8, ... block, used to shade zoomed out views by density.
+*   Counts from 8x8 blocks up are stored, smaller blocks are counted straight from the cells.
+*
+*   Updates read the changed words the grid tracks, and only 64x64 tiles holding a changed
+*   word are recounted from the cells, together with their ancestors. Grids that do not track
+*   changes are recounted whole.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <stdlib.h>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct PyramidJob {
+    LifePyramid *pyramid;
+    LifeGrid grid;
+} PyramidJob;
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static inline int LevelWidth(const LifePyramid *pyramid, int level);
+static inline int LevelHeight(const LifePyramid *pyramid, int level);
+static uint32_t SumChildren(const LifePyramid *pyramid, int level, int blockRow, int blockCol);
+static void CountTile(LifePyramid *pyramid, LifeGrid grid, int tileRow, int tileCol);
+static void UpdatePyramidTiles(void *data, int begin, int end);
+
+//----------------------------------------------------------------------------------
+// Population Pyramid Functions Definition
+//----------------------------------------------------------------------------------
+
+// Allocate an empty pyramid for the grid size, counts are NULL on failure
+LifePyramid LoadLifePyramid(LifeGrid grid)
+{
+    LifePyramid pyramid = { 0 };
+    pyramid.rows = grid.rows;
+    pyramid.cols = grid.cols;
+
+    // Enough levels for the last one to be a single block, and at least up to the tiles
+    pyramid.levels = PYRAMID_TILE_LEVEL;
+    while ((LevelWidth(&pyramid, pyramid.levels) > 1) || (LevelHeight(&pyramid, pyramid.levels) > 1)) pyramid.levels++;
+    pyramid.levels++;
+
+    bool loaded = true;
+    for (int k = PYRAMID_FIRST_LEVEL; k < pyramid.levels; k++)
+    {
+        size_t blocks = (size_t)LevelWidth(&pyramid, k)*LevelHeight(&pyramid, k);
+        pyramid.counts[k] = calloc(blocks, sizeof(uint32_t));
+        if (pyramid.counts[k] == NULL) loaded = false;
+        if (k >= PYRAMID_TILE_LEVEL)
+        {
+            pyramid.dirty[k] = calloc(blocks, sizeof(uint8_t));
+            if (pyramid.dirty[k] == NULL) loaded = false;
+        }
+    }
+    if (!loaded)
+    {
+        UnloadLifePyramid(pyramid);
+        return (LifePyramid){ 0 };
+    }
+
+    return pyramid;
+}
+
+void UnloadLifePyramid(LifePyramid pyramid)
+{
+    for (int k = 0; k < PYRAMID_MAX_LEVELS; k++)
+    {
+        free(pyramid.counts[k]);
+        free(pyramid.dirty[k]);
+    }
+}
+
+// Recount the tiles holding words marked in grid.changes, returns the number of changed tiles
+// NOTE: The first update counts every tile, the owner of the grid clears its changes after every update
+int UpdateLifePyramid(LifePyramid *pyramid, LifeGrid grid)
+{
+    PyramidJob job = { pyramid, grid };
+    ParallelFor(LevelHeight(pyramid, PYRAMID_TILE_LEVEL), UpdatePyramidTiles, &job);
+    pyramid->counted = true;
+
+    int changed = 0;
+    size_t tiles = (size_t)LevelWidth(pyramid, PYRAMID_TILE_LEVEL)*LevelHeight(pyramid, PYRAMID_TILE_LEVEL);
+    for (size_t i = 0; i < tiles; i++) changed += pyramid->dirty[PYRAMID_TILE_LEVEL][i];
+
+    // Blocks above the tiles are recounted from their four children when one of them changed
+    for (int k = PYRAMID_TILE_LEVEL + 1; k < pyramid->levels; k++)
+    {
+        int width = LevelWidth(pyramid, k);
+        int height = LevelHeight(pyramid, k);
+        int childWidth = LevelWidth(pyramid, k - 1);
+        int childHeight = LevelHeight(pyramid, k - 1);
+        const uint8_t *childDirty = pyramid->dirty[k - 1];
+
+        for (int row = 0; row < height; row++)
+        {
+            for (int col = 0; col < width; col++)
+            {
+                bool dirty = false;
+                for (int r = 2*row; (r < 2*row + 2) && (r < childHeight); r++)
+                {
+                    for (int c = 2*col; (c < 2*col + 2) && (c < childWidth); c++) dirty |= childDirty[(size_t)r*childWidth + c];
+                }
+                pyramid->dirty[k][(size_t)row*width + col] = dirty;
+                if (dirty) pyramid->counts[k][(size_t)row*width + col] = SumChildren(pyramid, k, row, col);
+            }
+        }
+    }
+
+    return changed;
+}
+
+// Live cells in block (blockRow, blockCol) of size 2^level, as of the last update
+// NOTE: Blocks smaller than 8x8 are counted from the cells of grid, the grid the pyramid was last updated with
+int GetPyramidPopulation(LifePyramid pyramid, LifeGrid grid, int level, int blockRow, int blockCol)
+{
+    if (level >= PYRAMID_FIRST_LEVEL) return (int)pyramid.counts[level][(size_t)blockRow*LevelWidth(&pyramid, level) + blockCol];
+
+    // Blocks up to 4x4 sit inside one word of each row, the right ghost cell may share it
+    int side = 1 << level;
+    int col = blockCol*side;
+    int end = (col + side < grid.cols)? col + side : grid.cols;
+    uint64_t mask = ((1ULL << (end - col)) - 1) << (col%64);
+    int population = 0;
+    for (int row = blockRow*side; (row < (blockRow + 1)*side) && (row < grid.rows); row++)
+    {
+        population += CountLifeBits(LIFE_ROW(grid, grid.cells, row)[1 + col/64] & mask);
+    }
+    return population;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+static inline int LevelWidth(const LifePyramid *pyramid, int level)
+{
+    return (int)(((int64_t)pyramid->cols + (1LL << level) - 1) >> level);
+}
+
+static inline int LevelHeight(const LifePyramid *pyramid, int level)
+{
+    return (int)(((int64_t)pyramid->rows + (1LL << level) - 1) >> level);
+}
+
+// Sum of the up to four blocks one level down covered by a block
+static uint32_t SumChildren(const LifePyramid *pyramid, int level, int blockRow, int blockCol)
+{
+    int childWidth = LevelWidth(pyramid, level - 1);
+    int childHeight = LevelHeight(pyramid, level - 1);
+    const uint32_t *child = pyramid->counts[level - 1];
+    uint32_t sum = 0;
+
+    for (int r = 2*blockRow; (r < 2*blockRow + 2) && (r < childHeight); r++)
+    {
+        for (int c = 2*blockCol; (c < 2*blockCol + 2) && (c < childWidth); c++) sum += child[(size_t)r*childWidth + c];
+    }
+    return sum;
+}
+
+// Recount every level inside one 64x64 tile from the cells of grid
+static void CountTile(LifePyramid *pyramid, LifeGrid grid, int tileRow, int tileCol)
+{
+    int tileCols = LevelWidth(pyramid, PYRAMID_TILE_LEVEL);
+    uint64_t mask = ((tileCol == tileCols - 1) && (pyramid->cols%64 != 0))? (1ULL << (pyramid->cols%64)) - 1 : ~0ULL;
+    int width = LevelWidth(pyramid, PYRAMID_FIRST_LEVEL);
+    int height = LevelHeight(pyramid, PYRAMID_FIRST_LEVEL);
+    int blocks = 1 << (PYRAMID_TILE_LEVEL - PYRAMID_FIRST_LEVEL);
+
+    // 8x8 blocks are one byte of eight consecutive row words
+    for (int i = 0; i < blocks; i++)
+    {
+        int blockRow = tileRow*blocks + i;
+        if (blockRow >= height) break;
+
+        int firstRow = blockRow*8;
+        int lastRow = (firstRow + 8 < pyramid->rows)? firstRow + 8 : pyramid->rows;
+        for (int j = 0; j < blocks; j++)
+        {
+            int blockCol = tileCol*blocks + j;
+            if (blockCol >= width) break;
+
+            uint32_t population = 0;
+            for (int row = firstRow; row < lastRow; row++)
+            {
+                population += CountLifeBits(((LIFE_ROW(grid, grid.cells, row)[1 + tileCol] & mask) >> (8*j)) & 0xFF);
+            }
+            pyramid->counts[PYRAMID_FIRST_LEVEL][(size_t)blockRow*width + blockCol] = population;
+        }
+    }
+
+    for (int k = PYRAMID_FIRST_LEVEL + 1; k <= PYRAMID_TILE_LEVEL; k++)
+    {
+        width = LevelWidth(pyramid, k);
+        height = LevelHeight(pyramid, k);
+        blocks = 1 << (PYRAMID_TILE_LEVEL - k);
+        for (int i = 0; (i < blocks) && (tileRow*blocks + i < height); i++)
+        {
+            for (int j = 0; (j < blocks) && (tileCol*blocks + j < width); j++)
+            {
+                int blockRow = tileRow*blocks + i;
+                int blockCol = tileCol*blocks + j;
+                pyramid->counts[k][(size_t)blockRow*width + blockCol] = SumChildren(pyramid, k, blockRow, blockCol);
+            }
+        }
+    }
+}
+
+// Find and recount changed tiles in the tile rows [begin, end)
+static void UpdatePyramidTiles(void *data, int begin, int end)
+{
+    PyramidJob *job = (PyramidJob *)data;
+    LifePyramid *pyramid = job->pyramid;
+    LifeGrid grid = job->grid;
+    int tileCols = LevelWidth(pyramid, PYRAMID_TILE_LEVEL);
+    int changeStride = LIFE_CHANGE_STRIDE(grid);
+    bool recountAll = !pyramid->counted || (grid.changes == NULL);
+
+    for (int tileRow = begin; tileRow < end; tileRow++)
+    {
+        int firstRow = tileRow*64;
+        int lastRow = (firstRow + 64 < pyramid->rows)? firstRow + 64 : pyramid->rows;
+
+        // Tiles are one word wide, so a tile changed when its bit is set in any of its rows
+        for (int k = 0; k < changeStride; k++)
+        {
+            uint64_t changed = 0;
+            if (recountAll) changed = ~0ULL;
+            else
+            {
+                for (int row = firstRow; row < lastRow; row++) changed |= grid.changes[(size_t)row*changeStride + k];
+            }
+
+            for (int j = 0; (j < 64) && (64*k + j < tileCols); j++)
+            {
+                int tileCol = 64*k + j;
+                bool dirty = (changed >> j) & 1;
+                pyramid->dirty[PYRAMID_TILE_LEVEL][(size_t)tileRow*tileCols + tileCol] = dirty;
+                if (dirty) CountTile(pyramid, grid, tileRow, tileCol);
+            }
+        }
+    }
+}
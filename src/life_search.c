@@ -0,0 +1,452 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Pattern search
+*
+*   Finds every place a pattern sits on the board, in any of its phases and any of the
+*   8 rotations and reflections.
+*
+*   The pattern is stepped through its phases once and every phase is turned and flipped,
+*   keeping the distinct shapes as variants. Each variant is a list of cell checks, live
+*   cells first since most of a board is dead. The board is then scanned 64 candidate
+*   positions at a time: for one check, the 64 board cells it lands on for each candidate
+*   are read as one word, XORed with the expected state and cleared from the candidates
+*   with an AND, so a check costs a few word operations and a block is dropped as soon as
+*   no candidate is left. Candidates without any live cell in the box right of and below
+*   them are dropped for every variant at once. Row bands are searched on every
+*   ParallelFor() thread.
+*
+*   An isolated search also checks the ring of cells around the pattern is dead, so only
+*   free standing copies match and not parts of larger objects.
+*
+*   NOTE: Matches lie inside the board, cells off the board count as dead whatever the
+*   topology.
+*
+**********************************************************************************************/
+
+#include "life.h"
+#include "life_thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct SearchCheck {
+    int row;                // Relative to the top left cell of the pattern, -1 on the ring
+    int col;
+    uint64_t flip;          // 0 for live cells, all ones for dead ones
+} SearchCheck;
+
+typedef struct SearchVariant {
+    int rows;
+    int cols;
+    int symmetry;
+    int phase;
+    uint64_t shape[SEARCH_MAX_PATTERN];     // Row r holds bit c for live column c
+    SearchCheck *checks;
+    int checkCount;
+} SearchVariant;
+
+struct LifeSearch {
+    bool isolated;
+    SearchVariant *variants;
+    int variantCount;
+    int minRows;            // Smallest variant, candidates closer to the edge are not scanned
+    int minCols;
+    int maxRows;            // Largest variant, rows and columns kept shifted while scanning
+    int maxCols;
+    LifeGrid grid;          // Grid being searched, only valid during RunLifeSearch()
+    pthread_mutex_t lock;   // Guards matches while bands add theirs
+    SearchMatch *matches;
+    int matchCount;
+    int matchCapacity;
+    bool failed;            // A band could not store its matches
+    SearchInfo info;
+};
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static bool AddSearchVariants(LifeSearch *search, const uint64_t *shape, int rows, int cols, int phase);
+static bool LoadSearchChecks(SearchVariant *variant, bool isolated);
+static void SearchRows(void *data, int begin, int end);
+static void LoadSearchRow(const LifeSearch *search, uint64_t *slot, int blocks, int y);
+static bool AddSearchMatches(LifeSearch *search, const SearchMatch *matches, int count);
+static uint64_t GetRowBits(LifeGrid grid, int row, int col);
+static int CompareMatches(const void *a, const void *b);
+static inline int TrailingZeros(uint64_t bits);
+
+//----------------------------------------------------------------------------------
+// Search Functions Definition
+//----------------------------------------------------------------------------------
+
+// Every distinct orientation of the first phases of the live cells of pattern
+// NOTE: Returns NULL when out of memory, when the pattern is empty or a phase outgrows SEARCH_MAX_PATTERN
+LifeSearch *LoadLifeSearch(LifeGrid pattern, int phases, bool isolated)
+{
+    if (phases < 1) phases = 1;
+
+    LifeSearch *search = calloc(1, sizeof(LifeSearch));
+    if (search == NULL) return NULL;
+    search->isolated = isolated;
+    search->variants = calloc(8*phases, sizeof(SearchVariant));
+    pthread_mutex_init(&search->lock, NULL);
+
+    // Phases are stepped with room to grow by one cell per generation on every side
+    int margin = phases + 1;
+    LifeGrid grid = LoadLifeGrid(pattern.rows + 2*margin, pattern.cols + 2*margin, TOPOLOGY_DEAD_EDGE);
+    bool loaded = (search->variants != NULL) && (grid.cells != NULL);
+    for (int row = 0; loaded && (row < pattern.rows); row++)
+    {
+        for (int col = 0; col < pattern.cols; col++) SetLifeCell(&grid, margin + row, margin + col, GetLifeCell(pattern, row, col));
+    }
+
+    for (int phase = 0; loaded && (phase < phases); phase++)
+    {
+        int top = grid.rows, left = grid.cols, bottom = 0, right = 0;
+        for (int row = 0; row < grid.rows; row++)
+        {
+            for (int col = 0; col < grid.cols; col++)
+            {
+                if (!GetLifeCell(grid, row, col)) continue;
+                if (row < top) top = row;
+                if (row >= bottom) bottom = row + 1;
+                if (col < left) left = col;
+                if (col >= right) right = col + 1;
+            }
+        }
+        if ((bottom == 0) || (bottom - top > SEARCH_MAX_PATTERN) || (right - left > SEARCH_MAX_PATTERN))
+        {
+            loaded = false;
+            break;
+        }
+
+        uint64_t shape[SEARCH_MAX_PATTERN] = { 0 };
+        for (int row = top; row < bottom; row++)
+        {
+            for (int col = left; col < right; col++) shape[row - top] |= (uint64_t)GetLifeCell(grid, row, col) << (col - left);
+        }
+        loaded = AddSearchVariants(search, shape, bottom - top, right - left, phase);
+        StepLifeGrid(&grid);
+    }
+    UnloadLifeGrid(grid);
+
+    if (!loaded)
+    {
+        UnloadLifeSearch(search);
+        return NULL;
+    }
+
+    search->minRows = search->minCols = SEARCH_MAX_PATTERN;
+    for (int i = 0; i < search->variantCount; i++)
+    {
+        const SearchVariant *variant = &search->variants[i];
+        if (variant->rows < search->minRows) search->minRows = variant->rows;
+        if (variant->cols < search->minCols) search->minCols = variant->cols;
+        if (variant->rows > search->maxRows) search->maxRows = variant->rows;
+        if (variant->cols > search->maxCols) search->maxCols = variant->cols;
+    }
+    search->info.variants = search->variantCount;
+
+    return search;
+}
+
+void UnloadLifeSearch(LifeSearch *search)
+{
+    if (search == NULL) return;
+
+    for (int i = 0; (search->variants != NULL) && (i < search->variantCount); i++) free(search->variants[i].checks);
+    free(search->variants);
+    free(search->matches);
+    pthread_mutex_destroy(&search->lock);
+    free(search);
+}
+
+// Search the whole grid, returns the number of matches or -1 when out of memory
+int RunLifeSearch(LifeSearch *search, LifeGrid grid)
+{
+    double start = GetLifeSeconds();
+    search->matchCount = 0;
+    search->failed = false;
+    search->grid = grid;
+
+    int candidateRows = grid.rows - search->minRows + 1;
+    if ((candidateRows > 0) && (grid.cols >= search->minCols)) ParallelFor(candidateRows, SearchRows, search);
+    search->grid = (LifeGrid){ 0 };
+
+    // Bands finish in any order, sorting keeps results the same for any thread count
+    if (search->matchCount > 1) qsort(search->matches, search->matchCount, sizeof(SearchMatch), CompareMatches);
+
+    search->info.matches = search->matchCount;
+    search->info.threads = GetParallelWorkers();
+    search->info.seconds = GetLifeSeconds() - start;
+
+    return search->failed? -1 : search->matchCount;
+}
+
+// Copy up to count matches of the last search, top to bottom then left to right
+int GetLifeSearchMatches(const LifeSearch *search, SearchMatch *matches, int count)
+{
+    if (count > search->matchCount) count = search->matchCount;
+    if (count <= 0) return 0;
+
+    memcpy(matches, search->matches, count*sizeof(SearchMatch));
+    return count;
+}
+
+SearchInfo GetLifeSearchInfo(const LifeSearch *search)
+{
+    return search->info;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Add the 8 orientations of one phase that are not variants yet
+static bool AddSearchVariants(LifeSearch *search, const uint64_t *shape, int rows, int cols, int phase)
+{
+    for (int symmetry = 0; symmetry < 8; symmetry++)
+    {
+        bool transpose = (symmetry & 4) != 0;
+        SearchVariant *variant = &search->variants[search->variantCount];
+        *variant = (SearchVariant){ 0 };
+        variant->rows = transpose? cols : rows;
+        variant->cols = transpose? rows : cols;
+        variant->symmetry = symmetry;
+        variant->phase = phase;
+        for (int r = 0; r < rows; r++)
+        {
+            for (uint64_t bits = shape[r]; bits != 0; bits &= bits - 1)
+            {
+                int c = TrailingZeros(bits);
+                int sr = (symmetry & 1)? rows - 1 - r : r;
+                int sc = (symmetry & 2)? cols - 1 - c : c;
+                if (transpose) variant->shape[sc] |= 1ULL << sr;
+                else variant->shape[sr] |= 1ULL << sc;
+            }
+        }
+
+        bool seen = false;
+        for (int i = 0; !seen && (i < search->variantCount); i++)
+        {
+            const SearchVariant *other = &search->variants[i];
+            seen = (other->rows == variant->rows) && (other->cols == variant->cols) &&
+                (memcmp(other->shape, variant->shape, variant->rows*sizeof(uint64_t)) == 0);
+        }
+        if (seen) continue;
+
+        if (!LoadSearchChecks(variant, search->isolated)) return false;
+        search->variantCount++;
+    }
+
+    return true;
+}
+
+// Live cells, then dead cells of the box, then the dead ring around it when isolated
+static bool LoadSearchChecks(SearchVariant *variant, bool isolated)
+{
+    int ring = isolated? 1 : 0;
+    variant->checks = malloc((size_t)(variant->rows + 2*ring)*(variant->cols + 2*ring)*sizeof(SearchCheck));
+    if (variant->checks == NULL) return false;
+
+    for (int pass = 0; pass < 3; pass++)
+    {
+        for (int row = -ring; row < variant->rows + ring; row++)
+        {
+            for (int col = -ring; col < variant->cols + ring; col++)
+            {
+                bool inside = (row >= 0) && (col >= 0) && (row < variant->rows) && (col < variant->cols);
+                bool alive = inside && ((variant->shape[row] >> col) & 1);
+                int kind = alive? 0 : inside? 1 : 2;
+                if (kind != pass) continue;
+
+                variant->checks[variant->checkCount++] = (SearchCheck){ row, col, alive? 0 : ~0ULL };
+            }
+        }
+    }
+
+    return true;
+}
+
+// Candidates with their top row in [begin, end), 64 columns per block
+// NOTE: Rows under the candidates are kept shifted by every check column in a window of slots, filled
+// once per row as it enters, so a check is one load whatever the variant
+static void SearchRows(void *data, int begin, int end)
+{
+    LifeSearch *search = (LifeSearch *)data;
+    LifeGrid grid = search->grid;
+    int ring = search->isolated? 1 : 0;
+    int blocks = (grid.cols - search->minCols)/64 + 1;
+    int shifts = search->maxCols + 2*ring;
+    int slots = search->maxRows + 2*ring;
+    size_t slotWords = (size_t)(shifts + 1)*blocks;
+    int maxChecks = slots*shifts;
+
+    // One block for the window, the occupied columns and the words of every check of a variant
+    uint64_t *window = malloc((slots*slotWords + blocks)*sizeof(uint64_t) + maxChecks*sizeof(uint64_t *));
+    if (window == NULL)
+    {
+        AddSearchMatches(search, NULL, -1);
+        return;
+    }
+
+    uint64_t *occupied = window + slots*slotWords;
+    const uint64_t **checkWords = (const uint64_t **)(occupied + blocks);
+    SearchMatch found[256];
+    int foundCount = 0;
+    const uint64_t *rowWords[SEARCH_MAX_PATTERN + 2];
+    for (int y = begin - ring; y < begin + search->maxRows + ring - 1; y++) LoadSearchRow(search, window + (size_t)((y + slots)%slots)*slotWords, blocks, y);
+
+    for (int row = begin; row < end; row++)
+    {
+        int last = row + search->maxRows + ring - 1;
+        LoadSearchRow(search, window + (size_t)(last%slots)*slotWords, blocks, last);
+        for (int r = 0; r < slots; r++) rowWords[r] = window + (size_t)((row - ring + r + slots)%slots)*slotWords;
+
+        // Candidates need a live cell in the columns and rows right of and below them
+        for (int block = 0; block < blocks; block++)
+        {
+            occupied[block] = 0;
+            for (int r = 0; r < search->maxRows; r++) occupied[block] |= rowWords[ring + r][(size_t)shifts*blocks + block];
+        }
+
+        for (int v = 0; v < search->variantCount; v++)
+        {
+            const SearchVariant *variant = &search->variants[v];
+            if (row + variant->rows > grid.rows) continue;
+
+            for (int i = 0; i < variant->checkCount; i++) checkWords[i] = rowWords[ring + variant->checks[i].row] + (size_t)(ring + variant->checks[i].col)*blocks;
+
+            for (int block = 0; block < blocks; block++)
+            {
+                int col = block*64;
+                int valid = grid.cols - variant->cols - col + 1;
+                if (valid <= 0) break;
+
+                uint64_t candidates = occupied[block] & ((valid >= 64)? ~0ULL : ((1ULL << valid) - 1));
+                // Checks go in groups of four between tests, a test after every check mispredicts too often
+                for (int i = 0; (i < variant->checkCount) && (candidates != 0); i += 4)
+                {
+                    int groupEnd = (i + 4 < variant->checkCount)? i + 4 : variant->checkCount;
+                    for (int k = i; k < groupEnd; k++) candidates &= checkWords[k][block] ^ variant->checks[k].flip;
+                }
+
+                for (; candidates != 0; candidates &= candidates - 1)
+                {
+                    found[foundCount++] = (SearchMatch){ row, col + TrailingZeros(candidates), variant->rows, variant->cols, variant->symmetry, variant->phase };
+                    if (foundCount < 256) continue;
+
+                    if (!AddSearchMatches(search, found, foundCount))
+                    {
+                        free(window);
+                        return;
+                    }
+                    foundCount = 0;
+                }
+            }
+        }
+    }
+
+    AddSearchMatches(search, found, foundCount);
+    free(window);
+}
+
+// Board row y shifted by every check column for every block, then the columns holding a live cell of some variant
+static void LoadSearchRow(const LifeSearch *search, uint64_t *slot, int blocks, int y)
+{
+    int ring = search->isolated? 1 : 0;
+    int shifts = search->maxCols + 2*ring;
+    uint64_t *occupied = slot + (size_t)shifts*blocks;
+
+    for (int shift = 0; shift < shifts; shift++)
+    {
+        for (int block = 0; block < blocks; block++) slot[(size_t)shift*blocks + block] = GetRowBits(search->grid, y, block*64 + shift - ring);
+    }
+
+    memset(occupied, 0, blocks*sizeof(uint64_t));
+    for (int shift = ring; shift < ring + search->maxCols; shift++)
+    {
+        for (int block = 0; block < blocks; block++) occupied[block] |= slot[(size_t)shift*blocks + block];
+    }
+}
+
+// A negative count marks the search as failed
+static bool AddSearchMatches(LifeSearch *search, const SearchMatch *matches, int count)
+{
+    if (count == 0) return true;
+
+    pthread_mutex_lock(&search->lock);
+    if (count < 0)
+    {
+        search->failed = true;
+        pthread_mutex_unlock(&search->lock);
+        return false;
+    }
+    if (search->matchCount + count > search->matchCapacity)
+    {
+        int capacity = (search->matchCapacity > 0)? 2*search->matchCapacity : 1024;
+        while (capacity < search->matchCount + count) capacity *= 2;
+        SearchMatch *list = realloc(search->matches, capacity*sizeof(SearchMatch));
+        if (list == NULL)
+        {
+            search->failed = true;
+            pthread_mutex_unlock(&search->lock);
+            return false;
+        }
+        search->matches = list;
+        search->matchCapacity = capacity;
+    }
+    memcpy(search->matches + search->matchCount, matches, count*sizeof(SearchMatch));
+    search->matchCount += count;
+    pthread_mutex_unlock(&search->lock);
+
+    return true;
+}
+
+// 64 cells of row from col on, bit i for column col + i, cells off the board read as dead
+static uint64_t GetRowBits(LifeGrid grid, int row, int col)
+{
+    if ((row < 0) || (row >= grid.rows) || (col >= grid.cols) || (col <= -64)) return 0;
+
+    const uint64_t *cells = LIFE_ROW(grid, grid.cells, row) + 1;
+    int words = (grid.cols + 63)/64;
+    uint64_t lastMask = (grid.cols%64 == 0)? ~0ULL : ((1ULL << (grid.cols%64)) - 1);
+    int shift = ((col%64) + 64)%64;
+    int word = (col - shift)/64;
+
+    uint64_t low = ((word >= 0) && (word < words))? cells[word] : 0;
+    uint64_t high = (word + 1 < words)? cells[word + 1] : 0;
+    if (word == words - 1) low &= lastMask;
+    if (word + 1 == words - 1) high &= lastMask;
+
+    return (shift == 0)? low : (low >> shift) | (high << (64 - shift));
+}
+
+static int CompareMatches(const void *a, const void *b)
+{
+    const SearchMatch *matchA = (const SearchMatch *)a;
+    const SearchMatch *matchB = (const SearchMatch *)b;
+    if (matchA->row != matchB->row) return (matchA->row < matchB->row)? -1 : 1;
+    if (matchA->col != matchB->col) return (matchA->col < matchB->col)? -1 : 1;
+    if (matchA->phase != matchB->phase) return (matchA->phase < matchB->phase)? -1 : 1;
+    return matchA->symmetry - matchB->symmetry;
+}
+
+// Index of the lowest set bit, bits must not be 0
+static inline int TrailingZeros(uint64_t bits)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int count = 0;
+    while ((bits & 1) == 0)
+    {
+        bits >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
@@ -0,0 +1,819 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Generation stream server
+*
+*   Streams generations to viewers over a Unix or TCP socket: a snapshot when a viewer
+*   connects, then one delta per generation, the XOR of the cells against the previous one.
+*
+*   Addresses are "unix:/tmp/cgameoflife.sock" or "tcp:host:port", an empty host listens on
+*   every interface.
+*
+*   Stream format, integers in host byte order:
+*
+*       hello:      "GOLSTREM", uint32 version, rows, cols
+*       message:    uint8 type ('K' keyframe, 'D' delta), uint32 generation, uint32 payload size
+*       payload:    rows*words words, cols/64 rounded up words per row, as runs of varint
+*                   zero words, varint literal words, literal words. Keyframes hold the cells
+*                   themselves, deltas the XOR against the cells of the previous message.
+*
+*   The simulation thread only copies the grid and hands it over, a network thread diffs,
+*   encodes and sends. When it falls behind, the generations in between are merged into the
+*   next delta. Every viewer has a bounded send buffer: a viewer that can not take the next
+*   delta stops receiving deltas and, once its buffer drained, skips ahead to a keyframe of
+*   the latest generation. Slow viewers never stall the simulation or the other viewers.
+*
+*   NOTE: Windows builds can not open servers or clients.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#if !defined(_WIN32)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define STREAM_VERSION 1
+#define STREAM_MESSAGE_HEADER 9         // Type, generation and payload size
+#define STREAM_CLIENT_BYTES (4 << 20)   // Unsent bytes a viewer may hold before it skips deltas
+#define STREAM_KEYFRAME 'K'
+#define STREAM_DELTA 'D'
+
+#if defined(MSG_NOSIGNAL)
+    #define STREAM_SEND_FLAGS MSG_NOSIGNAL
+#else
+    #define STREAM_SEND_FLAGS 0
+#endif
+
+static const char streamMagic[8] = { 'G', 'O', 'L', 'S', 'T', 'R', 'E', 'M' };
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct StreamBuffer {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+    size_t sent;            // Bytes already sent from the start, send buffers only
+    bool failed;            // Allocation failed, contents are incomplete
+} StreamBuffer;
+
+typedef struct StreamClient {
+    int socket;
+    bool synced;            // Holds every delta since its last keyframe
+    StreamBuffer output;
+} StreamClient;
+
+struct LifeServer {
+    int listener;
+    int wake[2];            // Pipe the simulation thread writes to when a generation is ready
+    char unixPath[108];     // Socket file removed on close, empty for TCP
+    int rows;
+    int cols;
+    int words;              // Words per row, ghost words dropped
+
+    uint64_t *back;         // Filled by the simulation thread
+    uint64_t *ready;        // Latest generation handed over, not taken yet while readyFresh
+    int readyGeneration;
+    bool readyFresh;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    bool closing;
+    int clientCount;        // Copy of the network thread count for GetLifeServerClients()
+
+    // Network thread only
+    uint64_t *front;        // Generation taken from ready
+    uint64_t *current;      // Cells the synced viewers hold
+    int currentGeneration;
+    StreamBuffer delta;
+    StreamBuffer keyframe;  // Keyframe of currentGeneration when keyframeValid
+    bool keyframeValid;
+    StreamClient *clients;
+    int clientsUsed;
+    int clientsCapacity;
+};
+
+struct LifeClient {
+    int socket;
+    StreamInfo info;
+    uint64_t *state;        // Cells of info.generation, rows*words
+    StreamBuffer payload;
+};
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static void *ServerMain(void *arg);
+static void WakeServer(LifeServer *server);
+static int OpenStreamSocket(const char *address, bool listening, char *unixPath);
+static void AcceptClients(LifeServer *server);
+static void BroadcastDelta(LifeServer *server, int generation);
+static bool QueueKeyframe(LifeServer *server, StreamClient *client);
+static bool FlushClient(StreamClient *client);
+static void EncodeMessage(StreamBuffer *out, int type, int generation, const uint64_t *words, const uint64_t *base, size_t count);
+static bool DecodePayload(const unsigned char *data, size_t size, uint64_t *words, size_t count, bool keyframe);
+static void CopyGridWords(LifeGrid grid, uint64_t *words, int rowWords);
+static bool ReceiveAll(int socket, void *data, size_t size);
+
+static void AppendBytes(StreamBuffer *buffer, const void *data, size_t size);
+static void AppendVarint(StreamBuffer *buffer, uint64_t value);
+static bool ReadVarint(const unsigned char *data, size_t size, size_t *cursor, uint64_t *value);
+
+//----------------------------------------------------------------------------------
+// Server Functions Definition
+//----------------------------------------------------------------------------------
+
+// Listen on address and start the network thread, grid is the snapshot of generation
+// NOTE: Returns NULL when the address can not be bound or memory is short
+LifeServer *OpenLifeServer(const char *address, LifeGrid grid, int generation)
+{
+    LifeServer *server = calloc(1, sizeof(LifeServer));
+    if (server == NULL) return NULL;
+
+    server->rows = grid.rows;
+    server->cols = grid.cols;
+    server->words = (grid.cols + 63)/64;
+    server->currentGeneration = generation;
+    server->wake[0] = -1;
+    server->wake[1] = -1;
+
+    size_t count = (size_t)server->rows*server->words;
+    server->back = calloc(count, sizeof(uint64_t));
+    server->ready = calloc(count, sizeof(uint64_t));
+    server->front = calloc(count, sizeof(uint64_t));
+    server->current = calloc(count, sizeof(uint64_t));
+    server->listener = OpenStreamSocket(address, true, server->unixPath);
+
+    bool opened = (server->back != NULL) && (server->ready != NULL) && (server->front != NULL) &&
+        (server->current != NULL) && (server->listener >= 0) && (pipe(server->wake) == 0);
+    if (opened)
+    {
+        fcntl(server->wake[0], F_SETFL, O_NONBLOCK);
+        CopyGridWords(grid, server->current, server->words);
+        pthread_mutex_init(&server->lock, NULL);
+        opened = pthread_create(&server->thread, NULL, ServerMain, server) == 0;
+        if (!opened) pthread_mutex_destroy(&server->lock);
+    }
+    if (!opened)
+    {
+        if (server->listener >= 0) close(server->listener);
+        if (server->unixPath[0] != '\0') unlink(server->unixPath);
+        if (server->wake[0] >= 0) close(server->wake[0]);
+        if (server->wake[1] >= 0) close(server->wake[1]);
+        free(server->back);
+        free(server->ready);
+        free(server->front);
+        free(server->current);
+        free(server);
+        return NULL;
+    }
+
+    return server;
+}
+
+// Hand the grid to the network thread, never waits on viewers
+// NOTE: A generation still not taken when the next one arrives is merged into it
+void PublishLifeServer(LifeServer *server, LifeGrid grid, int generation)
+{
+    CopyGridWords(grid, server->back, server->words);
+
+    pthread_mutex_lock(&server->lock);
+    uint64_t *swap = server->ready;
+    server->ready = server->back;
+    server->back = swap;
+    server->readyGeneration = generation;
+    bool wake = !server->readyFresh;
+    server->readyFresh = true;
+    pthread_mutex_unlock(&server->lock);
+
+    if (wake) WakeServer(server);
+}
+
+// Viewers currently connected
+int GetLifeServerClients(LifeServer *server)
+{
+    pthread_mutex_lock(&server->lock);
+    int count = server->clientCount;
+    pthread_mutex_unlock(&server->lock);
+    return count;
+}
+
+// Disconnect every viewer, stop the network thread and close the socket
+void CloseLifeServer(LifeServer *server)
+{
+    if (server == NULL) return;
+
+    pthread_mutex_lock(&server->lock);
+    server->closing = true;
+    pthread_mutex_unlock(&server->lock);
+    WakeServer(server);
+    pthread_join(server->thread, NULL);
+
+    for (int i = 0; i < server->clientsUsed; i++)
+    {
+        close(server->clients[i].socket);
+        free(server->clients[i].output.data);
+    }
+    close(server->listener);
+    if (server->unixPath[0] != '\0') unlink(server->unixPath);
+    close(server->wake[0]);
+    close(server->wake[1]);
+    pthread_mutex_destroy(&server->lock);
+    free(server->clients);
+    free(server->delta.data);
+    free(server->keyframe.data);
+    free(server->back);
+    free(server->ready);
+    free(server->front);
+    free(server->current);
+    free(server);
+}
+
+//----------------------------------------------------------------------------------
+// Client Functions Definition
+//----------------------------------------------------------------------------------
+
+// Connect to a server and read its hello, NULL if unreachable or not a generation stream
+LifeClient *OpenLifeClient(const char *address)
+{
+    int socket = OpenStreamSocket(address, false, NULL);
+    if (socket < 0) return NULL;
+
+    char magic[8];
+    uint32_t hello[3];
+    LifeClient *client = NULL;
+    if (ReceiveAll(socket, magic, sizeof(magic)) && ReceiveAll(socket, hello, sizeof(hello)) &&
+        (memcmp(magic, streamMagic, sizeof(magic)) == 0) && (hello[0] == STREAM_VERSION) && (hello[1] > 0) && (hello[2] > 0))
+    {
+        client = calloc(1, sizeof(LifeClient));
+    }
+    if (client != NULL)
+    {
+        client->info.rows = (int)hello[1];
+        client->info.cols = (int)hello[2];
+        client->info.generation = -1;
+        client->state = calloc((size_t)client->info.rows*((client->info.cols + 63)/64), sizeof(uint64_t));
+        if (client->state == NULL)
+        {
+            free(client);
+            client = NULL;
+        }
+    }
+    if (client == NULL)
+    {
+        close(socket);
+        return NULL;
+    }
+
+    client->socket = socket;
+    return client;
+}
+
+void CloseLifeClient(LifeClient *client)
+{
+    if (client == NULL) return;
+
+    close(client->socket);
+    free(client->state);
+    free(client->payload.data);
+    free(client);
+}
+
+// Stream size and what was received so far
+StreamInfo GetLifeClientInfo(const LifeClient *client)
+{
+    return client->info;
+}
+
+// Wait for the next message and apply it, grid must have the stream size
+// NOTE: Returns false once the server closed the stream or sent something unreadable
+bool ReceiveLifeClient(LifeClient *client, LifeGrid *grid)
+{
+    int words = (client->info.cols + 63)/64;
+    unsigned char header[STREAM_MESSAGE_HEADER];
+    if (!ReceiveAll(client->socket, header, sizeof(header))) return false;
+
+    uint32_t generation = 0;
+    uint32_t size = 0;
+    memcpy(&generation, header + 1, sizeof(generation));
+    memcpy(&size, header + 5, sizeof(size));
+
+    // Deltas only apply on top of a keyframe
+    bool keyframe = header[0] == STREAM_KEYFRAME;
+    if (!keyframe && ((header[0] != STREAM_DELTA) || (client->info.generation < 0))) return false;
+
+    client->payload.size = 0;
+    AppendBytes(&client->payload, NULL, size);
+    if (client->payload.failed || !ReceiveAll(client->socket, client->payload.data, size)) return false;
+    if (!DecodePayload(client->payload.data, size, client->state, (size_t)client->info.rows*words, keyframe)) return false;
+
+    client->info.generation = (int)generation;
+    client->info.bytes += STREAM_MESSAGE_HEADER + (int64_t)size;
+    if (keyframe) client->info.keyframes++;
+    else client->info.deltas++;
+
+    if ((grid->rows == client->info.rows) && (grid->cols == client->info.cols))
+    {
+        for (int row = 0; row < grid->rows; row++)
+        {
+            memcpy(LIFE_ROW(*grid, grid->cells, row) + 1, client->state + (size_t)row*words, (size_t)words*sizeof(uint64_t));
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Network thread: accepts viewers, turns handed over generations into deltas and sends
+static void *ServerMain(void *arg)
+{
+    LifeServer *server = (LifeServer *)arg;
+    struct pollfd *polls = NULL;
+    int pollsCapacity = 0;
+
+    while (true)
+    {
+        if (server->clientsUsed + 2 > pollsCapacity)
+        {
+            int capacity = (server->clientsUsed + 2)*2;
+            struct pollfd *grown = realloc(polls, capacity*sizeof(struct pollfd));
+            if (grown != NULL)
+            {
+                polls = grown;
+                pollsCapacity = capacity;
+            }
+            else if (polls == NULL) break;
+        }
+
+        // Viewers are polled for reads too, to notice when they hang up
+        int pollCount = 2;
+        polls[0] = (struct pollfd){ server->wake[0], POLLIN, 0 };
+        polls[1] = (struct pollfd){ server->listener, POLLIN, 0 };
+        for (int i = 0; (i < server->clientsUsed) && (pollCount < pollsCapacity); i++)
+        {
+            StreamClient *client = &server->clients[i];
+            polls[pollCount++] = (struct pollfd){ client->socket, (short)(POLLIN | ((client->output.sent < client->output.size)? POLLOUT : 0)), 0 };
+        }
+        if ((poll(polls, pollCount, -1) < 0) && (errno != EINTR)) break;
+
+        if (polls[0].revents & POLLIN)
+        {
+            char bytes[64];
+            while (read(server->wake[0], bytes, sizeof(bytes)) > 0) { }
+
+            pthread_mutex_lock(&server->lock);
+            bool closing = server->closing;
+            bool fresh = server->readyFresh;
+            int generation = server->readyGeneration;
+            if (fresh)
+            {
+                uint64_t *swap = server->front;
+                server->front = server->ready;
+                server->ready = swap;
+                server->readyFresh = false;
+            }
+            pthread_mutex_unlock(&server->lock);
+
+            if (closing) break;
+            if (fresh) BroadcastDelta(server, generation);
+        }
+        if (polls[1].revents & POLLIN) AcceptClients(server);
+
+        // Clients are dropped by moving the last one in their place, so walk backwards
+        for (int i = pollCount - 1; i >= 2; i--)
+        {
+            int index = i - 2;
+            StreamClient *client = &server->clients[index];
+            bool alive = true;
+
+            if (polls[i].revents & (POLLIN | POLLERR | POLLHUP))
+            {
+                char bytes[256];
+                ssize_t received = recv(client->socket, bytes, sizeof(bytes), 0);
+                if ((received == 0) || ((received < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) alive = false;
+            }
+            if (alive && (polls[i].revents & POLLOUT)) alive = FlushClient(client);
+
+            // A viewer that skipped deltas resumes from a keyframe once everything queued left
+            if (alive && !client->synced && (client->output.sent == client->output.size)) alive = QueueKeyframe(server, client) && FlushClient(client);
+
+            if (!alive)
+            {
+                close(client->socket);
+                free(client->output.data);
+                server->clients[index] = server->clients[server->clientsUsed - 1];
+                server->clientsUsed--;
+            }
+        }
+
+        pthread_mutex_lock(&server->lock);
+        server->clientCount = server->clientsUsed;
+        pthread_mutex_unlock(&server->lock);
+    }
+
+    free(polls);
+    return NULL;
+}
+
+// Wake the network thread, the pipe only needs to hold one byte for poll() to return
+static void WakeServer(LifeServer *server)
+{
+    char byte = 0;
+    ssize_t written = write(server->wake[1], &byte, 1);
+    (void)written;
+}
+
+// Bind and listen, or connect, to "unix:path" or "tcp:host:port", returns the socket or -1
+static int OpenStreamSocket(const char *address, bool listening, char *unixPath)
+{
+    if (strncmp(address, "unix:", 5) == 0)
+    {
+        struct sockaddr_un local = { 0 };
+        const char *path = address + 5;
+        if ((path[0] == '\0') || (strlen(path) >= sizeof(local.sun_path))) return -1;
+
+        local.sun_family = AF_UNIX;
+        strcpy(local.sun_path, path);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+
+        if (listening)
+        {
+            unlink(path);
+            if ((bind(fd, (struct sockaddr *)&local, sizeof(local)) != 0) || (listen(fd, 16) != 0))
+            {
+                close(fd);
+                return -1;
+            }
+            strcpy(unixPath, path);
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+        }
+        else if (connect(fd, (struct sockaddr *)&local, sizeof(local)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    if (strncmp(address, "tcp:", 4) != 0) return -1;
+
+    // Port follows the last colon so the host part may be empty
+    char host[256];
+    const char *port = strrchr(address + 4, ':');
+    if ((port == NULL) || ((size_t)(port - (address + 4)) >= sizeof(host))) return -1;
+    memcpy(host, address + 4, port - (address + 4));
+    host[port - (address + 4)] = '\0';
+    port++;
+
+    struct addrinfo hints = { 0 };
+    struct addrinfo *found = NULL;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening? AI_PASSIVE : 0;
+    if (getaddrinfo((host[0] != '\0')? host : NULL, port, &hints, &found) != 0) return -1;
+
+    int fd = -1;
+    for (struct addrinfo *entry = found; (entry != NULL) && (fd < 0); entry = entry->ai_next)
+    {
+        fd = socket(entry->ai_family, entry->ai_socktype, entry->ai_protocol);
+        if (fd < 0) continue;
+
+        bool opened = false;
+        if (listening)
+        {
+            int reuse = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            opened = (bind(fd, entry->ai_addr, entry->ai_addrlen) == 0) && (listen(fd, 16) == 0);
+            if (opened) fcntl(fd, F_SETFL, O_NONBLOCK);
+        }
+        else opened = connect(fd, entry->ai_addr, entry->ai_addrlen) == 0;
+
+        if (!opened)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+
+    return fd;
+}
+
+// Take every pending connection, greet it and queue a keyframe of the current generation
+static void AcceptClients(LifeServer *server)
+{
+    while (true)
+    {
+        int fd = accept(server->listener, NULL, NULL);
+        if (fd < 0) return;
+
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+#if defined(SO_NOSIGPIPE)
+        int noSignal = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSignal, sizeof(noSignal));
+#endif
+        if (server->clientsUsed == server->clientsCapacity)
+        {
+            int capacity = (server->clientsCapacity > 0)? server->clientsCapacity*2 : 8;
+            StreamClient *grown = realloc(server->clients, capacity*sizeof(StreamClient));
+            if (grown == NULL)
+            {
+                close(fd);
+                continue;
+            }
+            server->clients = grown;
+            server->clientsCapacity = capacity;
+        }
+
+        StreamClient client = { 0 };
+        client.socket = fd;
+        uint32_t hello[3] = { STREAM_VERSION, (uint32_t)server->rows, (uint32_t)server->cols };
+        AppendBytes(&client.output, streamMagic, sizeof(streamMagic));
+        AppendBytes(&client.output, hello, sizeof(hello));
+
+        if (QueueKeyframe(server, &client) && FlushClient(&client)) server->clients[server->clientsUsed++] = client;
+        else
+        {
+            close(fd);
+            free(client.output.data);
+        }
+    }
+}
+
+// Encode the step from current to front once and queue it on every synced viewer
+static void BroadcastDelta(LifeServer *server, int generation)
+{
+    size_t count = (size_t)server->rows*server->words;
+    server->delta.size = 0;
+    server->delta.failed = false;
+    EncodeMessage(&server->delta, STREAM_DELTA, generation, server->front, server->current, count);
+
+    uint64_t *swap = server->current;
+    server->current = server->front;
+    server->front = swap;
+    server->currentGeneration = generation;
+    server->keyframeValid = false;
+
+    // A delta that fails to encode can not be sent, every viewer resyncs from a keyframe
+    for (int i = 0; i < server->clientsUsed; i++)
+    {
+        StreamClient *client = &server->clients[i];
+        if (!client->synced) continue;
+
+        size_t queued = client->output.size - client->output.sent;
+        if (server->delta.failed || (queued + server->delta.size > STREAM_CLIENT_BYTES)) client->synced = false;
+        else AppendBytes(&client->output, server->delta.data, server->delta.size);
+    }
+}
+
+// Queue a keyframe of the current generation, encoded once per generation for every viewer
+static bool QueueKeyframe(LifeServer *server, StreamClient *client)
+{
+    if (!server->keyframeValid)
+    {
+        server->keyframe.size = 0;
+        server->keyframe.failed = false;
+        EncodeMessage(&server->keyframe, STREAM_KEYFRAME, server->currentGeneration, server->current, NULL, (size_t)server->rows*server->words);
+        server->keyframeValid = !server->keyframe.failed;
+        if (!server->keyframeValid) return false;
+    }
+
+    AppendBytes(&client->output, server->keyframe.data, server->keyframe.size);
+    client->synced = !client->output.failed;
+    return client->synced;
+}
+
+// Send as much queued output as the socket takes, false once the viewer is gone
+static bool FlushClient(StreamClient *client)
+{
+    StreamBuffer *output = &client->output;
+    if (output->failed) return false;
+
+    while (output->sent < output->size)
+    {
+        ssize_t sent = send(client->socket, output->data + output->sent, output->size - output->sent, STREAM_SEND_FLAGS);
+        if (sent < 0)
+        {
+            if (errno == EINTR) continue;
+            return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+        }
+        output->sent += (size_t)sent;
+    }
+    output->size = 0;
+    output->sent = 0;
+    return true;
+}
+
+// Append a message with words, XORed against base unless base is NULL, as zero/literal runs
+static void EncodeMessage(StreamBuffer *out, int type, int generation, const uint64_t *words, const uint64_t *base, size_t count)
+{
+    unsigned char header[STREAM_MESSAGE_HEADER] = { (unsigned char)type };
+    uint32_t value = (uint32_t)generation;
+    memcpy(header + 1, &value, sizeof(value));
+    size_t headerAt = out->size;
+    AppendBytes(out, header, sizeof(header));
+
+    size_t i = 0;
+    while (i < count)
+    {
+        size_t zeros = 0;
+        while ((i + zeros < count) && ((words[i + zeros] ^ (base? base[i + zeros] : 0)) == 0)) zeros++;
+        i += zeros;
+
+        // Literal runs end at two zero words in a row, a single zero is cheaper kept inline
+        size_t literals = 0;
+        while (i + literals < count)
+        {
+            bool zero = (words[i + literals] ^ (base? base[i + literals] : 0)) == 0;
+            bool nextZero = (i + literals + 1 >= count) || ((words[i + literals + 1] ^ (base? base[i + literals + 1] : 0)) == 0);
+            if (zero && nextZero) break;
+            literals++;
+        }
+
+        AppendVarint(out, zeros);
+        AppendVarint(out, literals);
+        for (size_t j = 0; j < literals; j++)
+        {
+            uint64_t word = words[i + j] ^ (base? base[i + j] : 0);
+            AppendBytes(out, &word, sizeof(word));
+        }
+        i += literals;
+    }
+
+    if (out->failed) return;
+    value = (uint32_t)(out->size - headerAt - STREAM_MESSAGE_HEADER);
+    memcpy(out->data + headerAt + 5, &value, sizeof(value));
+}
+
+// Apply a payload to words: keyframes replace them, deltas are XORed in
+static bool DecodePayload(const unsigned char *data, size_t size, uint64_t *words, size_t count, bool keyframe)
+{
+    if (keyframe) memset(words, 0, count*sizeof(uint64_t));
+
+    size_t cursor = 0;
+    size_t i = 0;
+    while (cursor < size)
+    {
+        uint64_t zeros = 0;
+        uint64_t literals = 0;
+        if (!ReadVarint(data, size, &cursor, &zeros) || !ReadVarint(data, size, &cursor, &literals)) return false;
+        if ((zeros > count - i) || (literals > count - i - zeros) || (literals*sizeof(uint64_t) > size - cursor)) return false;
+
+        i += zeros;
+        for (uint64_t j = 0; j < literals; j++)
+        {
+            uint64_t word = 0;
+            memcpy(&word, data + cursor, sizeof(word));
+            words[i++] ^= word;
+            cursor += sizeof(word);
+        }
+    }
+    return i == count;
+}
+
+// Rows of the grid without ghost words, bits past the last column cleared
+static void CopyGridWords(LifeGrid grid, uint64_t *words, int rowWords)
+{
+    uint64_t lastMask = (grid.cols%64 == 0)? ~0ULL : ((1ULL << (grid.cols%64)) - 1);
+    for (int row = 0; row < grid.rows; row++)
+    {
+        uint64_t *out = words + (size_t)row*rowWords;
+        memcpy(out, LIFE_ROW(grid, grid.cells, row) + 1, (size_t)rowWords*sizeof(uint64_t));
+        out[rowWords - 1] &= lastMask;
+    }
+}
+
+static bool ReceiveAll(int socket, void *data, size_t size)
+{
+    unsigned char *bytes = (unsigned char *)data;
+    while (size > 0)
+    {
+        ssize_t received = recv(socket, bytes, size, 0);
+        if (received < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (received == 0) return false;
+        bytes += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+// Grow the buffer as needed, data NULL only reserves size bytes
+// NOTE: Send buffers drop the bytes already sent before growing
+static void AppendBytes(StreamBuffer *buffer, const void *data, size_t size)
+{
+    if (buffer->failed) return;
+
+    if ((buffer->sent > 0) && (buffer->size + size > buffer->capacity))
+    {
+        memmove(buffer->data, buffer->data + buffer->sent, buffer->size - buffer->sent);
+        buffer->size -= buffer->sent;
+        buffer->sent = 0;
+    }
+    if (buffer->size + size > buffer->capacity)
+    {
+        size_t capacity = (buffer->capacity > 0)? buffer->capacity : 4096;
+        while (capacity < buffer->size + size) capacity *= 2;
+        unsigned char *grown = realloc(buffer->data, capacity);
+        if (grown == NULL)
+        {
+            buffer->failed = true;
+            return;
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    if (data != NULL) memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+}
+
+static void AppendVarint(StreamBuffer *buffer, uint64_t value)
+{
+    unsigned char bytes[10];
+    int count = 0;
+    do
+    {
+        bytes[count] = (unsigned char)(value & 0x7F);
+        value >>= 7;
+        if (value != 0) bytes[count] |= 0x80;
+        count++;
+    } while (value != 0);
+    AppendBytes(buffer, bytes, count);
+}
+
+static bool ReadVarint(const unsigned char *data, size_t size, size_t *cursor, uint64_t *value)
+{
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (*cursor >= size) return false;
+        unsigned char byte = data[(*cursor)++];
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+#else
+
+//----------------------------------------------------------------------------------
+// Stream Server Functions Definition (Windows)
+//----------------------------------------------------------------------------------
+
+// Windows sockets are not POSIX sockets, servers and clients never open and the other calls never get one
+LifeServer *OpenLifeServer(const char *address, LifeGrid grid, int generation)
+{
+    return NULL;
+}
+
+void PublishLifeServer(LifeServer *server, LifeGrid grid, int generation)
+{
+}
+
+int GetLifeServerClients(LifeServer *server)
+{
+    return 0;
+}
+
+void CloseLifeServer(LifeServer *server)
+{
+}
+
+LifeClient *OpenLifeClient(const char *address)
+{
+    return NULL;
+}
+
+void CloseLifeClient(LifeClient *client)
+{
+}
+
+StreamInfo GetLifeClientInfo(const LifeClient *client)
+{
+    return (StreamInfo){ 0 };
+}
+
+bool ReceiveLifeClient(LifeClient *client, LifeGrid *grid)
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,386 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Shared memory publication
+*
+*   Publishes generations in a POSIX shared memory segment that other local processes map
+*   and read in place, without the simulation serializing anything or taking a lock.
+*
+*   The segment is a header followed by a ring of frames. Every frame holds the rows of one
+*   generation as cols/64 rounded up words each, ghost words dropped and bits past the last
+*   column cleared. Frames are guarded seqlock style: the writer makes the frame sequence odd,
+*   rewrites the cells and makes it even again. A reader notes an even sequence, reads the
+*   cells and keeps them only if the sequence did not move meanwhile.
+*
+*   Segment layout, integers in host byte order:
+*
+*       0   "GOLSHARE"
+*       8   uint32 version, rows, cols, words per row, frames
+*       32  uint64 frame size in bytes, header included
+*       40  uint64 frames published so far, the latest sits in slot (published - 1)%frames
+*       64  frames: uint64 sequence, int64 generation, padding to 64 bytes, rows*words cells
+*
+*   NOTE: Readers see a generation only while it is among the last frames ones published.
+*   Windows builds can not open segments.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#if !defined(_WIN32)
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define SHARE_VERSION 1
+#define SHARE_HEADER_BYTES 64       // Header and frame headers keep the cells cache line aligned
+#define SHARE_READ_RETRIES 8        // Attempts to copy the latest frame while it keeps moving
+
+static const char shareMagic[8] = { 'G', 'O', 'L', 'S', 'H', 'A', 'R', 'E' };
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ShareHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t words;
+    uint32_t frames;
+    uint32_t reserved;
+    uint64_t frameBytes;
+    uint64_t published;     // Frames published so far, written last
+} ShareHeader;
+
+typedef struct ShareFrame {
+    uint64_t sequence;      // Odd while the frame is being rewritten
+    int64_t generation;
+} ShareFrame;
+
+struct LifeShare {
+    char *name;
+    unsigned char *base;    // Mapped segment
+    size_t size;
+    ShareHeader *header;
+    int rows;
+    int cols;
+    int words;
+    int frames;
+    uint64_t published;     // Only this process writes the header counter
+};
+
+struct LifeShareReader {
+    unsigned char *base;
+    size_t size;
+    const ShareHeader *header;
+    ShareInfo info;
+};
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static size_t GetFrameBytes(int rows, int words);
+static ShareFrame *GetShareFrame(unsigned char *base, uint64_t frameBytes, int slot);
+static const ShareFrame *FindShareFrame(const LifeShareReader *reader, int generation);
+
+//----------------------------------------------------------------------------------
+// Publisher Functions Definition
+//----------------------------------------------------------------------------------
+
+// Create the segment name ("/cgameoflife") with a ring of frames generations
+// NOTE: A segment left over by a crashed run with the same name is replaced
+LifeShare *OpenLifeShare(const char *name, int rows, int cols, int frames)
+{
+    if ((rows <= 0) || (cols <= 0) || (frames <= 0)) return NULL;
+
+    LifeShare *share = calloc(1, sizeof(LifeShare));
+    if (share == NULL) return NULL;
+
+    share->rows = rows;
+    share->cols = cols;
+    share->words = (cols + 63)/64;
+    share->frames = frames;
+    share->size = SHARE_HEADER_BYTES + (size_t)frames*GetFrameBytes(rows, share->words);
+    share->name = malloc(strlen(name) + 1);
+    if (share->name == NULL)
+    {
+        free(share);
+        return NULL;
+    }
+    strcpy(share->name, name);
+
+    shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+    {
+        free(share->name);
+        free(share);
+        return NULL;
+    }
+
+    void *base = MAP_FAILED;
+    if (ftruncate(fd, (off_t)share->size) == 0) base = mmap(NULL, share->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        shm_unlink(name);
+        free(share->name);
+        free(share);
+        return NULL;
+    }
+
+    // The segment starts zeroed: every frame is even and empty until first published
+    share->base = (unsigned char *)base;
+    share->header = (ShareHeader *)base;
+    share->header->version = SHARE_VERSION;
+    share->header->rows = (uint32_t)rows;
+    share->header->cols = (uint32_t)cols;
+    share->header->words = (uint32_t)share->words;
+    share->header->frames = (uint32_t)frames;
+    share->header->frameBytes = GetFrameBytes(rows, share->words);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(share->header->magic, shareMagic, sizeof(shareMagic));
+
+    return share;
+}
+
+// Copy the grid into the next frame of the ring, readers never block this
+void PublishLifeShare(LifeShare *share, LifeGrid grid, int generation)
+{
+    int slot = (int)(share->published%(uint64_t)share->frames);
+    ShareFrame *frame = GetShareFrame(share->base, share->header->frameBytes, slot);
+    uint64_t *cells = (uint64_t *)((unsigned char *)frame + SHARE_HEADER_BYTES);
+    uint64_t lastMask = (share->cols%64 == 0)? ~0ULL : ((1ULL << (share->cols%64)) - 1);
+
+    // Odd sequence first, the fence keeps the cell stores from moving above it
+    uint64_t sequence = frame->sequence;
+    __atomic_store_n(&frame->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&frame->generation, (int64_t)generation, __ATOMIC_RELAXED);
+    for (int row = 0; row < share->rows; row++)
+    {
+        uint64_t *out = cells + (size_t)row*share->words;
+        memcpy(out, LIFE_ROW(grid, grid.cells, row) + 1, (size_t)share->words*sizeof(uint64_t));
+        out[share->words - 1] &= lastMask;
+    }
+
+    __atomic_store_n(&frame->sequence, sequence + 2, __ATOMIC_RELEASE);
+    share->published++;
+    __atomic_store_n(&share->header->published, share->published, __ATOMIC_RELEASE);
+}
+
+// Unmap and remove the segment, readers keep their mapping until they close it
+void CloseLifeShare(LifeShare *share)
+{
+    if (share == NULL) return;
+
+    munmap(share->base, share->size);
+    shm_unlink(share->name);
+    free(share->name);
+    free(share);
+}
+
+//----------------------------------------------------------------------------------
+// Reader Functions Definition
+//----------------------------------------------------------------------------------
+
+// Map a published segment read-only, NULL if missing or not a grid segment
+LifeShareReader *OpenLifeShareReader(const char *name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+
+    struct stat status;
+    void *base = MAP_FAILED;
+    if ((fstat(fd, &status) == 0) && (status.st_size >= SHARE_HEADER_BYTES))
+    {
+        base = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+
+    const ShareHeader *header = (const ShareHeader *)base;
+    size_t frameBytes = GetFrameBytes((int)header->rows, (int)header->words);
+    bool valid = (memcmp(header->magic, shareMagic, sizeof(shareMagic)) == 0) && (header->version == SHARE_VERSION) &&
+        (header->rows > 0) && (header->cols > 0) && (header->frames > 0) &&
+        (header->words == (header->cols + 63)/64) && (header->frameBytes == frameBytes) &&
+        ((size_t)status.st_size >= SHARE_HEADER_BYTES + (size_t)header->frames*frameBytes);
+    LifeShareReader *reader = valid? calloc(1, sizeof(LifeShareReader)) : NULL;
+    if (reader == NULL)
+    {
+        munmap(base, (size_t)status.st_size);
+        return NULL;
+    }
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    reader->base = (unsigned char *)base;
+    reader->size = (size_t)status.st_size;
+    reader->header = header;
+    reader->info.rows = (int)header->rows;
+    reader->info.cols = (int)header->cols;
+    reader->info.words = (int)header->words;
+    reader->info.frames = (int)header->frames;
+
+    return reader;
+}
+
+void CloseLifeShareReader(LifeShareReader *reader)
+{
+    if (reader == NULL) return;
+
+    munmap(reader->base, reader->size);
+    free(reader);
+}
+
+// Segment geometry and the generation published last, -1 before the first one
+ShareInfo GetLifeShareInfo(const LifeShareReader *reader)
+{
+    ShareInfo info = reader->info;
+    uint64_t published = __atomic_load_n(&reader->header->published, __ATOMIC_ACQUIRE);
+
+    info.latestGeneration = -1;
+    if (published > 0)
+    {
+        const ShareFrame *frame = GetShareFrame(reader->base, reader->header->frameBytes, (int)((published - 1)%(uint64_t)info.frames));
+        info.latestGeneration = (int)__atomic_load_n(&frame->generation, __ATOMIC_RELAXED);
+    }
+    return info;
+}
+
+// Cells of a generation in place, rows*words words, generation < 0 picks the latest
+// NOTE: Anything read from them is only valid if CheckLifeShare() then accepts sequence
+const uint64_t *PeekLifeShare(const LifeShareReader *reader, int generation, uint64_t *sequence)
+{
+    const ShareFrame *frame = FindShareFrame(reader, generation);
+    if (frame == NULL) return NULL;
+
+    *sequence = __atomic_load_n(&frame->sequence, __ATOMIC_ACQUIRE);
+    if ((*sequence & 1) || ((generation >= 0) && (__atomic_load_n(&frame->generation, __ATOMIC_RELAXED) != generation))) return NULL;
+
+    return (const uint64_t *)((const unsigned char *)frame + SHARE_HEADER_BYTES);
+}
+
+// Whether the frame at cells was left untouched since PeekLifeShare() returned sequence
+bool CheckLifeShare(const uint64_t *cells, uint64_t sequence)
+{
+    const ShareFrame *frame = (const ShareFrame *)((const unsigned char *)cells - SHARE_HEADER_BYTES);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&frame->sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+// Copy a generation into a grid of the same size, generation < 0 copies the latest
+// NOTE: Returns false once the generation left the ring or before it is published
+bool ReadLifeShare(const LifeShareReader *reader, int generation, LifeGrid *grid)
+{
+    if ((grid->rows != reader->info.rows) || (grid->cols != reader->info.cols)) return false;
+
+    int words = reader->info.words;
+    for (int attempt = 0; attempt < SHARE_READ_RETRIES; attempt++)
+    {
+        uint64_t sequence = 0;
+        const uint64_t *cells = PeekLifeShare(reader, generation, &sequence);
+        if (cells == NULL)
+        {
+            if (generation >= 0) return false;
+            continue;
+        }
+
+        for (int row = 0; row < grid->rows; row++)
+        {
+            memcpy(LIFE_ROW(*grid, grid->cells, row) + 1, cells + (size_t)row*words, (size_t)words*sizeof(uint64_t));
+        }
+        if (CheckLifeShare(cells, sequence)) return true;
+
+        // A given generation is gone once its frame was rewritten, the latest can be retried
+        if (generation >= 0) return false;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+static size_t GetFrameBytes(int rows, int words)
+{
+    return SHARE_HEADER_BYTES + (size_t)rows*words*sizeof(uint64_t);
+}
+
+static ShareFrame *GetShareFrame(unsigned char *base, uint64_t frameBytes, int slot)
+{
+    return (ShareFrame *)(base + SHARE_HEADER_BYTES + (size_t)slot*frameBytes);
+}
+
+// Frame holding a generation among the ones still in the ring, newest first
+static const ShareFrame *FindShareFrame(const LifeShareReader *reader, int generation)
+{
+    uint64_t published = __atomic_load_n(&reader->header->published, __ATOMIC_ACQUIRE);
+    uint64_t frames = (uint64_t)reader->info.frames;
+    if (published == 0) return NULL;
+
+    for (uint64_t i = 0; (i < frames) && (i < published); i++)
+    {
+        const ShareFrame *frame = GetShareFrame(reader->base, reader->header->frameBytes, (int)((published - 1 - i)%frames));
+        if ((generation < 0) || (__atomic_load_n(&frame->generation, __ATOMIC_RELAXED) == generation)) return frame;
+    }
+    return NULL;
+}
+
+#else
+
+//----------------------------------------------------------------------------------
+// Shared Memory Functions Definition (Windows)
+//----------------------------------------------------------------------------------
+
+// Windows has no POSIX shared memory, segments never open and the other calls never get one
+LifeShare *OpenLifeShare(const char *name, int rows, int cols, int frames)
+{
+    return NULL;
+}
+
+void PublishLifeShare(LifeShare *share, LifeGrid grid, int generation)
+{
+}
+
+void CloseLifeShare(LifeShare *share)
+{
+}
+
+LifeShareReader *OpenLifeShareReader(const char *name)
+{
+    return NULL;
+}
+
+void CloseLifeShareReader(LifeShareReader *reader)
+{
+}
+
+ShareInfo GetLifeShareInfo(const LifeShareReader *reader)
+{
+    return (ShareInfo){ 0 };
+}
+
+const uint64_t *PeekLifeShare(const LifeShareReader *reader, int generation, uint64_t *sequence)
+{
+    return NULL;
+}
+
+bool CheckLifeShare(const uint64_t *cells, uint64_t sequence)
+{
+    return false;
+}
+
+bool ReadLifeShare(const LifeShareReader *reader, int generation, LifeGrid *grid)
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,259 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Sparse life engine
+*
+*   Keeps a live-neighbour count for every cell and only re-evaluates cells whose count or
+*   state changed in the previous generation, so a generation costs O(changes) instead of
+*   O(cells). Suited to huge, mostly empty boards with a few active spots.
+*
+*   The LifeGrid stays the source of truth for cell states, every flip is written back to it.
+*   Only the counts and queued flags take memory per cell, the pending and flip lists grow
+*   with the active cells. Bulk edits of the grid are counted from the words they changed.
+*
+**********************************************************************************************/
+
+#include "life.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static int GhostPreimages(GridTopology topology, int value, int size, int *out);
+static bool ReserveSparseCells(SparseLife *sparse, int64_t **list, int64_t *capacity, int64_t needed);
+static void QueueCell(SparseLife *sparse, int64_t index);
+static void CountFlip(SparseLife *sparse, int row, int col, bool alive);
+static bool RebuildSparseLife(SparseLife *sparse, LifeGrid *grid);
+
+//----------------------------------------------------------------------------------
+// Sparse Engine Functions Definition
+//----------------------------------------------------------------------------------
+
+// Build neighbour counts for the current grid, counts is NULL on failure
+SparseLife LoadSparseLife(LifeGrid *grid)
+{
+    SparseLife sparse = { 0 };
+    sparse.rows = grid->rows;
+    sparse.cols = grid->cols;
+
+    size_t cells = (size_t)grid->rows*grid->cols;
+    sparse.counts = calloc(cells, sizeof(uint8_t));
+    sparse.queued = calloc(cells, sizeof(uint8_t));
+    if ((sparse.counts == NULL) || (sparse.queued == NULL) || !RebuildSparseLife(&sparse, grid))
+    {
+        UnloadSparseLife(sparse);
+        return (SparseLife){ 0 };
+    }
+
+    return sparse;
+}
+
+void UnloadSparseLife(SparseLife sparse)
+{
+    free(sparse.counts);
+    free(sparse.queued);
+    free(sparse.pending);
+    free(sparse.flips);
+}
+
+// Edit one cell, neighbour counts are updated in place
+// NOTE: Returns false when out of memory, the cell is then left as it was
+bool SetSparseCell(SparseLife *sparse, LifeGrid *grid, int row, int col, bool alive)
+{
+    if ((sparse->topology != grid->topology) && !RebuildSparseLife(sparse, grid)) return false;
+    if (GetLifeCell(*grid, row, col) == alive) return true;
+
+    // A flip queues itself and its eight neighbours, ghost views included
+    if (!ReserveSparseCells(sparse, &sparse->pending, &sparse->pendingCapacity, sparse->pendingCount + 9)) return false;
+
+    SetLifeCell(grid, row, col, alive);
+    CountFlip(sparse, row, col, alive);
+    return true;
+}
+
+// Count the cells a bulk edit of the grid flipped, before holds rows [row, row + height) as they were
+// NOTE: Returns false when out of memory, the counts are then partly updated and the engine must be reloaded
+bool UpdateSparseRows(SparseLife *sparse, LifeGrid *grid, int row, int height, const uint64_t *before)
+{
+    if (sparse->topology != grid->topology) return RebuildSparseLife(sparse, grid);
+
+    int words = (grid->cols + 63)/64;
+    uint64_t lastMask = (grid->cols%64 == 0)? ~0ULL : ((1ULL << (grid->cols%64)) - 1);
+    for (int r = row; r < row + height; r++)
+    {
+        const uint64_t *old = before + (size_t)(r - row)*grid->stride + 1;
+        const uint64_t *cells = LIFE_ROW(*grid, grid->cells, r) + 1;
+        for (int w = 0; w < words; w++)
+        {
+            uint64_t flipped = (old[w] ^ cells[w]) & ((w == words - 1)? lastMask : ~0ULL);
+            if (flipped == 0) continue;
+
+            if (!ReserveSparseCells(sparse, &sparse->pending, &sparse->pendingCapacity, sparse->pendingCount + 9*(int64_t)CountLifeBits(flipped))) return false;
+            for (; flipped != 0; flipped &= flipped - 1)
+            {
+                int bit = CountLifeBits((flipped & (~flipped + 1)) - 1);
+                CountFlip(sparse, r, w*64 + bit, (cells[w] >> bit) & 1);
+            }
+        }
+    }
+
+    return true;
+}
+
+// Advance one generation (B3/S23), returns number of cells that changed
+// NOTE: Returns -1 when out of memory, the grid and counts are then left as they were
+int64_t StepSparseLife(SparseLife *sparse, LifeGrid *grid)
+{
+    if ((sparse->topology != grid->topology) && !RebuildSparseLife(sparse, grid)) return -1;
+    if (!ReserveSparseCells(sparse, &sparse->flips, &sparse->flipCapacity, sparse->pendingCount)) return -1;
+
+    // Decide every pending cell against the old counts before touching any of them
+    int64_t flipCount = 0;
+    for (int64_t i = 0; i < sparse->pendingCount; i++)
+    {
+        int64_t index = sparse->pending[i];
+        int count = sparse->counts[index];
+        bool alive = GetLifeCell(*grid, (int)(index/sparse->cols), (int)(index%sparse->cols));
+        bool next = (count == 3) || (alive && (count == 2));
+        if (next != alive) sparse->flips[flipCount++] = index;
+    }
+
+    // The pending list is refilled from the start, every flip queues at most nine cells
+    if (!ReserveSparseCells(sparse, &sparse->pending, &sparse->pendingCapacity, 9*flipCount)) return -1;
+    for (int64_t i = 0; i < sparse->pendingCount; i++) sparse->queued[sparse->pending[i]] = 0;
+    sparse->pendingCount = 0;
+
+    // Flipped cells and every cell whose count moved are the candidates for next generation
+    for (int64_t i = 0; i < flipCount; i++)
+    {
+        int64_t index = sparse->flips[i];
+        int row = (int)(index/sparse->cols);
+        int col = (int)(index%sparse->cols);
+        bool alive = !GetLifeCell(*grid, row, col);
+        SetLifeCell(grid, row, col, alive);
+        CountFlip(sparse, row, col, alive);
+    }
+
+    return flipCount;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+// Positions in [-1, size] whose ghost refresh resolves to value along one axis
+static int GhostPreimages(GridTopology topology, int value, int size, int *out)
+{
+    int count = 0;
+    out[count++] = value;
+    switch (topology)
+    {
+        case TOPOLOGY_TORUS:
+        {
+            if (value == size - 1) out[count++] = -1;
+            if (value == 0) out[count++] = size;
+        } break;
+        case TOPOLOGY_MIRROR:
+        {
+            if (value == 0) out[count++] = -1;
+            if (value == size - 1) out[count++] = size;
+        } break;
+        default: break;
+    }
+    return count;
+}
+
+// Grow a cell list to hold needed cells, never more than the board has
+static bool ReserveSparseCells(SparseLife *sparse, int64_t **list, int64_t *capacity, int64_t needed)
+{
+    int64_t cells = (int64_t)sparse->rows*sparse->cols;
+    if (needed > cells) needed = cells;
+    if (needed <= *capacity) return true;
+
+    int64_t grown = (*capacity > 0)? 2*(*capacity) : 1024;
+    while (grown < needed) grown *= 2;
+    if (grown > cells) grown = cells;
+
+    int64_t *cellList = realloc(*list, (size_t)grown*sizeof(int64_t));
+    if (cellList == NULL) return false;
+
+    *list = cellList;
+    *capacity = grown;
+    return true;
+}
+
+// Room in the pending list is reserved by the callers
+static void QueueCell(SparseLife *sparse, int64_t index)
+{
+    if (!sparse->queued[index])
+    {
+        sparse->queued[index] = 1;
+        sparse->pending[sparse->pendingCount++] = index;
+    }
+}
+
+// Queue a flipped cell and add its contribution to every cell that sees it through the ghost border
+// NOTE: On tiny torus boards a cell can see the same neighbour more than once, preimages
+// count every one of those views so counts match the bitwise kernel exactly
+static void CountFlip(SparseLife *sparse, int row, int col, bool alive)
+{
+    static const int offsets[8][2] = { { -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 }, { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } };
+    int delta = alive? 1 : -1;
+    int rowImages[3] = { 0 };
+    int colImages[3] = { 0 };
+    int rowCount = GhostPreimages(sparse->topology, row, sparse->rows, rowImages);
+    int colCount = GhostPreimages(sparse->topology, col, sparse->cols, colImages);
+
+    QueueCell(sparse, (int64_t)row*sparse->cols + col);
+
+    for (int r = 0; r < rowCount; r++)
+    {
+        for (int c = 0; c < colCount; c++)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                int neighbourRow = rowImages[r] - offsets[i][0];
+                int neighbourCol = colImages[c] - offsets[i][1];
+                if ((neighbourRow < 0) || (neighbourRow >= sparse->rows) || (neighbourCol < 0) || (neighbourCol >= sparse->cols)) continue;
+
+                int64_t index = (int64_t)neighbourRow*sparse->cols + neighbourCol;
+                sparse->counts[index] += delta;
+                QueueCell(sparse, index);
+            }
+        }
+    }
+}
+
+// Recount every cell through the ghost border, used on load and when topology changes
+// NOTE: Returns false when the pending list cannot grow to the active cells
+static bool RebuildSparseLife(SparseLife *sparse, LifeGrid *grid)
+{
+    sparse->topology = grid->topology;
+    RefreshGhostCells(grid);
+
+    memset(sparse->queued, 0, (size_t)sparse->rows*sparse->cols);
+    sparse->pendingCount = 0;
+
+    for (int row = 0; row < sparse->rows; row++)
+    {
+        if (!ReserveSparseCells(sparse, &sparse->pending, &sparse->pendingCapacity, sparse->pendingCount + sparse->cols)) return false;
+
+        for (int col = 0; col < sparse->cols; col++)
+        {
+            int count = 0;
+            for (int r = row - 1; r <= row + 1; r++)
+            {
+                for (int c = col - 1; c <= col + 1; c++)
+                {
+                    if (((r != row) || (c != col)) && GetLifeCell(*grid, r, c)) count++;
+                }
+            }
+
+            int64_t index = (int64_t)row*sparse->cols + col;
+            sparse->counts[index] = count;
+            if ((count > 0) || GetLifeCell(*grid, row, col)) QueueCell(sparse, index);
+        }
+    }
+
+    return true;
+}
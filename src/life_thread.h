@@ -0,0 +1,110 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Threads
+*
+*   The part of pthreads the threaded modules use: mutexes, condition variables, one time
+*   initialization, thread start and join, and the online core count from sysconf().
+*
+*   POSIX builds include pthreads as they are. Windows builds map the same calls onto slim
+*   reader/writer locks, condition variables, init once and _beginthreadex(), so the modules
+*   keep a single pthread code path.
+*
+*   NOTE: Only the calls and arguments the modules use are mapped: default attributes, no
+*   thread return values, no timed waits. Mutexes are not recursive.
+*
+**********************************************************************************************/
+
+#ifndef LIFE_THREAD_H
+#define LIFE_THREAD_H
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+    #include <process.h>
+    #include <stdlib.h>
+
+    #define PTHREAD_MUTEX_INITIALIZER SRWLOCK_INIT
+    #define PTHREAD_COND_INITIALIZER CONDITION_VARIABLE_INIT
+    #define PTHREAD_ONCE_INIT INIT_ONCE_STATIC_INIT
+    #define _SC_NPROCESSORS_ONLN 1
+
+    typedef HANDLE pthread_t;
+    typedef SRWLOCK pthread_mutex_t;
+    typedef CONDITION_VARIABLE pthread_cond_t;
+    typedef INIT_ONCE pthread_once_t;
+
+    typedef struct ThreadStart {
+        void *(*routine)(void *);
+        void *arg;
+    } ThreadStart;
+
+    static inline unsigned __stdcall RunThreadStart(void *data)
+    {
+        ThreadStart start = *(ThreadStart *)data;
+        free(data);
+        start.routine(start.arg);
+        return 0;
+    }
+
+    static inline BOOL CALLBACK RunThreadOnce(PINIT_ONCE once, PVOID routine, PVOID *context)
+    {
+        (void)once;
+        (void)context;
+        (*(void (**)(void))routine)();
+        return TRUE;
+    }
+
+    static inline int pthread_create(pthread_t *thread, const void *attributes, void *(*routine)(void *), void *arg)
+    {
+        (void)attributes;
+        ThreadStart *start = malloc(sizeof(ThreadStart));
+        if (start == NULL) return -1;
+
+        start->routine = routine;
+        start->arg = arg;
+        *thread = (HANDLE)_beginthreadex(NULL, 0, RunThreadStart, start, 0, NULL);
+        if (*thread == NULL)
+        {
+            free(start);
+            return -1;
+        }
+        return 0;
+    }
+
+    static inline int pthread_join(pthread_t thread, void **result)
+    {
+        if (result != NULL) *result = NULL;
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+        return 0;
+    }
+
+    // The routine is passed by address, a function pointer does not convert to PVOID
+    static inline int pthread_once(pthread_once_t *once, void (*routine)(void))
+    {
+        return InitOnceExecuteOnce(once, RunThreadOnce, (PVOID)&routine, NULL)? 0 : -1;
+    }
+
+    static inline int pthread_mutex_init(pthread_mutex_t *mutex, const void *attributes) { (void)attributes; InitializeSRWLock(mutex); return 0; }
+    static inline int pthread_mutex_destroy(pthread_mutex_t *mutex) { (void)mutex; return 0; }
+    static inline int pthread_mutex_lock(pthread_mutex_t *mutex) { AcquireSRWLockExclusive(mutex); return 0; }
+    static inline int pthread_mutex_unlock(pthread_mutex_t *mutex) { ReleaseSRWLockExclusive(mutex); return 0; }
+
+    static inline int pthread_cond_init(pthread_cond_t *cond, const void *attributes) { (void)attributes; InitializeConditionVariable(cond); return 0; }
+    static inline int pthread_cond_destroy(pthread_cond_t *cond) { (void)cond; return 0; }
+    static inline int pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex) { return SleepConditionVariableSRW(cond, mutex, INFINITE, 0)? 0 : -1; }
+    static inline int pthread_cond_signal(pthread_cond_t *cond) { WakeConditionVariable(cond); return 0; }
+    static inline int pthread_cond_broadcast(pthread_cond_t *cond) { WakeAllConditionVariable(cond); return 0; }
+
+    static inline long sysconf(int name)
+    {
+        (void)name;
+        return (long)GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+    }
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+#endif // LIFE_THREAD_H
@@ -0,0 +1,783 @@
+/**********************************************************************************************
+*
+*   cgameoflife - Generation trace
+*
+*   Streams every generation of a run to disk and reads any of them back.
+*
+*   A trace is a header followed by blocks of records. A record is either a keyframe with
+*   every cell or a delta listing the 64x64 tiles that changed, XORed against the previous
+*   generation. Every keyframe interval a keyframe starts a new block, so seeking decodes at
+*   most one interval. Blocks are compressed with a zero run-length code that suits XOR
+*   deltas, and an index of keyframe blocks is appended when the trace is closed.
+*
+*   The simulation thread only copies the tiles holding words the grid marked as changed to
+*   one of two block buffers. A background thread XORs them against the generation before,
+*   drops the tiles that came out unchanged, then compresses and writes the other buffer.
+*
+*   NOTE: Words are stored in host byte order, traces move between little-endian hosts only.
+*
+**********************************************************************************************/
+
+#include "life.h"
+#include "life_thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define TRACE_VERSION 1
+#define TRACE_BLOCK_BYTES (1 << 20)     // Raw block size that closes a block early
+#define TRACE_TILE_ROWS 64              // Tiles are one word wide and 64 rows high
+#define TRACE_KEYFRAME 'K'
+#define TRACE_DELTA 'D'
+
+static const char traceMagic[8] = { 'G', 'O', 'L', 'T', 'R', 'A', 'C', 'E' };
+static const char indexMagic[8] = { 'G', 'O', 'L', 'I', 'N', 'D', 'E', 'X' };
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct TraceBuffer {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+    bool failed;            // Allocation failed, contents are incomplete
+} TraceBuffer;
+
+// Stored before every block
+typedef struct TraceBlockHeader {
+    uint32_t firstGeneration;
+    uint32_t records;
+    uint32_t rawSize;
+    uint32_t packedSize;
+    uint32_t keyframe;      // Block starts with a keyframe
+} TraceBlockHeader;
+
+typedef struct TraceIndexEntry {
+    int64_t generation;
+    int64_t offset;
+} TraceIndexEntry;
+
+struct LifeTrace {
+    FILE *file;
+    int rows;
+    int cols;
+    int words;              // Words per row, ghost words dropped
+    int keyframeInterval;
+    int generation;         // Last recorded generation
+    uint64_t *changes;      // Changes kept over from grids cleared since the last record, rows*LIFE_CHANGE_STRIDE words
+
+    TraceBuffer blocks[2];  // Double buffer, one filled here while the other is written
+    int filling;
+    TraceBlockHeader header;
+
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t blockReady;
+    pthread_cond_t blockWritten;
+    bool pending;           // Writer owns the other buffer
+    TraceBlockHeader pendingHeader;
+    bool closing;
+    bool failed;
+    bool writeFailed;       // Copy of failed for the simulation thread
+
+    uint64_t *previous;     // Cells of the last generation written, rows*words, writer thread only
+    TraceBuffer diffed;     // Block with deltas XORed, writer thread only
+    TraceBuffer packed;     // Compression scratch, writer thread only
+    TraceIndexEntry *index; // Keyframe blocks, writer thread only until closed
+    int indexCount;
+    int indexCapacity;
+};
+
+struct LifeTraceReader {
+    FILE *file;
+    TraceInfo info;
+    int words;
+    TraceIndexEntry *index;
+    int indexCount;
+
+    uint64_t *state;        // Cells of generation stateGeneration, rows*words
+    int stateGeneration;    // -1 before the first record
+    int64_t nextBlock;      // Offset of the block after the decoded one
+    TraceBuffer raw;        // Decoded block
+    size_t cursor;          // Next record in raw
+    int recordsLeft;
+    TraceBuffer packed;
+};
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static void *TraceWriterMain(void *arg);
+static void AppendRecord(LifeTrace *trace, LifeGrid grid, bool keyframe);
+static bool SubmitBlock(LifeTrace *trace);
+static bool DiffBlock(LifeTrace *trace, const TraceBuffer *block, int records);
+static void PackZeroRuns(const unsigned char *data, size_t size, TraceBuffer *out);
+static bool UnpackZeroRuns(const unsigned char *data, size_t size, TraceBuffer *out, size_t expected);
+static bool ReadBlock(LifeTraceReader *reader, int64_t offset);
+static bool ApplyRecord(LifeTraceReader *reader);
+static bool BuildTraceIndex(LifeTraceReader *reader);
+
+static void AppendBytes(TraceBuffer *buffer, const void *data, size_t size);
+static void AppendVarint(TraceBuffer *buffer, uint64_t value);
+static bool ReadVarint(const unsigned char *data, size_t size, size_t *cursor, uint64_t *value);
+static inline int TrailingZeros(uint64_t bits);
+
+//----------------------------------------------------------------------------------
+// Trace Writer Functions Definition
+//----------------------------------------------------------------------------------
+
+// Create the file, record the grid as a keyframe of generation and start the writer thread
+// NOTE: Returns NULL when the file or buffers can not be created
+LifeTrace *OpenLifeTrace(const char *path, LifeGrid grid, int generation, int keyframeInterval)
+{
+    LifeTrace *trace = calloc(1, sizeof(LifeTrace));
+    if (trace == NULL) return NULL;
+
+    trace->rows = grid.rows;
+    trace->cols = grid.cols;
+    trace->words = (grid.cols + 63)/64;
+    trace->keyframeInterval = (keyframeInterval > 0)? keyframeInterval : 1;
+    trace->generation = generation;
+    trace->previous = calloc((size_t)trace->rows*trace->words, sizeof(uint64_t));
+    trace->changes = calloc((size_t)trace->rows*LIFE_CHANGE_STRIDE(grid), sizeof(uint64_t));
+    trace->file = fopen(path, "wb");
+    if ((trace->previous == NULL) || (trace->changes == NULL) || (trace->file == NULL))
+    {
+        if (trace->file != NULL) fclose(trace->file);
+        free(trace->previous);
+        free(trace->changes);
+        free(trace);
+        return NULL;
+    }
+
+    uint32_t header[5] = { TRACE_VERSION, (uint32_t)trace->rows, (uint32_t)trace->cols, (uint32_t)trace->keyframeInterval, (uint32_t)generation };
+    if ((fwrite(traceMagic, 1, sizeof(traceMagic), trace->file) != sizeof(traceMagic)) ||
+        (fwrite(header, sizeof(uint32_t), 5, trace->file) != 5)) trace->failed = true;
+
+    pthread_mutex_init(&trace->lock, NULL);
+    pthread_cond_init(&trace->blockReady, NULL);
+    pthread_cond_init(&trace->blockWritten, NULL);
+    if (pthread_create(&trace->writer, NULL, TraceWriterMain, trace) != 0)
+    {
+        fclose(trace->file);
+        pthread_mutex_destroy(&trace->lock);
+        pthread_cond_destroy(&trace->blockReady);
+        pthread_cond_destroy(&trace->blockWritten);
+        free(trace->previous);
+        free(trace->changes);
+        free(trace);
+        return NULL;
+    }
+
+    trace->header.firstGeneration = (uint32_t)generation;
+    trace->header.keyframe = 1;
+    AppendRecord(trace, grid, true);
+
+    return trace;
+}
+
+// Record the grid as the next generation, returns false once writing failed
+// NOTE: Only tiles holding words marked in grid.changes are passed on, grids that do not track changes pass all of them
+bool AppendLifeTrace(LifeTrace *trace, LifeGrid grid)
+{
+    trace->generation++;
+
+    // Keyframes start their own block so seeking never reads back past one
+    bool keyframe = (trace->generation%trace->keyframeInterval) == 0;
+    TraceBuffer *block = &trace->blocks[trace->filling];
+    if (keyframe || (block->size >= TRACE_BLOCK_BYTES))
+    {
+        if (!SubmitBlock(trace)) return false;
+        trace->header.firstGeneration = (uint32_t)trace->generation;
+        trace->header.keyframe = keyframe;
+    }
+    AppendRecord(trace, grid, keyframe);
+
+    return !trace->writeFailed && !trace->blocks[trace->filling].failed;
+}
+
+// Keep the changes marked on grid for the next record, for owners clearing them between records
+void KeepLifeTraceChanges(LifeTrace *trace, LifeGrid grid)
+{
+    if (grid.changes == NULL) return;
+
+    size_t count = (size_t)trace->rows*LIFE_CHANGE_STRIDE(grid);
+    for (size_t i = 0; i < count; i++) trace->changes[i] |= grid.changes[i];
+}
+
+// Flush the last block, write the keyframe index and close the file
+bool CloseLifeTrace(LifeTrace *trace)
+{
+    if (trace == NULL) return false;
+
+    SubmitBlock(trace);
+    pthread_mutex_lock(&trace->lock);
+    trace->closing = true;
+    pthread_cond_signal(&trace->blockReady);
+    pthread_mutex_unlock(&trace->lock);
+    pthread_join(trace->writer, NULL);
+
+    // Index goes last: entries, then its offset and size so readers find it from the end
+    int64_t indexOffset = ftell(trace->file);
+    uint32_t count = (uint32_t)trace->indexCount;
+    if ((fwrite(trace->index, sizeof(TraceIndexEntry), trace->indexCount, trace->file) != (size_t)trace->indexCount) ||
+        (fwrite(indexMagic, 1, sizeof(indexMagic), trace->file) != sizeof(indexMagic)) ||
+        (fwrite(&indexOffset, sizeof(indexOffset), 1, trace->file) != 1) ||
+        (fwrite(&count, sizeof(count), 1, trace->file) != 1)) trace->failed = true;
+    if (fclose(trace->file) != 0) trace->failed = true;
+
+    bool succeeded = !trace->failed;
+    for (int i = 0; i < 2; i++) free(trace->blocks[i].data);
+    free(trace->diffed.data);
+    free(trace->packed.data);
+    free(trace->index);
+    free(trace->previous);
+    free(trace->changes);
+    pthread_mutex_destroy(&trace->lock);
+    pthread_cond_destroy(&trace->blockReady);
+    pthread_cond_destroy(&trace->blockWritten);
+    free(trace);
+
+    return succeeded;
+}
+
+//----------------------------------------------------------------------------------
+// Trace Reader Functions Definition
+//----------------------------------------------------------------------------------
+
+// Open a trace and load its keyframe index, NULL if it is not a readable trace
+LifeTraceReader *OpenLifeTraceReader(const char *path)
+{
+    LifeTraceReader *reader = calloc(1, sizeof(LifeTraceReader));
+    if (reader == NULL) return NULL;
+
+    reader->file = fopen(path, "rb");
+    char magic[8] = { 0 };
+    uint32_t header[5] = { 0 };
+    bool loaded = (reader->file != NULL) && (fread(magic, 1, sizeof(magic), reader->file) == sizeof(magic)) &&
+        (memcmp(magic, traceMagic, sizeof(magic)) == 0) && (fread(header, sizeof(uint32_t), 5, reader->file) == 5) &&
+        (header[0] == TRACE_VERSION);
+
+    if (loaded)
+    {
+        reader->info.rows = (int)header[1];
+        reader->info.cols = (int)header[2];
+        reader->info.keyframeInterval = (int)header[3];
+        reader->info.firstGeneration = (int)header[4];
+        reader->words = (reader->info.cols + 63)/64;
+        reader->state = calloc((size_t)reader->info.rows*reader->words, sizeof(uint64_t));
+        reader->stateGeneration = -1;
+        loaded = (reader->state != NULL) && BuildTraceIndex(reader);
+    }
+    if (!loaded)
+    {
+        CloseLifeTraceReader(reader);
+        return NULL;
+    }
+
+    return reader;
+}
+
+void CloseLifeTraceReader(LifeTraceReader *reader)
+{
+    if (reader == NULL) return;
+    if (reader->file != NULL) fclose(reader->file);
+    free(reader->index);
+    free(reader->state);
+    free(reader->raw.data);
+    free(reader->packed.data);
+    free(reader);
+}
+
+TraceInfo GetLifeTraceInfo(const LifeTraceReader *reader)
+{
+    return reader->info;
+}
+
+// Load the cells of any recorded generation into a grid of the trace size
+// NOTE: Reading forward continues from the current position, anything else restarts at the nearest keyframe
+bool SeekLifeTrace(LifeTraceReader *reader, int generation, LifeGrid *grid)
+{
+    if ((generation < reader->info.firstGeneration) || (generation > reader->info.lastGeneration)) return false;
+    if ((grid->rows != reader->info.rows) || (grid->cols != reader->info.cols)) return false;
+
+    int64_t keyframe = reader->index[0].offset;
+    int64_t keyframeGeneration = reader->index[0].generation;
+    for (int i = 0; (i < reader->indexCount) && (reader->index[i].generation <= generation); i++)
+    {
+        keyframe = reader->index[i].offset;
+        keyframeGeneration = reader->index[i].generation;
+    }
+
+    bool forward = (reader->stateGeneration >= keyframeGeneration) && (reader->stateGeneration <= generation);
+    if (!forward && !ReadBlock(reader, keyframe)) return false;
+
+    while (reader->stateGeneration < generation)
+    {
+        if ((reader->recordsLeft == 0) && !ReadBlock(reader, reader->nextBlock)) return false;
+        if (!ApplyRecord(reader)) return false;
+    }
+
+    for (int row = 0; row < grid->rows; row++)
+    {
+        uint64_t *cells = LIFE_ROW(*grid, grid->cells, row);
+        memcpy(cells + 1, reader->state + (size_t)row*reader->words, reader->words*sizeof(uint64_t));
+        for (int w = 1 + reader->words; w < grid->stride; w++) cells[w] = 0;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+static void *TraceWriterMain(void *arg)
+{
+    LifeTrace *trace = (LifeTrace *)arg;
+
+    pthread_mutex_lock(&trace->lock);
+    for (;;)
+    {
+        while (!trace->pending && !trace->closing) pthread_cond_wait(&trace->blockReady, &trace->lock);
+        if (!trace->pending) break;
+
+        TraceBlockHeader header = trace->pendingHeader;
+        TraceBuffer *block = &trace->blocks[1 - trace->filling];
+        pthread_mutex_unlock(&trace->lock);
+
+        bool diffed = !block->failed && DiffBlock(trace, block, (int)header.records);
+        header.rawSize = (uint32_t)trace->diffed.size;
+        trace->packed.size = 0;
+        PackZeroRuns(trace->diffed.data, trace->diffed.size, &trace->packed);
+        header.packedSize = (uint32_t)trace->packed.size;
+
+        int64_t offset = ftell(trace->file);
+        bool written = diffed && !trace->packed.failed &&
+            (fwrite(&header, sizeof(header), 1, trace->file) == 1) &&
+            (fwrite(trace->packed.data, 1, trace->packed.size, trace->file) == trace->packed.size);
+
+        if (written && header.keyframe)
+        {
+            if (trace->indexCount == trace->indexCapacity)
+            {
+                int capacity = (trace->indexCapacity > 0)? trace->indexCapacity*2 : 64;
+                TraceIndexEntry *grown = realloc(trace->index, capacity*sizeof(TraceIndexEntry));
+                if (grown == NULL) written = false;
+                else
+                {
+                    trace->index = grown;
+                    trace->indexCapacity = capacity;
+                }
+            }
+            if (written) trace->index[trace->indexCount++] = (TraceIndexEntry){ header.firstGeneration, offset };
+        }
+
+        pthread_mutex_lock(&trace->lock);
+        if (!written) trace->failed = true;
+        trace->pending = false;
+        pthread_cond_signal(&trace->blockWritten);
+    }
+    pthread_mutex_unlock(&trace->lock);
+
+    return NULL;
+}
+
+// Append the grid to the filling block, every cell for keyframes or the tiles holding marked words as they are now
+static void AppendRecord(LifeTrace *trace, LifeGrid grid, bool keyframe)
+{
+    TraceBuffer *block = &trace->blocks[trace->filling];
+    uint64_t lastMask = (trace->cols%64 == 0)? ~0ULL : ((1ULL << (trace->cols%64)) - 1);
+    int tileRows = (trace->rows + TRACE_TILE_ROWS - 1)/TRACE_TILE_ROWS;
+    int changeStride = LIFE_CHANGE_STRIDE(grid);
+    uint64_t tile[TRACE_TILE_ROWS] = { 0 };
+
+    unsigned char tag = keyframe? TRACE_KEYFRAME : TRACE_DELTA;
+    AppendBytes(block, &tag, 1);
+    if (keyframe)
+    {
+        for (int row = 0; row < trace->rows; row++)
+        {
+            const uint64_t *cells = LIFE_ROW(grid, grid.cells, row) + 1;
+            uint64_t last = cells[trace->words - 1] & lastMask;
+            AppendBytes(block, cells, (trace->words - 1)*sizeof(uint64_t));
+            AppendBytes(block, &last, sizeof(last));
+        }
+    }
+
+    // Tile count is only known after the walk, so deltas reserve it and patch it
+    size_t countAt = block->size;
+    uint32_t tiles = 0;
+    if (!keyframe) AppendBytes(block, &tiles, sizeof(tiles));
+
+    int64_t lastTile = -1;
+    for (int tileRow = 0; !keyframe && (tileRow < tileRows); tileRow++)
+    {
+        int firstRow = tileRow*TRACE_TILE_ROWS;
+        int lastRow = (firstRow + TRACE_TILE_ROWS < trace->rows)? firstRow + TRACE_TILE_ROWS : trace->rows;
+
+        // Tiles are one word wide, a tile is passed on when its word is marked in any of its rows
+        for (int k = 0; k < changeStride; k++)
+        {
+            uint64_t changed = (grid.changes == NULL)? ~0ULL : 0;
+            for (int row = firstRow; (row < lastRow) && (grid.changes != NULL); row++)
+            {
+                size_t at = (size_t)row*changeStride + k;
+                changed |= grid.changes[at] | trace->changes[at];
+            }
+
+            for (; changed != 0; changed &= changed - 1)
+            {
+                int w = 64*k + TrailingZeros(changed);
+                if (w >= trace->words) break;
+
+                uint64_t mask = (w == trace->words - 1)? lastMask : ~0ULL;
+                for (int row = firstRow; row < lastRow; row++) tile[row - firstRow] = LIFE_ROW(grid, grid.cells, row)[1 + w] & mask;
+
+                int64_t index = (int64_t)tileRow*trace->words + w;
+                AppendVarint(block, (uint64_t)(index - lastTile));
+                AppendBytes(block, tile, (lastRow - firstRow)*sizeof(uint64_t));
+                lastTile = index;
+                tiles++;
+            }
+        }
+    }
+
+    if (!keyframe && !block->failed) memcpy(block->data + countAt, &tiles, sizeof(tiles));
+    memset(trace->changes, 0, (size_t)trace->rows*changeStride*sizeof(uint64_t));
+    trace->header.records++;
+}
+
+// Hand the filling block to the writer thread, waiting while it still writes the other one
+static bool SubmitBlock(LifeTrace *trace)
+{
+    TraceBuffer *block = &trace->blocks[trace->filling];
+    if (trace->header.records == 0) return true;
+
+    pthread_mutex_lock(&trace->lock);
+    while (trace->pending) pthread_cond_wait(&trace->blockWritten, &trace->lock);
+    trace->header.rawSize = (uint32_t)block->size;
+    trace->pendingHeader = trace->header;
+    trace->pending = true;
+    trace->filling = 1 - trace->filling;
+    trace->writeFailed = trace->failed;
+    pthread_cond_signal(&trace->blockReady);
+    pthread_mutex_unlock(&trace->lock);
+
+    trace->blocks[trace->filling].size = 0;
+    trace->blocks[trace->filling].failed = false;
+    trace->header = (TraceBlockHeader){ 0 };
+
+    return !trace->writeFailed;
+}
+
+// Turn the records of a block into the stored ones: delta tiles XORed against the generation before, unchanged ones dropped
+// NOTE: Writer thread only, false on a malformed block or when out of memory
+static bool DiffBlock(LifeTrace *trace, const TraceBuffer *block, int records)
+{
+    const unsigned char *data = block->data;
+    size_t size = block->size;
+    size_t cursor = 0;
+    size_t stateSize = (size_t)trace->rows*trace->words*sizeof(uint64_t);
+    TraceBuffer *out = &trace->diffed;
+    out->size = 0;
+    out->failed = false;
+
+    for (int record = 0; record < records; record++)
+    {
+        if (cursor >= size) return false;
+        unsigned char tag = data[cursor++];
+        AppendBytes(out, &tag, 1);
+        if (tag == TRACE_KEYFRAME)
+        {
+            if (size - cursor < stateSize) return false;
+            memcpy(trace->previous, data + cursor, stateSize);
+            AppendBytes(out, data + cursor, stateSize);
+            cursor += stateSize;
+            continue;
+        }
+
+        uint32_t tiles = 0;
+        uint32_t changedTiles = 0;
+        if (size - cursor < sizeof(tiles)) return false;
+        memcpy(&tiles, data + cursor, sizeof(tiles));
+        cursor += sizeof(tiles);
+        size_t countAt = out->size;
+        AppendBytes(out, &changedTiles, sizeof(changedTiles));
+
+        int64_t tile = -1;
+        int64_t lastTile = -1;
+        for (uint32_t i = 0; i < tiles; i++)
+        {
+            uint64_t step = 0;
+            if (!ReadVarint(data, size, &cursor, &step)) return false;
+            tile += (int64_t)step;
+
+            int firstRow = (int)(tile/trace->words)*TRACE_TILE_ROWS;
+            int w = (int)(tile%trace->words);
+            int lastRow = (firstRow + TRACE_TILE_ROWS < trace->rows)? firstRow + TRACE_TILE_ROWS : trace->rows;
+            if ((firstRow >= trace->rows) || (size - cursor < (size_t)(lastRow - firstRow)*sizeof(uint64_t))) return false;
+
+            uint64_t diff[TRACE_TILE_ROWS] = { 0 };
+            bool changed = false;
+            for (int row = firstRow; row < lastRow; row++)
+            {
+                uint64_t word = 0;
+                memcpy(&word, data + cursor, sizeof(word));
+                cursor += sizeof(word);
+
+                uint64_t *seen = &trace->previous[(size_t)row*trace->words + w];
+                diff[row - firstRow] = word ^ *seen;
+                changed |= (word != *seen);
+                *seen = word;
+            }
+            if (!changed) continue;
+
+            AppendVarint(out, (uint64_t)(tile - lastTile));
+            AppendBytes(out, diff, (lastRow - firstRow)*sizeof(uint64_t));
+            lastTile = tile;
+            changedTiles++;
+        }
+        if (!out->failed) memcpy(out->data + countAt, &changedTiles, sizeof(changedTiles));
+    }
+
+    return !out->failed;
+}
+
+// Alternating literal and zero runs: varint literal count, the literals, varint zero count
+static void PackZeroRuns(const unsigned char *data, size_t size, TraceBuffer *out)
+{
+    size_t i = 0;
+    while (i < size)
+    {
+        // Literals end at the first run of at least four zeros
+        size_t start = i;
+        size_t zeros = 0;
+        while (i < size)
+        {
+            zeros = (data[i] == 0)? zeros + 1 : 0;
+            i++;
+            if (zeros == 4) break;
+        }
+        size_t literals = i - start - zeros;
+        while ((i < size) && (data[i] == 0))
+        {
+            zeros++;
+            i++;
+        }
+
+        AppendVarint(out, literals);
+        AppendBytes(out, data + start, literals);
+        AppendVarint(out, zeros);
+    }
+}
+
+static bool UnpackZeroRuns(const unsigned char *data, size_t size, TraceBuffer *out, size_t expected)
+{
+    out->size = 0;
+    out->failed = false;
+    size_t cursor = 0;
+    while (cursor < size)
+    {
+        uint64_t literals = 0;
+        uint64_t zeros = 0;
+        if (!ReadVarint(data, size, &cursor, &literals) || (literals > size - cursor)) return false;
+        AppendBytes(out, data + cursor, literals);
+        cursor += literals;
+        if (!ReadVarint(data, size, &cursor, &zeros) || (out->size + zeros > expected)) return false;
+
+        static const unsigned char zeroChunk[256] = { 0 };
+        while (zeros > 0)
+        {
+            size_t chunk = (zeros < sizeof(zeroChunk))? zeros : sizeof(zeroChunk);
+            AppendBytes(out, zeroChunk, chunk);
+            zeros -= chunk;
+        }
+    }
+    return !out->failed && (out->size == expected);
+}
+
+// Decode the block at offset, the first record starts a keyframe when the block has one
+static bool ReadBlock(LifeTraceReader *reader, int64_t offset)
+{
+    TraceBlockHeader header = { 0 };
+    if ((fseek(reader->file, (long)offset, SEEK_SET) != 0) || (fread(&header, sizeof(header), 1, reader->file) != 1)) return false;
+
+    if (header.packedSize > reader->packed.capacity)
+    {
+        unsigned char *grown = realloc(reader->packed.data, header.packedSize);
+        if (grown == NULL) return false;
+        reader->packed.data = grown;
+        reader->packed.capacity = header.packedSize;
+    }
+    if (fread(reader->packed.data, 1, header.packedSize, reader->file) != header.packedSize) return false;
+    if (!UnpackZeroRuns(reader->packed.data, header.packedSize, &reader->raw, header.rawSize)) return false;
+
+    reader->cursor = 0;
+    reader->recordsLeft = (int)header.records;
+    reader->nextBlock = offset + (int64_t)sizeof(header) + header.packedSize;
+    if (header.keyframe) reader->stateGeneration = (int)header.firstGeneration - 1;
+    return true;
+}
+
+// Apply the next record of the decoded block to the state
+static bool ApplyRecord(LifeTraceReader *reader)
+{
+    const unsigned char *data = reader->raw.data;
+    size_t size = reader->raw.size;
+    size_t stateSize = (size_t)reader->info.rows*reader->words*sizeof(uint64_t);
+    if (reader->cursor >= size) return false;
+
+    unsigned char tag = data[reader->cursor++];
+    if (tag == TRACE_KEYFRAME)
+    {
+        if (size - reader->cursor < stateSize) return false;
+        memcpy(reader->state, data + reader->cursor, stateSize);
+        reader->cursor += stateSize;
+    }
+    else
+    {
+        // A delta is only meaningful on top of the generation before it
+        uint32_t changedTiles = 0;
+        if ((reader->stateGeneration < 0) || (size - reader->cursor < sizeof(changedTiles))) return false;
+        memcpy(&changedTiles, data + reader->cursor, sizeof(changedTiles));
+        reader->cursor += sizeof(changedTiles);
+
+        int64_t tile = -1;
+        for (uint32_t i = 0; i < changedTiles; i++)
+        {
+            uint64_t step = 0;
+            if (!ReadVarint(data, size, &reader->cursor, &step)) return false;
+            tile += (int64_t)step;
+
+            int tileRow = (int)(tile/reader->words);
+            int w = (int)(tile%reader->words);
+            int firstRow = tileRow*TRACE_TILE_ROWS;
+            int lastRow = (firstRow + TRACE_TILE_ROWS < reader->info.rows)? firstRow + TRACE_TILE_ROWS : reader->info.rows;
+            if ((firstRow >= reader->info.rows) || (size - reader->cursor < (size_t)(lastRow - firstRow)*sizeof(uint64_t))) return false;
+
+            for (int row = firstRow; row < lastRow; row++)
+            {
+                uint64_t diff = 0;
+                memcpy(&diff, data + reader->cursor, sizeof(diff));
+                reader->cursor += sizeof(diff);
+                reader->state[(size_t)row*reader->words + w] ^= diff;
+            }
+        }
+    }
+
+    reader->stateGeneration++;
+    reader->recordsLeft--;
+    return true;
+}
+
+// Load the index written on close, or rebuild it from the block headers of an unfinished trace
+static bool BuildTraceIndex(LifeTraceReader *reader)
+{
+    int64_t dataStart = (int64_t)sizeof(traceMagic) + 5*sizeof(uint32_t);
+    int64_t dataEnd = 0;
+    char magic[8] = { 0 };
+    int64_t indexOffset = 0;
+    uint32_t count = 0;
+    int64_t trailer = (int64_t)sizeof(magic) + sizeof(indexOffset) + sizeof(count);
+
+    if ((fseek(reader->file, -(long)trailer, SEEK_END) == 0) && (fread(magic, 1, sizeof(magic), reader->file) == sizeof(magic)) &&
+        (memcmp(magic, indexMagic, sizeof(magic)) == 0) && (fread(&indexOffset, sizeof(indexOffset), 1, reader->file) == 1) &&
+        (fread(&count, sizeof(count), 1, reader->file) == 1) && (count > 0))
+    {
+        reader->index = malloc(count*sizeof(TraceIndexEntry));
+        if ((reader->index == NULL) || (fseek(reader->file, (long)indexOffset, SEEK_SET) != 0) ||
+            (fread(reader->index, sizeof(TraceIndexEntry), count, reader->file) != count)) return false;
+        reader->indexCount = (int)count;
+        dataEnd = indexOffset;
+    }
+
+    // Walk the block headers: from the last keyframe to find the last generation, or all of them without an index
+    int64_t offset = (reader->indexCount > 0)? reader->index[reader->indexCount - 1].offset : dataStart;
+    int indexCapacity = reader->indexCount;
+    for (;;)
+    {
+        TraceBlockHeader header = { 0 };
+        if ((dataEnd > 0) && (offset >= dataEnd)) break;
+        if ((fseek(reader->file, (long)offset, SEEK_SET) != 0) || (fread(&header, sizeof(header), 1, reader->file) != 1)) break;
+
+        // An unfinished trace may end inside a block, only whole blocks count
+        if ((header.packedSize == 0) || (fseek(reader->file, (long)header.packedSize - 1, SEEK_CUR) != 0) || (fgetc(reader->file) == EOF)) break;
+
+        if (header.keyframe && ((reader->indexCount == 0) || (reader->index[reader->indexCount - 1].offset < offset)))
+        {
+            if (reader->indexCount == indexCapacity)
+            {
+                indexCapacity = (indexCapacity > 0)? indexCapacity*2 : 64;
+                TraceIndexEntry *grown = realloc(reader->index, indexCapacity*sizeof(TraceIndexEntry));
+                if (grown == NULL) return false;
+                reader->index = grown;
+            }
+            reader->index[reader->indexCount++] = (TraceIndexEntry){ header.firstGeneration, offset };
+        }
+        reader->info.lastGeneration = (int)(header.firstGeneration + header.records - 1);
+        offset += (int64_t)sizeof(header) + header.packedSize;
+    }
+
+    return reader->indexCount > 0;
+}
+
+static void AppendBytes(TraceBuffer *buffer, const void *data, size_t size)
+{
+    if (buffer->failed) return;
+    if (buffer->size + size > buffer->capacity)
+    {
+        size_t capacity = (buffer->capacity > 0)? buffer->capacity : 4096;
+        while (capacity < buffer->size + size) capacity *= 2;
+        unsigned char *grown = realloc(buffer->data, capacity);
+        if (grown == NULL)
+        {
+            buffer->failed = true;
+            return;
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    if (size > 0) memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+}
+
+// LEB128, seven bits per byte
+static void AppendVarint(TraceBuffer *buffer, uint64_t value)
+{
+    unsigned char bytes[10] = { 0 };
+    int count = 0;
+    do
+    {
+        bytes[count] = (unsigned char)(value & 0x7F);
+        value >>= 7;
+        if (value != 0) bytes[count] |= 0x80;
+        count++;
+    } while (value != 0);
+    AppendBytes(buffer, bytes, count);
+}
+
+static bool ReadVarint(const unsigned char *data, size_t size, size_t *cursor, uint64_t *value)
+{
+    *value = 0;
+    for (int shift = 0; (shift < 64) && (*cursor < size); shift += 7)
+    {
+        unsigned char byte = data[(*cursor)++];
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static inline int TrailingZeros(uint64_t bits)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int count = 0;
+    while (!(bits & 1)) { bits >>= 1; count++; }
+    return count;
+#endif
+}
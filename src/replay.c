@@ -0,0 +1,75 @@
+/*******************************************************************************************
+*
+*   cgameoflife replay - Headless replay of a recorded session on libgol
+*
+*   Loads a journal recorded by the gameplay screen and runs it on a fresh universe as fast
+*   as it goes, printing the time per recorded frame. Replays of the same journal step the
+*   same cells, so a session turns into a benchmark that can be rerun after every change.
+*   No window or GL context is needed.
+*
+*   Usage: replay [file] [runs] [threads]
+*
+*       file        Journal to replay, "session.journal" by default
+*       runs        Times to replay it, 3 by default, the best run is kept
+*       threads     Threads used by the parallel engines, 0 (default) uses every core
+*
+********************************************************************************************/
+
+#include "gol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//----------------------------------------------------------------------------------
+// Program main entry point
+//----------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    const char *fileName = (argc > 1)? argv[1] : "session.journal";
+    int runs = (argc > 2)? atoi(argv[2]) : 3;
+    if (argc > 3) SetParallelWorkers(atoi(argv[3]));
+
+    LifeJournal *journal = LoadLifeJournalFile(fileName);
+    if ((journal == NULL) || (runs <= 0))
+    {
+        fprintf(stderr, "replay: unable to load a journal from %s\n", fileName);
+        return 1;
+    }
+
+    JournalInfo info = GetLifeJournalInfo(journal);
+    printf("replay: %dx%d, %d events over %lld frames, %lld generations, %zu bytes, %d threads\n", info.rows, info.cols,
+        info.events, (long long)info.frames, (long long)info.generations, info.bytes, GetParallelWorkers());
+
+    JournalReplay best = { 0 };
+    int64_t population = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        JournalReplay replay = ReplayUniverseJournal(journal);
+        if (!replay.replayed)
+        {
+            fprintf(stderr, "replay: run %d stopped after %d events\n", run + 1, replay.events);
+            UnloadLifeJournal(journal);
+            CloseParallelWorkers();
+            return 1;
+        }
+        if (run == 0) population = replay.population;
+        else if (replay.population != population)
+        {
+            fprintf(stderr, "replay: run %d ended with %lld live cells instead of %lld\n", run + 1,
+                (long long)replay.population, (long long)population);
+        }
+
+        printf("run %-3d %10.3f s  %8.3f s stepping  %10.1f gen/s  population %lld\n", run + 1, replay.seconds, replay.stepSeconds,
+            replay.generations/((replay.stepSeconds > 0.0)? replay.stepSeconds : 1e-9), (long long)replay.population);
+        if ((run == 0) || (replay.seconds < best.seconds)) best = replay;
+    }
+
+    printf("frames: %d with events, %d inputs\n", best.frames, best.inputs);
+    printf("frame ms: mean %.3f  median %.3f  p99 %.3f  max %.3f\n", best.frameMean*1000.0, best.frameMedian*1000.0,
+        best.frameP99*1000.0, best.frameMax*1000.0);
+
+    UnloadLifeJournal(journal);
+    CloseParallelWorkers();
+
+    return 0;
+}
@@ -25,6 +25,8 @@
 
 #include "raylib.h"
 #include "screens.h"
+#include "gol.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -33,10 +35,12 @@
 //----------------------------------------------------------------------------------
 #define MIN_GAMESPEED 1
 #define MAX_GAMESPEED 40
-#define GRID_ROWS 50
-#define GRID_COLS 100
+#define GRID_ROWS 500
+#define GRID_COLS 1000
+#define MAX_CELL_ZOOM 64.0f     // Largest cell size in pixels
+#define MIN_GAP_ZOOM 4.0f       // Smallest cell size in pixels that still shows gaps
+#define MAX_SHOWN_MATCHES 4096  // Search matches highlighted, the HUD still counts them all
 const int TARGET_FPS = 60;
-const bool INFINITE_GRID = false;
 
 //----------------------------------------------------------------------------------
 // Module Variables Definition (local)
@@ -57,21 +61,325 @@ static int paddingTop = 100;
 static int paddingBottom = 50;
 static int paddingLeft = 50;
 static int paddingRight = 50;
+static GridTopology topology = TOPOLOGY_DEAD_EDGE;
 
-typedef enum CellStatus { DEAD = 0, ALIVE } CellStatus;
-struct Cell
-{
-    CellStatus status;
-    struct Rectangle outerRec;
-    struct Rectangle innerRec;
-    int border;
+// Simulation engine
+static LifeEngine engine = ENGINE_BITWISE;
+static int generationsRuleIndex = 0;
+static int largerRuleIndex = 0;
+static int isotropicRuleIndex = 0;
+
+static Universe *universe = NULL;
+static const char *topologyNames[] = { "DEAD EDGE", "TORUS", "MIRROR" };
+static const char *engineNames[] = { "BITWISE", "SPARSE", "GENERATIONS", "LARGER THAN LIFE", "ISOTROPIC" };
+static const char *generationsRules[] = { "B2/S/C3", "B2/S345/C4", "B34/S12/C3", "B3/S23/C8" };
+static const char *largerRules[] = {
+    "R5,C0,M1,S34..58,B34..45,NM",      // Bosco's rule
+    "R4,C0,M1,S41..81,B41..81,NM",      // Majority
+    "R7,C0,M1,S100..200,B75..170,NM",   // Waffle
+    "R2,C0,M0,S3..6,B5..6,NN"
 };
+static const char *isotropicRules[] = { "B3/S2-i34q", "B2-a/S12", "B3/S23" };
+
+// Cell rendering
+// NOTE: Visible cells are drawn as one texture, one pixel per cell, coloured through the state palette.
+// The texture is sized to the display box, so drawing cost does not grow with the board.
+static Color *cellPixels = NULL;
+static Texture2D gridTexture = { 0 };
+static int textureWidth = 0;
+static int textureHeight = 0;
+static Color statePalette[GENERATIONS_MAX_STATES] = { 0 };
+
+// Heat map, A colours cells by the generations they kept their state instead of by state
+// NOTE: Ages are only loaded and stepped while the heat map is on
+#define AGE_COOLDOWN 32         // Generations for a cell to fade from its newborn or just died colour
+static LifeAges ages = { 0 };
+static Color agePalette[2][LIFE_AGE_MAX + 1] = { 0 };
+
+// Zoomed out texels are shaded by live cell density from the population pyramid
+// NOTE: gridVersion changes with every edit or generation, the pyramid is only recounted when it did
+static LifePyramid pyramid = { 0 };
+static int gridVersion = 0;
+static int pyramidVersion = -1;
+
+// Objects, connected groups of live cells counted for the HUD whenever the grid changed
+static LifeObjects *objects = NULL;
+static int objectsVersion = -1;
+static int objectCount = 0;
+static int knownObjectCount = 0;
+
+// Glider search, S starts and stops highlighting free standing gliders in any phase and orientation
+static LifeSearch *gliderSearch = NULL;
+static int searchVersion = -1;
+static int searchMatchCount = 0;
+static int shownMatchCount = 0;
+static SearchMatch shownMatches[MAX_SHOWN_MATCHES] = { 0 };
+
+// Region editing, shift and drag selects cells, edits are word blits on the packed grid
+// NOTE: C copies, U cuts, V pastes and B stamps the clipboard at the mouse, O turns it clockwise, H and J flip it,
+// I fills and DELETE clears the selection, K loads pattern.rle into the clipboard
+static bool selecting = false;
+static bool hasSelection = false;
+static int selectionRow = 0;            // Cell the drag started on
+static int selectionCol = 0;
+static int selectionEndRow = 0;
+static int selectionEndCol = 0;
+static int mouseRow = -1;               // Cell under the mouse when the grid was last drawn, -1 when off the grid
+static int mouseCol = -1;
+static LifeClip clipboard = { 0 };
+
+// Random fill, D fills the selection or the whole board, each press with the next seed
+#define RANDOM_FILL_DENSITY 0.3
+static uint64_t randomSeed = 1;
+
+// Session journal, W records every change and input until pressed again, then saves it for the replay tool
+static LifeJournal *journal = NULL;
+static int64_t sessionFrame = 0;
+
+// Recording, X starts and stops a GIF of every generation
+static LifeExport *recording = NULL;
+
+// Trace, L starts and stops writing every generation to a seekable trace file
+static LifeTrace *trace = NULL;
+
+// Shared memory, M starts and stops publishing generations for other local processes
+static LifeShare *share = NULL;
 
-static struct Cell *GridOfLife[GRID_ROWS][GRID_COLS];
+// Stream server, N starts and stops streaming generations to viewers on a local socket
+static LifeServer *server = NULL;
+
+// Idle mode: while paused a frame is only drawn when input, a resize or an edit changed something
+static bool inputActive = false;
+static int drawnVersion = -1;
+
+// Cells are kept in a render texture the size of the display box, repainted only where they changed
+static RenderTexture2D gridTarget = { 0 };
+static Camera2D targetView = { 0 };     // Camera the target was painted with, relative to the box
+static bool gridTargetValid = false;
+
+// Camera, one world unit per cell so zoom is the cell size in pixels
+static Camera2D camera = { 0 };
+static bool cameraFitted = false;
+static float minZoom = 1.0f;
 //----------------------------------------------------------------------------------
 // Gameplay Screen Functions Definition
 //----------------------------------------------------------------------------------
 
+// Dead cells are black, live cells white and dying states fade from yellow to dark red
+void BuildStatePalette()
+{
+    statePalette[0] = BLACK;
+    statePalette[1] = WHITE;
+    int states = GetUniverseStats(universe).states;
+    int i;
+    for (i = 2; i < GENERATIONS_MAX_STATES; i++)
+    {
+        float t = (states > 3)? (float) (i - 2)/(states - 3) : 0.0f;
+        if (t > 1.0f)
+        {
+            t = 1.0f;
+        }
+        Color color = {(unsigned char) (253 - 153*t), (unsigned char) (249 - 249*t), 0, 255};
+        statePalette[i] = color;
+    }
+}
+
+// Newborn cells glow white and cool down through yellow to red, dead cells fade out from a dim orange
+void BuildAgePalette()
+{
+    int age;
+    for (age = 0; age <= LIFE_AGE_MAX; age++)
+    {
+        float t = (age < AGE_COOLDOWN)? (float) age/AGE_COOLDOWN : 1.0f;
+        Color alive = {(unsigned char) (255 - 75*t), (unsigned char) (255 - 235*t), (unsigned char) (200 - 200*t), 255};
+        Color dead = {(unsigned char) (140 - 140*t), (unsigned char) (50 - 50*t), 0, 255};
+        agePalette[1][age] = alive;
+        agePalette[0][age] = dead;
+    }
+}
+
+// Rule preset of the selected engine, NULL for the engines without presets
+const char *GetEngineRule()
+{
+    if (engine == ENGINE_GENERATIONS)
+    {
+        return generationsRules[generationsRuleIndex];
+    }
+    if (engine == ENGINE_LARGER)
+    {
+        return largerRules[largerRuleIndex];
+    }
+    if (engine == ENGINE_ISOTROPIC)
+    {
+        return isotropicRules[isotropicRuleIndex];
+    }
+    return NULL;
+}
+
+// Switch the universe to the selected engine and rule preset, live cells carry over
+// NOTE: A preset the engine rejects leaves the universe as it was and returns false
+bool LoadEngine()
+{
+    const char *rule = GetEngineRule();
+    if (!IsUniverseRuleValid(engine, rule))
+    {
+        TraceLog(LOG_WARNING, "ENGINE: %s engine rejects rule %s", engineNames[engine], (rule != NULL)? rule : "(default)");
+        return false;
+    }
+    if (!SetUniverseEngine(universe, engine, rule))
+    {
+        TraceLog(LOG_FATAL, "Unable to allocate memory for %s engine", engineNames[engine]);
+    }
+    BuildStatePalette();
+    gridVersion++;
+    gridTargetValid = false;
+    return true;
+}
+
+// Switch to the next simulation engine, staying on the current one when its preset is rejected
+void CycleEngine()
+{
+    LifeEngine previous = engine;
+    engine = (engine + 1)%5;
+    if (!LoadEngine())
+    {
+        engine = previous;
+    }
+}
+
+// Switch to the next rule preset of the selected engine, keeping the current one when rejected
+void CycleEngineRule()
+{
+    int previousGenerations = generationsRuleIndex;
+    int previousLarger = largerRuleIndex;
+    int previousIsotropic = isotropicRuleIndex;
+    if (engine == ENGINE_GENERATIONS)
+    {
+        generationsRuleIndex = (generationsRuleIndex + 1)%(sizeof(generationsRules)/sizeof(generationsRules[0]));
+    }
+    else if (engine == ENGINE_LARGER)
+    {
+        largerRuleIndex = (largerRuleIndex + 1)%(sizeof(largerRules)/sizeof(largerRules[0]));
+    }
+    else if (engine == ENGINE_ISOTROPIC)
+    {
+        isotropicRuleIndex = (isotropicRuleIndex + 1)%(sizeof(isotropicRules)/sizeof(isotropicRules[0]));
+    }
+    else
+    {
+        return;
+    }
+    if (!LoadEngine())
+    {
+        generationsRuleIndex = previousGenerations;
+        largerRuleIndex = previousLarger;
+        isotropicRuleIndex = previousIsotropic;
+    }
+}
+
+int ClampInt(int value, int min, int max)
+{
+    return (value < min)? min : (value > max)? max : value;
+}
+
+// Padded area of the screen the grid is drawn into
+Rectangle GetDisplayBox()
+{
+    Rectangle box = {(float) paddingLeft, (float) paddingTop, (float) (GetScreenWidth() - paddingLeft - paddingRight), (float) (GetScreenHeight() - paddingTop - paddingBottom)};
+    return box;
+}
+
+// Center the whole grid in the display box
+void FitCamera()
+{
+    Rectangle box = GetDisplayBox();
+    float zoomX = box.width/cols;
+    float zoomY = box.height/rows;
+    camera.zoom = (zoomX < zoomY)? zoomX : zoomY;
+    camera.offset = (Vector2){box.x + box.width/2, box.y + box.height/2};
+    camera.target = (Vector2){cols/2.0f, rows/2.0f};
+    camera.rotation = 0.0f;
+    minZoom = camera.zoom/4;
+    cameraFitted = true;
+}
+
+// Mouse wheel zooms around the cursor, right or middle button drag pans, F fits the grid again
+void UpdateGameCamera()
+{
+    if (!cameraFitted || IsKeyPressed(KEY_F))
+    {
+        FitCamera();
+    }
+
+    float wheel = GetMouseWheelMove();
+    if (wheel != 0.0f)
+    {
+        Vector2 mousePos = GetMousePosition();
+        camera.target = GetScreenToWorld2D(mousePos, camera);
+        camera.offset = mousePos;
+        camera.zoom *= (wheel > 0.0f)? 1.25f : 0.8f;
+        if (camera.zoom < minZoom)
+        {
+            camera.zoom = minZoom;
+        }
+        if (camera.zoom > MAX_CELL_ZOOM)
+        {
+            camera.zoom = MAX_CELL_ZOOM;
+        }
+    }
+
+    if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT) || IsMouseButtonDown(MOUSE_BUTTON_MIDDLE))
+    {
+        Vector2 delta = GetMouseDelta();
+        camera.target.x -= delta.x/camera.zoom;
+        camera.target.y -= delta.y/camera.zoom;
+    }
+}
+
+// Grow the grid texture and its pixel buffer to at least width x height
+void ReserveGridTexture(int width, int height)
+{
+    if ((width <= textureWidth) && (height <= textureHeight))
+    {
+        return;
+    }
+    textureWidth = (width > textureWidth)? width : textureWidth;
+    textureHeight = (height > textureHeight)? height : textureHeight;
+
+    free(cellPixels);
+    cellPixels = malloc((size_t) textureWidth * textureHeight * sizeof(Color));
+    if (cellPixels == NULL)
+    {
+        TraceLog(LOG_FATAL, "Unable to allocate memory for grid texture");
+    }
+    UnloadTexture(gridTexture);
+    Image image = GenImageColor(textureWidth, textureHeight, BLACK);
+    gridTexture = LoadTextureFromImage(image);
+    UnloadImage(image);
+}
+
+// State of one cell for the selected engine
+int GetCellState(int row, int col)
+{
+    return GetUniverseCell(universe, row, col);
+}
+
+// Shade of a 2^level block, dead to alive colour by the fraction of live cells
+Color GetDensityColor(int level, int blockRow, int blockCol)
+{
+    int side = 1 << level;
+    int height = (rows - blockRow * side < side)? rows - blockRow * side : side;
+    int width = (cols - blockCol * side < side)? cols - blockCol * side : side;
+    float density = (float) GetPyramidPopulation(pyramid, GetUniverseGrid(universe), level, blockRow, blockCol)/(width * height);
+
+    // Square root keeps sparse regions visible, a lone glider in a 64x64 block is still lit
+    float t = sqrtf(density);
+    Color dead = statePalette[0];
+    Color alive = statePalette[1];
+    Color color = {(unsigned char) (dead.r + (alive.r - dead.r)*t), (unsigned char) (dead.g + (alive.g - dead.g)*t), (unsigned char) (dead.b + (alive.b - dead.b)*t), 255};
+    return color;
+}
+
 // Gameplay Screen Initialization logic
 void InitGameplayScreen(void)
 {
@@ -80,20 +388,31 @@ void InitGameplayScreen(void)
     cycleCounter = 0;
     gameSpeed = 10;
     isPlaying = 0;
-    int row, col;
-    for (row = 0; row < rows; row++)
+    universe = LoadUniverse(rows, cols, topology);
+    if (universe == NULL)
     {
-        for (col = 0; col < cols; col++)
-        {
-            struct Cell *cell = malloc(sizeof(struct Cell));
-            if (cell == NULL)
-            {
-                TraceLog(LOG_FATAL, "Unable to allocate memory for Cell of Life");
-            }
-            cell->status = DEAD;
-            cell->border = 0;
-            GridOfLife[row][col] = cell;
-        }
+        TraceLog(LOG_FATAL, "Unable to allocate memory for Grid of Life");
+    }
+    if (!LoadEngine())
+    {
+        engine = ENGINE_BITWISE;
+        LoadEngine();
+    }
+    cameraFitted = false;
+    drawnVersion = -1;
+
+    pyramid = LoadLifePyramid(GetUniverseGrid(universe));
+    pyramidVersion = -1;
+    if (pyramid.counts[PYRAMID_FIRST_LEVEL] == NULL)
+    {
+        TraceLog(LOG_FATAL, "Unable to allocate memory for population pyramid");
+    }
+
+    objects = LoadLifeObjects(ADJACENCY_MOORE);
+    objectsVersion = -1;
+    if (objects == NULL)
+    {
+        TraceLog(LOG_FATAL, "Unable to allocate memory for object labelling");
     }
 }
 
@@ -128,7 +447,6 @@ bool ShouldStartNextCycle()
 {
     float rate = (float) gameSpeed / 10;
     int frameLimit = TARGET_FPS * 1 / rate;
-    TraceLog(LOG_DEBUG, "Frame limit: %d", frameLimit);
     if (framesCounter >= frameLimit)
     {
         return true;
@@ -136,124 +454,342 @@ bool ShouldStartNextCycle()
     return false;
 }
 
-// Count alive cells surrounding given cell position
-int AdjacentAliveCells(int cellRow, int cellCol)
+// Advance the universe one generation and pass it on to the recorders
+void CyleOfLife()
 {
-    int aliveCells = 0;
-    struct PositionOffset
+    StepUniverse(universe, 1);
+    framesCounter = 0;
+    cycleCounter++;
+    gridVersion++;
+    if (ages.ages != NULL)
     {
-        int x;
-        int y;
-    };
-    struct PositionOffset OffsetArray[8] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
-    int i;
-    for (i = 0; i < 8; i++)
+        UpdateLifeAges(&ages, GetUniverseGrid(universe));
+    }
+    if (recording != NULL)
+    {
+        SubmitLifeExport(recording, GetUniverseGrid(universe), cycleCounter);
+    }
+    if (trace != NULL)
     {
-        int offsetRow = cellRow + OffsetArray[i].x;
-        int offsetCol = cellCol + OffsetArray[i].y;
+        AppendLifeTrace(trace, GetUniverseGrid(universe));
+    }
+    if (share != NULL)
+    {
+        PublishLifeShare(share, GetUniverseGrid(universe), cycleCounter);
+    }
+    if (server != NULL)
+    {
+        PublishLifeServer(server, GetUniverseGrid(universe), cycleCounter);
+    }
+}
 
-        if (INFINITE_GRID)
-        {
-            if (offsetRow < 0)
-            {
-                offsetRow = rows - 1;
-            }
-            if (offsetRow > rows - 1)
-            {
-                offsetRow = 0;
-            }
+// Switch to the next grid topology, takes effect on the next cycle
+void CycleGridTopology()
+{
+    topology = (topology + 1)%3;
+    SetUniverseTopology(universe, topology);
+}
 
-            if (offsetCol < 0)
-            {
-                offsetCol = cols - 1;
-            }
-            if (offsetCol > cols - 1)
-            {
-                offsetCol = 0;
-            }
-        }
-        if (offsetRow >= 0 && offsetRow < rows && offsetCol >= 0 && offsetCol < cols)
+// Any key, button, wheel or mouse movement since the last frame
+bool IsInputActive()
+{
+    Vector2 delta = GetMouseDelta();
+    int button;
+    for (button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_MIDDLE; button++)
+    {
+        if (IsMouseButtonPressed(button) || IsMouseButtonReleased(button))
         {
-            // TraceLog(LOG_DEBUG, "Offset x: %d, offset y: %d", offsetRow, offsetCol);
-            struct Cell *cell = GridOfLife[offsetRow][offsetCol];
-            if (cell->status == ALIVE)
-            {
-                aliveCells++;
-            }
+            return true;
         }
     }
-    return aliveCells;
+    return (GetKeyPressed() != 0) || (delta.x != 0.0f) || (delta.y != 0.0f) || (GetMouseWheelMove() != 0.0f);
 }
 
-// The check every cell in the GridOfLife and apply Rules of life to it
-void CyleOfLife()
+// Start or stop recording generations to a GIF, encoding runs on background threads
+void ToggleRecording()
 {
-    struct Cell *newGrid[rows][cols];
-    int row, col;
-    for (row = 0; row < rows; row++)
+    if (recording != NULL)
     {
-        for (col = 0; col < cols; col++)
-        {
-            struct Cell *cell = GridOfLife[row][col];
-            int surroundingLife = AdjacentAliveCells(row, col);
+        int frames = CloseLifeExport(recording);
+        recording = NULL;
+        TraceLog((frames < 0)? LOG_WARNING : LOG_INFO, "EXPORT: Recording stopped, %d frames written", frames);
+        return;
+    }
 
-            struct Cell *newCell = malloc(sizeof(struct Cell));
-            if (newCell == NULL)
-            {
-                TraceLog(LOG_FATAL, "Unable to allocate memory for Cell of Life");
-            }
-            newCell->status = cell->status;
-            newCell->outerRec = cell->outerRec;
-            newCell->innerRec = cell->innerRec;
-            newCell->border = cell->border;
+    ExportSettings settings = { 0 };
+    settings.format = EXPORT_GIF;
+    settings.path = "cgameoflife.gif";
+    settings.every = 1;
+    settings.scale = 1;
+    settings.frameDelay = 4;
+    settings.queueFrames = 16;
+    recording = OpenLifeExport(settings, rows, cols);
+    if (recording == NULL)
+    {
+        TraceLog(LOG_WARNING, "EXPORT: Unable to start recording to %s", settings.path);
+        return;
+    }
+    TraceLog(LOG_INFO, "EXPORT: Recording to %s", settings.path);
+}
 
-            switch (cell->status)
-            {
-                case DEAD:
-                    if (surroundingLife == 3)
-                    {
-                        newCell->status = ALIVE;
-                    }
-                    break;
-                case ALIVE:
-                    if (surroundingLife < 2)
-                    {
-                        newCell->status = DEAD;
-                    }
-                    else if (surroundingLife > 3)
-                    {
-                        newCell->status = DEAD;
-                    }
-                    else if (surroundingLife == 2 || surroundingLife == 3)
-                    {
-                        // it continue to live
-                    }
-                    break;
-                default:
-                    break;
-            }
-            newGrid[row][col] = newCell;
+// Start or stop tracing generations, deltas are compressed and written on a background thread
+void ToggleTrace()
+{
+    const char *path = "cgameoflife.trace";
+    if (trace != NULL)
+    {
+        bool written = CloseLifeTrace(trace);
+        trace = NULL;
+        TraceLog(written? LOG_INFO : LOG_WARNING, "TRACE: Trace %s %s", path, written? "closed" : "failed");
+        return;
+    }
+
+    trace = OpenLifeTrace(path, GetUniverseGrid(universe), cycleCounter, 256);
+    if (trace == NULL)
+    {
+        TraceLog(LOG_WARNING, "TRACE: Unable to start tracing to %s", path);
+        return;
+    }
+    TraceLog(LOG_INFO, "TRACE: Tracing to %s from cycle %d", path, cycleCounter);
+}
+
+// Show or hide the heat map of cell ages
+void ToggleAges()
+{
+    if (ages.ages != NULL)
+    {
+        UnloadLifeAges(ages);
+        ages = (LifeAges){ 0 };
+        TraceLog(LOG_INFO, "AGES: Heat map off");
+        gridVersion++;
+        gridTargetValid = false;
+        return;
+    }
+
+    ages = LoadLifeAges(GetUniverseGrid(universe));
+    if (ages.ages == NULL)
+    {
+        TraceLog(LOG_WARNING, "AGES: Unable to allocate memory for cell ages");
+        return;
+    }
+    BuildAgePalette();
+    TraceLog(LOG_INFO, "AGES: Heat map on from cycle %d", cycleCounter);
+    gridVersion++;
+    gridTargetValid = false;
+}
+
+// Start recording the session, or stop and save it
+void ToggleJournal()
+{
+    const char *path = "session.journal";
+    if (journal != NULL)
+    {
+        SetUniverseJournal(universe, NULL);
+        JournalInfo info = GetLifeJournalInfo(journal);
+        bool saved = SaveLifeJournal(journal, path);
+        TraceLog(saved? LOG_INFO : LOG_WARNING, "JOURNAL: %d events over %lld frames %s %s", info.events, (long long)info.frames,
+            saved? "saved to" : "could not be saved to", path);
+        UnloadLifeJournal(journal);
+        journal = NULL;
+        return;
+    }
+
+    journal = LoadLifeJournal(rows, cols, topology);
+    if (journal == NULL)
+    {
+        TraceLog(LOG_WARNING, "JOURNAL: Unable to allocate memory for the journal");
+        return;
+    }
+    SetLifeJournalFrame(journal, sessionFrame);
+    SetUniverseJournal(universe, journal);
+    TraceLog(LOG_INFO, "JOURNAL: Recording from cycle %d", cycleCounter);
+}
+
+// Start or stop publishing generations to a shared memory segment
+void ToggleShare()
+{
+    const char *name = "/cgameoflife";
+    if (share != NULL)
+    {
+        CloseLifeShare(share);
+        share = NULL;
+        TraceLog(LOG_INFO, "SHARE: Stopped publishing to %s", name);
+        return;
+    }
+
+    share = OpenLifeShare(name, rows, cols, 4);
+    if (share == NULL)
+    {
+        TraceLog(LOG_WARNING, "SHARE: Unable to create shared memory segment %s", name);
+        return;
+    }
+    PublishLifeShare(share, GetUniverseGrid(universe), cycleCounter);
+    TraceLog(LOG_INFO, "SHARE: Publishing to %s", name);
+}
+
+// Start or stop streaming generations, viewers connect with the viewer program
+void ToggleServer()
+{
+    const char *address = "unix:/tmp/cgameoflife.sock";
+    if (server != NULL)
+    {
+        CloseLifeServer(server);
+        server = NULL;
+        TraceLog(LOG_INFO, "SERVER: Stopped streaming on %s", address);
+        return;
+    }
+
+    server = OpenLifeServer(address, GetUniverseGrid(universe), cycleCounter);
+    if (server == NULL)
+    {
+        TraceLog(LOG_WARNING, "SERVER: Unable to listen on %s", address);
+        return;
+    }
+    TraceLog(LOG_INFO, "SERVER: Streaming on %s", address);
+}
+
+// Start or stop highlighting gliders, the board is searched again whenever it changed
+void ToggleGliderSearch()
+{
+    if (gliderSearch != NULL)
+    {
+        UnloadLifeSearch(gliderSearch);
+        gliderSearch = NULL;
+        TraceLog(LOG_INFO, "SEARCH: Stopped searching for gliders");
+        return;
+    }
+
+    LifeGrid glider = LoadLifeGrid(3, 3, TOPOLOGY_DEAD_EDGE);
+    if (glider.cells != NULL)
+    {
+        SetLifeCell(&glider, 0, 1, true);
+        SetLifeCell(&glider, 1, 2, true);
+        SetLifeCell(&glider, 2, 0, true);
+        SetLifeCell(&glider, 2, 1, true);
+        SetLifeCell(&glider, 2, 2, true);
+        gliderSearch = LoadLifeSearch(glider, 4, true);
+    }
+    UnloadLifeGrid(glider);
+    if (gliderSearch == NULL)
+    {
+        TraceLog(LOG_WARNING, "SEARCH: Unable to set up the glider search");
+        return;
+    }
+    searchVersion = -1;
+    TraceLog(LOG_INFO, "SEARCH: Searching for gliders, %d variants", GetLifeSearchInfo(gliderSearch).variants);
+}
+
+// Selected rectangle, false when nothing is selected
+bool GetSelection(int *row, int *col, int *height, int *width)
+{
+    if (!hasSelection)
+    {
+        return false;
+    }
+    *row = (selectionRow < selectionEndRow)? selectionRow : selectionEndRow;
+    *col = (selectionCol < selectionEndCol)? selectionCol : selectionEndCol;
+    *height = abs(selectionEndRow - selectionRow) + 1;
+    *width = abs(selectionEndCol - selectionCol) + 1;
+    return true;
+}
+
+// Replace the clipboard, the previous one is freed
+void SetClipboard(LifeClip clip)
+{
+    if (clip.cells == NULL)
+    {
+        TraceLog(LOG_WARNING, "EDIT: Unable to allocate memory for the clipboard");
+        return;
+    }
+    UnloadLifeClip(clipboard);
+    clipboard = clip;
+}
+
+// Copy, cut, paste, stamp, turn, flip, fill and random fill from the keyboard
+void UpdateRegionEditing()
+{
+    int row, col, height, width;
+    bool selected = GetSelection(&row, &col, &height, &width);
+
+    if (selected && (IsKeyPressed(KEY_C) || IsKeyPressed(KEY_U)))
+    {
+        SetClipboard(CopyUniverseRegion(universe, row, col, height, width));
+        TraceLog(LOG_INFO, "EDIT: Copied %dx%d cells", width, height);
+    }
+    if (selected && (IsKeyPressed(KEY_U) || IsKeyPressed(KEY_DELETE)))
+    {
+        FillUniverseRegion(universe, row, col, height, width, 0);
+        gridVersion++;
+    }
+    if (selected && IsKeyPressed(KEY_I))
+    {
+        FillUniverseRegion(universe, row, col, height, width, 1);
+        gridVersion++;
+    }
+    if (IsKeyPressed(KEY_D))
+    {
+        if (!selected)
+        {
+            row = col = 0;
+            height = rows;
+            width = cols;
         }
+        RandomizeUniverseRegion(universe, row, col, height, width, RANDOM_FILL_DENSITY, randomSeed);
+        TraceLog(LOG_INFO, "EDIT: Filled %dx%d cells at density %.2f with seed %llu", width, height, RANDOM_FILL_DENSITY, (unsigned long long)randomSeed);
+        randomSeed++;
+        gridVersion++;
     }
-    for (row = 0; row < rows; row++)
+    if (IsKeyPressed(KEY_K))
     {
-        for (col = 0; col < cols; col++)
+        LifeClip pattern = LoadLifePattern("pattern.rle");
+        if (pattern.cells == NULL)
         {
-            free(GridOfLife[row][col]);
-            GridOfLife[row][col] = newGrid[row][col];
+            TraceLog(LOG_WARNING, "EDIT: Unable to load pattern.rle");
+        }
+        else
+        {
+            SetClipboard(pattern);
+            TraceLog(LOG_INFO, "EDIT: Loaded a %dx%d pattern", pattern.cols, pattern.rows);
         }
     }
-    framesCounter = 0;
-    cycleCounter++;
+
+    if (clipboard.cells == NULL)
+    {
+        return;
+    }
+    if (IsKeyPressed(KEY_O))
+    {
+        SetClipboard(RotateLifeClip(clipboard));
+    }
+    if (IsKeyPressed(KEY_H))
+    {
+        FlipLifeClip(&clipboard, true);
+    }
+    if (IsKeyPressed(KEY_J))
+    {
+        FlipLifeClip(&clipboard, false);
+    }
+    if ((mouseRow >= 0) && (IsKeyPressed(KEY_V) || IsKeyPressed(KEY_B)))
+    {
+        PasteUniverseClip(universe, clipboard, mouseRow, mouseCol, IsKeyPressed(KEY_V)? CLIP_REPLACE : CLIP_STAMP);
+        gridVersion++;
+    }
 }
 
 // Gameplay Screen Update logic
 void UpdateGameplayScreen(void)
 {
     // TODO: Update GAMEPLAY screen variables here!
+    inputActive = IsInputActive();
+    sessionFrame++;
+    if (journal != NULL)
+    {
+        SetLifeJournalFrame(journal, sessionFrame);
+    }
 
     if (IsKeyPressed(KEY_P))
     {
+        RecordUniverseInput(universe, KEY_P);
         if (isPlaying == 1)
         {
             isPlaying = 0;
@@ -268,17 +804,62 @@ void UpdateGameplayScreen(void)
         UnloadGameplayScreen();
         InitGameplayScreen();
     }
+    if (IsKeyPressed(KEY_T))
+    {
+        CycleGridTopology();
+    }
+    if (IsKeyPressed(KEY_E))
+    {
+        CycleEngine();
+    }
+    if (IsKeyPressed(KEY_G))
+    {
+        CycleEngineRule();
+    }
+    if (IsKeyPressed(KEY_X))
+    {
+        ToggleRecording();
+    }
+    if (IsKeyPressed(KEY_L))
+    {
+        ToggleTrace();
+    }
+    if (IsKeyPressed(KEY_M))
+    {
+        ToggleShare();
+    }
+    if (IsKeyPressed(KEY_N))
+    {
+        ToggleServer();
+    }
+    if (IsKeyPressed(KEY_S))
+    {
+        ToggleGliderSearch();
+    }
+    if (IsKeyPressed(KEY_A))
+    {
+        ToggleAges();
+    }
+    if (IsKeyPressed(KEY_W))
+    {
+        ToggleJournal();
+    }
+    UpdateRegionEditing();
+    UpdateGameCamera();
     if (IsKeyPressed(KEY_RIGHT) || IsKeyPressedRepeat(KEY_RIGHT))
     {
+        RecordUniverseInput(universe, KEY_RIGHT);
         CyleOfLife();
     }
 
     if (IsKeyPressedRepeat(KEY_UP) || IsKeyPressed(KEY_UP))
     {
+        RecordUniverseInput(universe, KEY_UP);
         IncreaseGameSpeed();
     }
     else if (IsKeyPressedRepeat(KEY_DOWN) || IsKeyPressed(KEY_DOWN))
     {
+        RecordUniverseInput(universe, KEY_DOWN);
         DescreaseGameSpeed();
     }
 
@@ -312,123 +893,332 @@ void DrawGameplayScreen(void)
     char isPlayingStr[] = "ISPLAYING: 1";
     sprintf(isPlayingStr, "ISPLAYING: %d", isPlaying);
     DrawText(isPlayingStr, w - 400, 30, 20, MAROON);
-    DrawGameGrid();
-}
+    if (recording != NULL)
+    {
+        DrawText("REC", w - 200, 30, 20, RED);
+    }
+    if (trace != NULL)
+    {
+        DrawText("TRACE", w - 150, 30, 20, RED);
+    }
+    if (share != NULL)
+    {
+        DrawText("SHM", w - 80, 30, 20, RED);
+    }
+    if (server != NULL)
+    {
+        char serverText[40] = "";
+        sprintf(serverText, "NET %d", GetLifeServerClients(server));
+        DrawText(serverText, w - 200, 5, 20, RED);
+    }
 
-void OnCellClick(struct Cell *cell)
-{
-    int newValue = cell->status + 1;
-    if (newValue > 1)
+    char topologyText[80] = "";
+    sprintf(topologyText, "Topology: %s", topologyNames[topology]);
+    DrawText(topologyText, w - 400, 55, 20, MAROON);
+
+    char engineText[80] = "";
+    sprintf(engineText, "Engine: %s", engineNames[engine]);
+    if (engine == ENGINE_GENERATIONS)
+    {
+        sprintf(engineText, "Engine: %s %s", engineNames[engine], generationsRules[generationsRuleIndex]);
+    }
+    else if (engine == ENGINE_LARGER)
+    {
+        sprintf(engineText, "Engine: LtL %s", largerRules[largerRuleIndex]);
+    }
+    else if (engine == ENGINE_ISOTROPIC)
+    {
+        sprintf(engineText, "Engine: %s %s", engineNames[engine], isotropicRules[isotropicRuleIndex]);
+    }
+    DrawText(engineText, w - 400, 80, 20, MAROON);
+
+    if (objectsVersion != gridVersion)
+    {
+        objectCount = LabelLifeObjects(objects, GetUniverseGrid(universe));
+        knownObjectCount = GetLifeObjectsInfo(objects).known;
+        objectsVersion = gridVersion;
+    }
+    char objectsText[80] = "";
+    sprintf(objectsText, "Objects: %d (%d known)", objectCount, knownObjectCount);
+    DrawText(objectsText, w - 700, 80, 20, MAROON);
+
+    if ((gliderSearch != NULL) && (searchVersion != gridVersion))
+    {
+        searchMatchCount = RunLifeSearch(gliderSearch, GetUniverseGrid(universe));
+        shownMatchCount = GetLifeSearchMatches(gliderSearch, shownMatches, MAX_SHOWN_MATCHES);
+        searchVersion = gridVersion;
+    }
+    if (gliderSearch != NULL)
     {
-        newValue = 0;
+        char searchText[80] = "";
+        sprintf(searchText, "Gliders: %d", searchMatchCount);
+        DrawText(searchText, w - 700, 55, 20, RED);
     }
-    cell->status = newValue;
-    PlaySound(fxCoin);
+    DrawGameGrid();
+    drawnVersion = gridVersion;
 }
 
-void DrawGameGrid(void)
+void OnCellClick(int row, int col)
 {
+    int state = (GetUniverseCell(universe, row, col) == 0)? 1 : 0;
+    SetUniverseCell(universe, row, col, state);
+    gridVersion++;
+}
 
-    int w = GetScreenWidth();
-    int h = GetScreenHeight();
-
-    struct Vector2 mousePos = GetMousePosition();
-    bool mouseClicked = IsMouseButtonPressed(MOUSE_BUTTON_LEFT);
+// Draw the cells of one region into the current target, one texel per 2^level block
+// NOTE: The region starts on a block boundary and view maps cells to target pixels
+void DrawCellRegion(Camera2D view, int firstRow, int firstCol, int regionRows, int regionCols, int level)
+{
+    int step = 1 << level;
+    int textureCols = (regionCols + step - 1)/step;
+    int textureRows = (regionRows + step - 1)/step;
 
-    // Display box
-    int displayWidth = w - paddingLeft - paddingRight;
-    int displayHeight = h - paddingTop - paddingBottom;
-    int displayPosX = paddingLeft;
-    int displayPosY = paddingTop;
-    DrawRectangle(displayPosX, displayPosY, displayWidth, displayHeight, GRAY);
+    int row, col;
+    for (row = 0; row < textureRows; row++)
+    {
+        Color *pixels = cellPixels + (size_t) row * textureCols;
+        if ((level == 0) && (ages.ages != NULL))
+        {
+            for (col = 0; col < textureCols; col++)
+            {
+                int alive = (GetCellState(firstRow + row, firstCol + col) == 1)? 1 : 0;
+                pixels[col] = agePalette[alive][GetLifeAge(ages, firstRow + row, firstCol + col)];
+            }
+        }
+        else if (level == 0)
+        {
+            for (col = 0; col < textureCols; col++)
+            {
+                pixels[col] = statePalette[GetCellState(firstRow + row, firstCol + col)];
+            }
+        }
+        else
+        {
+            for (col = 0; col < textureCols; col++)
+            {
+                pixels[col] = GetDensityColor(level, firstRow/step + row, firstCol/step + col);
+            }
+        }
+    }
+    UpdateTextureRec(gridTexture, (Rectangle){0.0f, 0.0f, (float) textureCols, (float) textureRows}, cellPixels);
 
-    int gapSpaceX = (cols - 1) * gap;
-    int gapSpaceY = (rows - 1) * gap;
+    // Ending the 2D mode flushes the batch, so the next region can reuse the texture
+    BeginMode2D(view);
+    struct Rectangle source = {0.0f, 0.0f, (float) regionCols/step, (float) regionRows/step};
+    struct Rectangle dest = {(float) firstCol, (float) firstRow, (float) regionCols, (float) regionRows};
+    DrawTexturePro(gridTexture, source, dest, (Vector2){0.0f, 0.0f}, 0.0f, WHITE);
 
-    // Cell size
-    // Calculate cell size based the smaller side of display box
-    unsigned int cellWidth, cellHeight;
-    if (displayWidth > displayHeight)
+    // Gaps between cells are drawn over the texture as thin strips, only once cells are big enough to tell apart
+    if ((gap > 0) && (view.zoom >= MIN_GAP_ZOOM))
     {
-        cellHeight = (displayHeight - gapSpaceY) / rows;
-        cellWidth = cellHeight;
+        float gapSize = (float) gap/view.zoom;
+        for (col = firstCol + 1; col <= firstCol + regionCols; col++)
+        {
+            DrawRectangleRec((Rectangle){col - gapSize, (float) firstRow, gapSize, (float) regionRows}, GRAY);
+        }
+        for (row = firstRow + 1; row <= firstRow + regionRows; row++)
+        {
+            DrawRectangleRec((Rectangle){(float) firstCol, row - gapSize, (float) regionCols, gapSize}, GRAY);
+        }
     }
-    else
+    EndMode2D();
+}
+
+void DrawGameGrid(void)
+{
+    Rectangle box = GetDisplayBox();
+    int boxWidth = (int) box.width;
+    int boxHeight = (int) box.height;
+    if ((boxWidth <= 0) || (boxHeight <= 0))
     {
-        cellWidth = (displayWidth - gapSpaceX) / cols;
-        cellHeight = cellWidth;
+        return;
     }
 
-    // GRID
-    int centerX = displayPosX + displayWidth / 2;
-    int centerY = displayPosY + displayHeight / 2;
-    DrawCircle(centerX, centerY, 10.0, RED);
+    // Only cells under the display box are drawn
+    Vector2 topLeft = GetScreenToWorld2D((Vector2){box.x, box.y}, camera);
+    Vector2 bottomRight = GetScreenToWorld2D((Vector2){box.x + box.width, box.y + box.height}, camera);
+    int firstCol = ClampInt((int) floorf(topLeft.x), 0, cols);
+    int firstRow = ClampInt((int) floorf(topLeft.y), 0, rows);
+    int lastCol = ClampInt((int) ceilf(bottomRight.x), 0, cols);
+    int lastRow = ClampInt((int) ceilf(bottomRight.y), 0, rows);
 
-    int gridWidth = cols * cellWidth + (cols - 1) * gap;
-    int gridHeight = rows * cellHeight + (rows - 1) * gap;
+    // Zoomed out, a texel covers one 2^level block so uploads never exceed the box
+    int stepX = (lastCol - firstCol + boxWidth - 1)/boxWidth;
+    int stepY = (lastRow - firstRow + boxHeight - 1)/boxHeight;
+    int level = 0;
+    while ((((1 << level) < stepX) || ((1 << level) < stepY)) && (level < pyramid.levels - 1))
+    {
+        level++;
+    }
+    firstCol -= firstCol%(1 << level);
+    firstRow -= firstRow%(1 << level);
+    int visibleCols = lastCol - firstCol;
+    int visibleRows = lastRow - firstRow;
 
-    int gridPosX = centerX - gridWidth / 2;
-    int gridPosY = centerY - gridHeight / 2;
-    DrawCircle(gridPosX, gridPosY, 10.0, BLUE);
+    // Hovered cell is found by mapping the mouse through the camera
+    Vector2 mousePos = GetMousePosition();
+    Vector2 mouseCell = GetScreenToWorld2D(mousePos, camera);
+    int hoverRow = -1;
+    int hoverCol = -1;
+    if (CheckCollisionPointRec(mousePos, box) && (mouseCell.x >= 0.0f) && (mouseCell.y >= 0.0f) && (mouseCell.x < cols) && (mouseCell.y < rows))
+    {
+        hoverRow = (int) mouseCell.y;
+        hoverCol = (int) mouseCell.x;
+        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)))
+        {
+            selecting = true;
+            hasSelection = true;
+            selectionRow = selectionEndRow = hoverRow;
+            selectionCol = selectionEndCol = hoverCol;
+        }
+        else if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+        {
+            hasSelection = false;
+            OnCellClick(hoverRow, hoverCol);
+        }
+        if (selecting)
+        {
+            selectionEndRow = hoverRow;
+            selectionEndCol = hoverCol;
+        }
+    }
+    if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT))
+    {
+        selecting = false;
+    }
+    mouseRow = hoverRow;
+    mouseCol = hoverCol;
 
-    // Colors
-    Color borderColor = MAROON;
+    // The pyramid update also tells which tiles changed since the last frame
+    bool gridChanged = (pyramidVersion != gridVersion);
+    if (gridChanged)
+    {
+        UpdateLifePyramid(&pyramid, GetUniverseGrid(universe));
+        if (trace != NULL)
+        {
+            KeepLifeTraceChanges(trace, GetUniverseGrid(universe));
+        }
+        ClearUniverseChanges(universe);
+        pyramidVersion = gridVersion;
+    }
 
-    TraceLog(LOG_DEBUG, "GRID: Grid initialized");
-    TraceLog(LOG_DEBUG, "\t> Display box center: %d, %d", centerX, centerY);
-    TraceLog(LOG_DEBUG, "\t> Display box size: %dx%d", displayWidth, displayHeight);
-    TraceLog(LOG_DEBUG, "\t> Grid size: %dx%d", rows, cols);
-    TraceLog(LOG_DEBUG, "\t> Grid position: %d, %d", gridPosX, gridPosY);
-    TraceLog(LOG_DEBUG, "\t> Padding: %d %d %d %d", paddingTop, paddingRight, paddingBottom, paddingLeft);
-    TraceLog(LOG_DEBUG, "\t> Border: %d", borderThickness);
-    TraceLog(LOG_DEBUG, "\t> Cell size: %dx%d", cellWidth, cellHeight);
+    // Camera moves, resizes and engine switches repaint the whole box, otherwise only changed tiles are
+    // NOTE: Generations states and heat map ages change without touching live cells, so both repaint on every change
+    Camera2D view = camera;
+    view.offset.x -= box.x;
+    view.offset.y -= box.y;
+    if ((gridTarget.texture.width != boxWidth) || (gridTarget.texture.height != boxHeight))
+    {
+        if (gridTarget.id > 0)
+        {
+            UnloadRenderTexture(gridTarget);
+        }
+        gridTarget = LoadRenderTexture(boxWidth, boxHeight);
+        gridTargetValid = false;
+    }
+    if ((view.offset.x != targetView.offset.x) || (view.offset.y != targetView.offset.y) ||
+        (view.target.x != targetView.target.x) || (view.target.y != targetView.target.y) || (view.zoom != targetView.zoom))
+    {
+        gridTargetValid = false;
+    }
+    if (gridChanged && ((engine == ENGINE_GENERATIONS) || (ages.ages != NULL)))
+    {
+        gridTargetValid = false;
+    }
+    ReserveGridTexture(boxWidth + 1, boxHeight + 1);
 
-    // Draw grid and cells
+    BeginTextureMode(gridTarget);
+    if (!gridTargetValid)
+    {
+        // Logged on full repaints only, not every frame
+        TraceLog(LOG_DEBUG, "GRID: Grid repainted");
+        TraceLog(LOG_DEBUG, "\t> Display box size: %dx%d", boxWidth, boxHeight);
+        TraceLog(LOG_DEBUG, "\t> Grid size: %dx%d", rows, cols);
+        TraceLog(LOG_DEBUG, "\t> Camera target: %.1f, %.1f zoom %.3f", camera.target.x, camera.target.y, camera.zoom);
+        TraceLog(LOG_DEBUG, "\t> Visible cells: %dx%d from %d, %d", visibleRows, visibleCols, firstRow, firstCol);
 
-    int row, col;
-    for (row = 0; row < rows; row++)
+        ClearBackground(GRAY);
+        if ((visibleCols > 0) && (visibleRows > 0))
+        {
+            DrawCellRegion(view, firstRow, firstCol, visibleRows, visibleCols, level);
+        }
+        targetView = view;
+        gridTargetValid = true;
+    }
+    else if (gridChanged && (visibleCols > 0) && (visibleRows > 0))
     {
-        for (col = 0; col < cols; col++)
+        // Changed blocks are at least one tile, bigger when a texel covers more than a tile
+        int unit = (level > PYRAMID_TILE_LEVEL)? level : PYRAMID_TILE_LEVEL;
+        int unitCols = (cols + (1 << unit) - 1) >> unit;
+        int blockRow, blockCol;
+        for (blockRow = firstRow >> unit; blockRow <= (lastRow - 1) >> unit; blockRow++)
         {
-            Color cellFill;
-            struct Cell *cell = GridOfLife[row][col];
-            if (CheckCollisionPointRec(mousePos, cell->outerRec))
+            for (blockCol = firstCol >> unit; blockCol <= (lastCol - 1) >> unit; blockCol++)
             {
-                cell->border = borderThickness;
-                if (mouseClicked)
+                if (!pyramid.dirty[unit][(size_t) blockRow * unitCols + blockCol])
                 {
-                    OnCellClick(cell);
+                    continue;
                 }
+                int regionRow = ClampInt(blockRow << unit, firstRow, lastRow);
+                int regionCol = ClampInt(blockCol << unit, firstCol, lastCol);
+                int regionRows = ClampInt((blockRow + 1) << unit, firstRow, lastRow) - regionRow;
+                int regionCols = ClampInt((blockCol + 1) << unit, firstCol, lastCol) - regionCol;
+                DrawCellRegion(view, regionRow, regionCol, regionRows, regionCols, level);
             }
-            else
-            {
-                cell->border = 0;
-            }
-            if (cell->status == DEAD)
-            {
-                cellFill = BLACK;
-            }
-            else
+        }
+    }
+    EndTextureMode();
+
+    // Render textures are stored upside down
+    DrawTextureRec(gridTarget.texture, (Rectangle){0.0f, 0.0f, (float) boxWidth, (float) -boxHeight}, (Vector2){box.x, box.y}, WHITE);
+
+    // Hovered cell gets a border drawn over the cells, it never touches the cached grid
+    if (hoverRow >= 0)
+    {
+        BeginScissorMode((int) box.x, (int) box.y, boxWidth, boxHeight);
+        BeginMode2D(camera);
+        float cellSize = (camera.zoom >= MIN_GAP_ZOOM)? 1.0f - (float) gap/camera.zoom : 1.0f;
+        struct Rectangle outerRec = {(float) hoverCol, (float) hoverRow, cellSize, cellSize};
+        DrawRectangleLinesEx(outerRec, (float) borderThickness/camera.zoom, MAROON);
+        EndMode2D();
+        EndScissorMode();
+    }
+
+    // Selection is outlined over the cells like the hovered cell
+    int selectedRow, selectedCol, selectedRows, selectedCols;
+    if (GetSelection(&selectedRow, &selectedCol, &selectedRows, &selectedCols))
+    {
+        BeginScissorMode((int) box.x, (int) box.y, boxWidth, boxHeight);
+        BeginMode2D(camera);
+        struct Rectangle selectionRec = {(float) selectedCol, (float) selectedRow, (float) selectedCols, (float) selectedRows};
+        DrawRectangleLinesEx(selectionRec, (float) borderThickness/camera.zoom, SKYBLUE);
+        EndMode2D();
+        EndScissorMode();
+    }
+
+    // Search matches are outlined too
+    if ((gliderSearch != NULL) && (shownMatchCount > 0))
+    {
+        BeginScissorMode((int) box.x, (int) box.y, boxWidth, boxHeight);
+        BeginMode2D(camera);
+        int i;
+        for (i = 0; i < shownMatchCount; i++)
+        {
+            SearchMatch match = shownMatches[i];
+            if ((match.row + match.rows < firstRow) || (match.row > lastRow) || (match.col + match.cols < firstCol) || (match.col > lastCol))
             {
-                cellFill = WHITE;
+                continue;
             }
-            // Draw outer rectangle
-            int posX = gridPosX + col * (cellWidth + gap);
-            int posY = gridPosY + row * cellHeight + row * gap;
-            struct Rectangle outerRec = {(float) posX, (float) posY, (float) cellWidth, (float) cellHeight};
-            cell->outerRec = outerRec;
-            DrawRectangleRec(cell->outerRec, borderColor);
-
-            // Draw inner rectangle
-            unsigned int cellInnerWidth = cellWidth - cell->border * 2;
-            unsigned int cellInnerHeight = cellHeight - cell->border * 2;
-            int innerPosX = posX + cell->border;
-            int innerPosY = posY + cell->border;
-            struct Rectangle innerRec = {(float) innerPosX, (float) innerPosY, cellInnerWidth, cellInnerHeight};
-            cell->innerRec = innerRec;
-            DrawRectangleRec(cell->innerRec, cellFill);
+            struct Rectangle matchRec = {(float) match.col, (float) match.row, (float) match.cols, (float) match.rows};
+            DrawRectangleLinesEx(matchRec, (float) borderThickness/camera.zoom, RED);
         }
+        EndMode2D();
+        EndScissorMode();
     }
+
+    DrawCircle((int) (box.x + box.width/2), (int) (box.y + box.height/2), 10.0, RED);
+    Vector2 gridPos = GetWorldToScreen2D((Vector2){0.0f, 0.0f}, camera);
+    DrawCircle((int) gridPos.x, (int) gridPos.y, 10.0, BLUE);
 }
 
 // Gameplay Screen Unload logic
@@ -438,16 +1228,69 @@ void UnloadGameplayScreen(void)
 
     // Pause the game when screen is unloaded
     isPlaying = 0;
+    if (recording != NULL)
+    {
+        ToggleRecording();
+    }
+    if (trace != NULL)
+    {
+        ToggleTrace();
+    }
+    if (share != NULL)
+    {
+        ToggleShare();
+    }
+    if (server != NULL)
+    {
+        ToggleServer();
+    }
+    if (journal != NULL)
+    {
+        ToggleJournal();
+    }
 
     TraceLog(LOG_DEBUG, "Freeing Cells of Life memory");
-    int row, col;
-    for (row = 0; row < rows; row++)
+    UnloadUniverse(universe);
+    universe = NULL;
+    UnloadLifePyramid(pyramid);
+    pyramid = (LifePyramid){ 0 };
+    UnloadLifeAges(ages);
+    ages = (LifeAges){ 0 };
+    UnloadLifeObjects(objects);
+    objects = NULL;
+    if (gliderSearch != NULL)
     {
-        for (col = 0; col < cols; col++)
-        {
-            free(GridOfLife[row][col]);
-        }
+        ToggleGliderSearch();
+    }
+    UnloadLifeClip(clipboard);
+    clipboard = (LifeClip){ 0 };
+    hasSelection = false;
+    selecting = false;
+
+    UnloadTexture(gridTexture);
+    gridTexture = (Texture2D){ 0 };
+    free(cellPixels);
+    cellPixels = NULL;
+    textureWidth = 0;
+    textureHeight = 0;
+    if (gridTarget.id > 0)
+    {
+        UnloadRenderTexture(gridTarget);
     }
+    gridTarget = (RenderTexture2D){ 0 };
+    gridTargetValid = false;
+}
+
+// Simulation is stopped, frames only change on input
+bool IsGameplayScreenPaused(void)
+{
+    return isPlaying == 0;
+}
+
+// Something changed since the last drawn frame
+bool IsGameplayScreenDirty(void)
+{
+    return (isPlaying == 1) || inputActive || IsWindowResized() || (drawnVersion != gridVersion);
 }
 
 // Gameplay Screen should finish?
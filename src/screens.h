@@ -80,6 +80,8 @@ void UpdateGameplayScreen(void);
 void DrawGameplayScreen(void);
 void UnloadGameplayScreen(void);
 int FinishGameplayScreen(void);
+bool IsGameplayScreenPaused(void);
+bool IsGameplayScreenDirty(void);
 void DrawGameGrid(void);
 
 //----------------------------------------------------------------------------------
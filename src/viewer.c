@@ -0,0 +1,134 @@
+/*******************************************************************************************
+*
+*   cgameoflife viewer - Reference client for the generation stream server
+*
+*   Connects to a running game streaming its generations (N in the gameplay screen) and
+*   follows the stream, printing progress once per second.
+*
+*   Usage: viewer [address] [--delay ms] [--count messages] [--ascii]
+*
+*       address     "unix:/tmp/cgameoflife.sock" (default) or "tcp:host:port"
+*       --delay     Wait between messages, simulates a slow viewer that skips ahead
+*       --count     Stop after this many messages
+*       --ascii     Print the top left corner of the grid after every message
+*
+********************************************************************************************/
+
+#include "life.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+static int64_t CountPopulation(LifeGrid grid);
+static void PrintCorner(LifeGrid grid, int rows, int cols);
+
+//----------------------------------------------------------------------------------
+// Program main entry point
+//----------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    const char *address = "unix:/tmp/cgameoflife.sock";
+    int delay = 0;
+    long count = -1;
+    bool ascii = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--delay") == 0) && (i + 1 < argc)) delay = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--count") == 0) && (i + 1 < argc)) count = atol(argv[++i]);
+        else if (strcmp(argv[i], "--ascii") == 0) ascii = true;
+        else if (argv[i][0] != '-') address = argv[i];
+        else
+        {
+            fprintf(stderr, "usage: %s [address] [--delay ms] [--count messages] [--ascii]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    LifeClient *client = OpenLifeClient(address);
+    if (client == NULL)
+    {
+        fprintf(stderr, "viewer: unable to connect to %s\n", address);
+        return 1;
+    }
+
+    StreamInfo info = GetLifeClientInfo(client);
+    LifeGrid grid = LoadLifeGrid(info.rows, info.cols, TOPOLOGY_DEAD_EDGE);
+    if (grid.cells == NULL)
+    {
+        fprintf(stderr, "viewer: unable to allocate a %dx%d grid\n", info.rows, info.cols);
+        CloseLifeClient(client);
+        return 1;
+    }
+    printf("viewer: connected to %s, %dx%d cells\n", address, info.rows, info.cols);
+
+    double start = GetLifeSeconds();
+    double lastReport = start;
+    long received = 0;
+    bool streaming = true;
+    while (streaming && ((count < 0) || (received < count)))
+    {
+        streaming = ReceiveLifeClient(client, &grid);
+        if (!streaming) break;
+        received++;
+
+        if (ascii) PrintCorner(grid, 24, 72);
+        if (delay > 0)
+        {
+            struct timespec wait = { delay/1000, (long)(delay%1000)*1000000L };
+            nanosleep(&wait, NULL);
+        }
+
+        double now = GetLifeSeconds();
+        if (now - lastReport >= 1.0)
+        {
+            info = GetLifeClientInfo(client);
+            printf("generation %d  population %lld  keyframes %d  deltas %d  %.1f KiB/s\n", info.generation,
+                (long long)CountPopulation(grid), info.keyframes, info.deltas, info.bytes/1024.0/(now - start));
+            fflush(stdout);
+            lastReport = now;
+        }
+    }
+
+    info = GetLifeClientInfo(client);
+    printf("viewer: %s at generation %d, %d keyframes, %d deltas, %lld bytes\n", streaming? "done" : "stream closed",
+        info.generation, info.keyframes, info.deltas, (long long)info.bytes);
+
+    UnloadLifeGrid(grid);
+    CloseLifeClient(client);
+
+    return 0;
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+static int64_t CountPopulation(LifeGrid grid)
+{
+    int64_t population = 0;
+    uint8_t *states = malloc((size_t)grid.rows*grid.cols);
+    if (states == NULL) return -1;
+
+    GetLifeStates(grid, states);
+    for (size_t i = 0; i < (size_t)grid.rows*grid.cols; i++) population += states[i];
+    free(states);
+    return population;
+}
+
+static void PrintCorner(LifeGrid grid, int rows, int cols)
+{
+    for (int row = 0; (row < rows) && (row < grid.rows); row++)
+    {
+        char line[256];
+        int col = 0;
+        for (; (col < cols) && (col < grid.cols) && (col < (int)sizeof(line) - 1); col++) line[col] = GetLifeCell(grid, row, col)? '#' : '.';
+        line[col] = '\0';
+        puts(line);
+    }
+    putchar('\n');
+}